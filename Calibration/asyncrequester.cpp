@@ -0,0 +1,97 @@
+#include "asyncrequester.h"
+#include <zmq.h>
+#include <QtDebug>
+#include <cerrno>
+#include <cassert>
+#include "protocol.h"
+#include "tracing.h"
+
+AsyncRequester::AsyncRequester(void* context, const QString& requestAddr, const SocketTuning& tuning, QObject *parent)
+	: QObject(parent)
+{
+	m_socket = zmq_socket(context, ZMQ_REQ);
+	tuning.apply(m_socket);
+	//a timed out request is resent without waiting for its reply,a late reply to it is dropped
+	int on = 1;
+	zmq_setsockopt(m_socket, ZMQ_REQ_RELAXED, &on, sizeof(on));
+	zmq_setsockopt(m_socket, ZMQ_REQ_CORRELATE, &on, sizeof(on));
+	auto rc = zmq_connect(m_socket, requestAddr.toLocal8Bit().constData());
+	assert(!rc);
+
+#ifdef _WIN32
+	SOCKET fd = 0;
+#else
+	int fd = 0;
+#endif
+	size_t fdSize = sizeof(fd);
+	zmq_getsockopt(m_socket, ZMQ_FD, &fd, &fdSize);
+	m_notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+	connect(m_notifier, &QSocketNotifier::activated, this, &AsyncRequester::onSocketActivated);
+}
+
+AsyncRequester::~AsyncRequester()
+{
+	close();
+}
+
+void AsyncRequester::close()
+{
+	if (!m_socket)
+		return;
+	delete m_notifier;
+	m_notifier = nullptr;
+	zmq_close(m_socket);
+	m_socket = nullptr;
+	m_pending = false;
+}
+
+int AsyncRequester::send(const QString& cmd, const QByteArray& data)
+{
+	if (!m_socket)
+		return ENOTSOCK;
+	auto envelop = ("v1.0/" + cmd).toLocal8Bit();
+	if (zmq_send(m_socket, envelop.constData(), envelop.size(), ZMQ_DONTWAIT | (data.isEmpty() ? 0 : ZMQ_SNDMORE)) < 0){
+		auto error = zmq_errno();
+		qWarning() << "Send envelop error! cmd:" << cmd << zmq_strerror(error);
+		return error;
+	}
+	if (!data.isEmpty() && zmq_send(m_socket, data.constData(), data.size(), ZMQ_DONTWAIT) < 0){
+		auto error = zmq_errno();
+		qWarning() << "Send data error! cmd:" << cmd << zmq_strerror(error);
+		return error;
+	}
+	m_pending = true;
+	//ZMQ_FD is edge triggered,events that arrived while sending would not wake the notifier
+	QMetaObject::invokeMethod(this, "onSocketActivated", Qt::QueuedConnection);
+	return 0;
+}
+
+void AsyncRequester::onSocketActivated()
+{
+	if (!m_socket)
+		return;
+	TRACE_SCOPE("asyncReply");
+	m_notifier->setEnabled(false);
+	for (;;){
+		int events = 0;
+		size_t eventsSize = sizeof(events);
+		if (zmq_getsockopt(m_socket, ZMQ_EVENTS, &events, &eventsSize) != 0 || !(events & ZMQ_POLLIN))
+			break;
+		char buf[MAX_DATA_LENGTH * 2];
+		int nbytes = zmq_recv(m_socket, buf, sizeof(buf), ZMQ_DONTWAIT);
+		if (nbytes < 0)
+			break;
+		int more = 0;
+		size_t moreSize = sizeof(more);
+		while (zmq_getsockopt(m_socket, ZMQ_RCVMORE, &more, &moreSize) == 0 && more){
+			char discard[16];
+			zmq_recv(m_socket, discard, sizeof(discard), 0);
+		}
+		m_pending = false;
+		emit replied(QByteArray(buf, qMin<int>(nbytes, sizeof(buf))));
+		//a slot may have closed us
+		if (!m_socket)
+			return;
+	}
+	m_notifier->setEnabled(true);
+}
@@ -0,0 +1,48 @@
+#ifndef ASYNC_REQUESTER_H
+#define ASYNC_REQUESTER_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QSocketNotifier>
+#include "sockettuning.h"
+/*
+Non-blocking SDK requests on a dedicated REQ socket.
+send returns at once,the reply is read when the socket becomes readable and emitted as replied.
+A new request may be sent while one is outstanding,the late reply to the old one is dropped.
+*/
+class AsyncRequester : public QObject
+{
+	Q_OBJECT
+public:
+	/*
+	context:ZMQ context of the device,requestAddr:SDK REQ endpoint
+	*/
+	AsyncRequester(void* context, const QString& requestAddr, const SocketTuning& tuning = SocketTuning(),
+		QObject *parent = nullptr);
+	~AsyncRequester();
+
+	/*
+	cmd:envelope without the version prefix,e.g. cali/enter
+	Returns 0 or the zmq errno,EAGAIN while the SDK is not connected
+	*/
+	int send(const QString& cmd, const QByteArray& data = QByteArray());
+	bool isPending() const { return m_pending; }
+	/*
+	Close the socket,called before the context terminates
+	*/
+	void close();
+signals:
+	/*
+	reply:first reply frame of the newest request
+	*/
+	void replied(QByteArray reply);
+private slots:
+	void onSocketActivated();
+private:
+	void* m_socket = nullptr;
+	QSocketNotifier* m_notifier = nullptr;
+	bool m_pending = false;
+};
+
+#endif // ASYNC_REQUESTER_H
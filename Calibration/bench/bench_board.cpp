@@ -0,0 +1,90 @@
+#include <QtDebug>
+#include <cmath>
+#include <vector>
+#include "benchmark.h"
+#include "boarddetector.h"
+/*
+Board search in a 1280x1024 gray frame showing an 11x9 circle grid,rotated and tilted:
+labelling on one thread,labelling tiled over the cores,and the grid fit alone.
+Both cameras at 30 fps leave 33 ms per frame pair.
+*/
+namespace
+{
+	const int WIDTH = FRAME_WIDTH;
+	const int HEIGHT = FRAME_HEIGHT;
+	const int COLS = 11;
+	const int ROWS = 9;
+	const int FRAMES = 50;
+
+	//light circles on a dark background with a gradient,drawn through a perspective map
+	std::vector<unsigned char> testFrame()
+	{
+		auto frame = syntheticFrame(WIDTH, HEIGHT, [](int x, int y){ return 50 + ((x * 7 + y * 13) % 9) + x / 64; });
+		const double spacing = 70, angle = 0.3, tilt = 0.3;
+		const double ca = std::cos(angle), sa = std::sin(angle);
+		for (int gy = 0; gy < ROWS; gy++){
+			for (int gx = 0; gx < COLS; gx++){
+				const double bx = (gx - (COLS - 1) / 2.0) * spacing, by = (gy - (ROWS - 1) / 2.0) * spacing;
+				const double w = 1 + tilt * bx / 1000;
+				const double px = (ca * bx - sa * by) / w + WIDTH / 2, py = (sa * bx + ca * by) / w + HEIGHT / 2;
+				const double radius = spacing * 0.3 / w;
+				for (int y = int(py - radius - 1); y <= int(py + radius + 1); y++){
+					for (int x = int(px - radius - 1); x <= int(px + radius + 1); x++){
+						if ((x - px) * (x - px) + (y - py) * (y - py) <= radius * radius)
+							frame[size_t(y) * WIDTH + x] = 230;
+					}
+				}
+			}
+		}
+		return frame;
+	}
+
+	BoardSpec spec()
+	{
+		BoardSpec board;
+		board.cols = COLS;
+		board.rows = ROWS;
+		return board;
+	}
+
+	void detect(BenchState& state, int threads)
+	{
+		WorkerPool pool(threads);
+		const auto frame = testFrame();
+		const auto board = spec();
+		int found = 0;
+		state.start();
+		for (int i = 0; i < FRAMES; i++)
+			found += detectBoard(frame.data(), WIDTH, HEIGHT, 1, board, &pool).found;
+		state.stop(FRAMES);
+		if (found != FRAMES)
+			qWarning() << "board not found in the test frame";
+	}
+
+	void singlePath(BenchState& state)
+	{
+		detect(state, 1);
+	}
+
+	void tiledPath(BenchState& state)
+	{
+		detect(state, analysisThreads());
+	}
+
+	void fitPath(BenchState& state)
+	{
+		const auto frame = testFrame();
+		const auto board = spec();
+		const auto blobs = findBlobs(frame.data(), WIDTH, HEIGHT, 1, BlobParams());
+		int found = 0;
+		state.start();
+		for (int i = 0; i < FRAMES; i++)
+			found += fitBoard(blobs, board).found;
+		state.stop(FRAMES);
+		Q_UNUSED(found);
+	}
+}
+
+BENCHMARK("board/detect_1280x1024", singlePath);
+BENCHMARK("board/detect_tiled_1280x1024", tiledPath);
+BENCHMARK("board/fit_11x9", fitPath);
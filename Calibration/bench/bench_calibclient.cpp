@@ -0,0 +1,73 @@
+#include <thread>
+#include <vector>
+#include <zmq.h>
+#include "benchmark.h"
+#include "calibclient.h"
+/*
+SDK requests against a REP server on loopback tcp answering like the SDK:
+one REQ round trip per request against the same requests pipelined as a batch on a DEALER socket.
+*/
+namespace
+{
+	const int REQUESTS = 2000;
+
+	//answers count requests with a native int 1
+	void serve(void* socket, int count)
+	{
+		const int one = 1;
+		zmq_msg_t message;
+		zmq_msg_init(&message);
+		for (int i = 0; i < count; i++){
+			do{
+				zmq_msg_recv(&message, socket, 0);
+			} while (zmq_msg_more(&message));
+			zmq_send(socket, &one, sizeof(one), 0);
+		}
+		zmq_msg_close(&message);
+	}
+
+	void run(BenchState& state, bool pipelined)
+	{
+		void* context = zmq_ctx_new();
+		void* server = zmq_socket(context, ZMQ_REP);
+		zmq_bind(server, "tcp://127.0.0.1:*");
+		char endpoint[256] = { 0 };
+		size_t endpointSize = sizeof(endpoint);
+		zmq_getsockopt(server, ZMQ_LAST_ENDPOINT, endpoint, &endpointSize);
+		std::thread sdk(serve, server, REQUESTS);
+
+		CalibClient client;
+		client.connect(context, endpoint, pipelined);
+		std::vector<int> dists(REQUESTS);
+		state.start();
+		if (pipelined){
+			CalibBatch batch;
+			for (auto& dist : dists)
+				batch.caliCurrentDist(&dist);
+			client.run(batch);
+		}
+		else{
+			for (auto& dist : dists)
+				client.caliCurrentDist(&dist);
+		}
+		state.stop(REQUESTS);
+
+		sdk.join();
+		client.close();
+		zmq_close(server);
+		zmq_ctx_term(context);
+	}
+
+	void lockstepPath(BenchState& state)
+	{
+		run(state, false);
+	}
+
+	void pipelinedPath(BenchState& state)
+	{
+		run(state, true);
+	}
+}
+
+BENCHMARK("calibclient/lockstep_tcp", lockstepPath);
+BENCHMARK("calibclient/pipelined_tcp", pipelinedPath);
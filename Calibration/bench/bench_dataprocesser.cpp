@@ -0,0 +1,95 @@
+#include <QDir>
+#include <QSharedMemory>
+#include <cstring>
+#include "benchmark.h"
+#include "dataprocesser.h"
+/*
+DataProcesser::processNotification on synthetic notifications of a shared memory segment made here,
+as the SDK would send them:a point cloud(parse,attach,emit),a frame of a camera that is not shown
+(parse and attach only),a gray 1280x1024 frame(conversion,exposure and focus score included)
+and the same gray frame repeated(the change detector skips it).
+*/
+namespace
+{
+	const int WIDTH = FRAME_WIDTH;
+	const int HEIGHT = FRAME_HEIGHT;
+	const int CLOUD_ROUNDS = 2000;
+	const int FRAMES = 20;
+
+	QString segmentKey()
+	{
+#ifdef Q_OS_WIN
+		return QStringLiteral("calib_bench_frames");
+#else
+		//ftok needs an existing file,QSharedMemory creates it
+		return QDir::temp().filePath(QStringLiteral("calib_bench_frames"));
+#endif
+	}
+
+	struct Segment
+	{
+		QSharedMemory shm;
+		bool ok = false;
+
+		Segment()
+		{
+			shm.setNativeKey(segmentKey());
+			ok = shm.create(WIDTH * HEIGHT) || (shm.error() == QSharedMemory::AlreadyExists && shm.attach());
+			if (ok){
+				const auto frame = rampFrame();
+				memcpy(shm.data(), frame.data(), frame.size());
+			}
+		}
+	};
+
+	QByteArray notification(const char* type, const char* name, const QByteArray& props)
+	{
+		return QByteArray("{\"key\":\"") + segmentKey().toUtf8() + "\",\"name\":\"" + name + "\",\"offset\":0,\"props\":"
+			+ props + ",\"type\":\"" + type + "\"}";
+	}
+
+	//tolerance:of the change detector,negative converts every frame
+	void run(BenchState& state, const QByteArray& text, int rounds, int tolerance = -1)
+	{
+		Segment segment;
+		if (!segment.ok){
+			qWarning("cannot create the benchmark shared memory");
+			return;
+		}
+		DataProcesser processer(nullptr, nullptr);
+		processer.setDeviceName(QStringLiteral("bench"));
+		processer.setChangeTolerance(tolerance);
+		int handled = 0;
+		state.start();
+		for (int i = 0; i < rounds; i++)
+			handled += processer.processNotification(text.constData(), text.size());
+		state.stop(rounds);
+		Q_UNUSED(handled);
+	}
+
+	void pointCloud(BenchState& state)
+	{
+		run(state, notification("MT_POINT_CLOUD", "", "{\"count\":182334,\"hasColor\":true,\"hasNormal\":true}"), CLOUD_ROUNDS);
+	}
+
+	void otherCamera(BenchState& state)
+	{
+		run(state, notification("MT_VIDEO_DATA", "cam2", "{\"channel\":1,\"height\":1024,\"rotate\":90,\"width\":1280}"), CLOUD_ROUNDS);
+	}
+
+	void grayFrame(BenchState& state)
+	{
+		run(state, notification("MT_VIDEO_DATA", "cam0", "{\"channel\":1,\"height\":1024,\"rotate\":90,\"width\":1280}"), FRAMES);
+	}
+
+	//the same frame again,as the SDK sends between snaps:compared,not converted
+	void unchangedFrame(BenchState& state)
+	{
+		run(state, notification("MT_VIDEO_DATA", "cam0", "{\"channel\":1,\"height\":1024,\"rotate\":90,\"width\":1280}"), CLOUD_ROUNDS, 3);
+	}
+}
+
+BENCHMARK("dataprocesser/dispatch_point_cloud", pointCloud);
+BENCHMARK("dataprocesser/dispatch_other_camera", otherCamera);
+BENCHMARK("dataprocesser/video_gray_1280x1024", grayFrame);
+BENCHMARK("dataprocesser/video_gray_unchanged", unchangedFrame);
@@ -0,0 +1,57 @@
+#include <vector>
+#include "benchmark.h"
+#include "exposure.h"
+/*
+Exposure histogram of one 1280x1024 gray frame:one bank byte by byte,the banked 16 byte kernel,
+and the banked kernel on row bands with per-thread partials.
+The frame is a dim gradient with a saturated spot,long runs of equal pixels are the worst case for one bank.
+*/
+namespace
+{
+	const int WIDTH = FRAME_WIDTH;
+	const int HEIGHT = FRAME_HEIGHT;
+	const int FRAMES = 200;
+
+	std::vector<unsigned char> testFrame()
+	{
+		return syntheticFrame(WIDTH, HEIGHT, [](int x, int y){
+			const int dx = x - WIDTH / 2, dy = y - HEIGHT / 2;
+			return dx * dx + dy * dy < 150 * 150 ? 255 : 40 + x / 16;
+		});
+	}
+
+	void scalarPath(BenchState& state)
+	{
+		const auto frame = testFrame();
+		ExposureHistogram histogram;
+		state.start();
+		for (int i = 0; i < FRAMES; i++)
+			histogram.accumulateScalar(frame.data(), frame.size());
+		state.stop(FRAMES);
+	}
+
+	void bankedPath(BenchState& state)
+	{
+		const auto frame = testFrame();
+		ExposureHistogram histogram;
+		state.start();
+		for (int i = 0; i < FRAMES; i++)
+			histogram.accumulate(frame.data(), WIDTH, HEIGHT, 1);
+		state.stop(FRAMES);
+	}
+
+	void parallelPath(BenchState& state)
+	{
+		const auto frame = testFrame();
+		WorkerPool pool(analysisThreads());
+		ExposureHistogram histogram;
+		state.start();
+		for (int i = 0; i < FRAMES; i++)
+			histogram.accumulateParallel(frame.data(), WIDTH, HEIGHT, 1, &pool);
+		state.stop(FRAMES);
+	}
+}
+
+BENCHMARK("exposure/scalar_1280x1024", scalarPath);
+BENCHMARK("exposure/banked_1280x1024", bankedPath);
+BENCHMARK("exposure/parallel_1280x1024", parallelPath);
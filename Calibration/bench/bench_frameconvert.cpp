@@ -0,0 +1,82 @@
+#include <QPainter>
+#include <vector>
+#include "benchmark.h"
+#include "frameconvert.h"
+/*
+Conversion of one 1280x1024 camera frame(the scanner's size,not mirrored) to the image the GUI shows,
+gray and color,at every rotation the SDK sends.Both cameras at 30 fps leave 16 ms per frame.
+The paint cases draw a converted frame 1:1 into an RGB32 image the way VideoWidget draws into its backing store,
+gray frames are expanded to RGB only there.
+The format cases convert every PixelFormat of the props with FrameConverter,on this thread and on as many threads
+as DataProcesser gives it;16-bit frames are windowed over the middle of their range.
+*/
+namespace
+{
+	const int WIDTH = FRAME_WIDTH;
+	const int HEIGHT = FRAME_HEIGHT;
+	const int FRAMES = 20;
+
+	void convert(BenchState& state, int channel, int rotate)
+	{
+		const auto frame = rampFrame(channel);
+		qint64 pixels = 0;
+		state.start();
+		for (int i = 0; i < FRAMES; i++)
+			pixels += convertFrame(frame.data(), WIDTH, HEIGHT, channel, rotate).width();
+		state.stop(FRAMES);
+		Q_UNUSED(pixels);
+	}
+
+	void convertFormat(BenchState& state, PixelFormat format, bool parallel)
+	{
+		//two bytes per pixel for the 16-bit formats,levels spread over their bits
+		const int bits = pixelFormatBits(format);
+		auto frame = rampFrame(pixelFormatBytes(format));
+		for (size_t i = 1; bits > 8 && i < frame.size(); i += 2)
+			frame[i] &= (1 << (bits - 8)) - 1;
+		WorkerPool pool(parallel ? analysisThreads() : 1);
+		FrameConverter converter(&pool);
+		const int range = 1 << bits;
+		const int windowLow = bits > 8 ? range / 4 : 0, windowHigh = bits > 8 ? range * 3 / 4 : 0;
+		qint64 pixels = 0;
+		state.start();
+		for (int i = 0; i < FRAMES; i++)
+			pixels += converter.convert(frame.data(), WIDTH, HEIGHT, format, 0, windowLow, windowHigh).width();
+		state.stop(FRAMES);
+		Q_UNUSED(pixels);
+	}
+
+	void paint(BenchState& state, int channel)
+	{
+		const auto frame = rampFrame(channel);
+		const auto image = convertFrame(frame.data(), WIDTH, HEIGHT, channel, 0);
+		QImage target(WIDTH, HEIGHT, QImage::Format_RGB32);
+		state.start();
+		for (int i = 0; i < FRAMES; i++){
+			QPainter painter(&target);
+			painter.drawImage(0, 0, image);
+		}
+		state.stop(FRAMES);
+	}
+}
+
+BENCHMARK("frameconvert/gray_rotate0", [](BenchState& state){ convert(state, 1, 0); });
+BENCHMARK("frameconvert/gray_rotate90", [](BenchState& state){ convert(state, 1, 90); });
+BENCHMARK("frameconvert/gray_rotate180", [](BenchState& state){ convert(state, 1, 180); });
+BENCHMARK("frameconvert/gray_rotate270", [](BenchState& state){ convert(state, 1, 270); });
+BENCHMARK("frameconvert/rgb_rotate0", [](BenchState& state){ convert(state, 3, 0); });
+BENCHMARK("frameconvert/rgb_rotate90", [](BenchState& state){ convert(state, 3, 90); });
+BENCHMARK("frameconvert/rgb_rotate180", [](BenchState& state){ convert(state, 3, 180); });
+BENCHMARK("frameconvert/rgb_rotate270", [](BenchState& state){ convert(state, 3, 270); });
+BENCHMARK("frameconvert/paint_gray", [](BenchState& state){ paint(state, 1); });
+BENCHMARK("frameconvert/paint_rgb", [](BenchState& state){ paint(state, 3); });
+BENCHMARK("frameconvert/format_mono8", [](BenchState& state){ convertFormat(state, PF_MONO8, false); });
+BENCHMARK("frameconvert/format_rgb8", [](BenchState& state){ convertFormat(state, PF_RGB8, false); });
+BENCHMARK("frameconvert/format_bayer_rg8", [](BenchState& state){ convertFormat(state, PF_BAYER_RG8, false); });
+BENCHMARK("frameconvert/format_bayer_rg8_parallel", [](BenchState& state){ convertFormat(state, PF_BAYER_RG8, true); });
+BENCHMARK("frameconvert/format_bayer_gb8", [](BenchState& state){ convertFormat(state, PF_BAYER_GB8, false); });
+BENCHMARK("frameconvert/format_mono10", [](BenchState& state){ convertFormat(state, PF_MONO10, false); });
+BENCHMARK("frameconvert/format_mono12", [](BenchState& state){ convertFormat(state, PF_MONO12, false); });
+BENCHMARK("frameconvert/format_mono12_parallel", [](BenchState& state){ convertFormat(state, PF_MONO12, true); });
+BENCHMARK("frameconvert/format_mono16", [](BenchState& state){ convertFormat(state, PF_MONO16, false); });
+BENCHMARK("frameconvert/format_mono16_parallel", [](BenchState& state){ convertFormat(state, PF_MONO16, true); });
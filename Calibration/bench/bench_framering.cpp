@@ -0,0 +1,94 @@
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <cstring>
+#include <zmq.h>
+#include "benchmark.h"
+#include "framering.h"
+/*
+Producer -> consumer hand-off of one 1280x1024 gray frame:the shm seqlock ring against the
+REQ/REP notification the data processer receives today,both paths copy the frame once.
+Items are frames that reached the consumer,the cost per item is the hand-off latency.
+*/
+namespace
+{
+	const int FRAMES = 2000;
+	const uint32_t WIDTH = 1280;
+	const uint32_t HEIGHT = 1024;
+
+#ifdef __linux__
+	void frameRingPath(BenchState& state)
+	{
+		FrameRingWriter writer;
+		FrameRingReader reader;
+		if (!writer.create("/calib-bench.cam0", 4, WIDTH * HEIGHT) || !reader.open("/calib-bench.cam0"))
+			return;
+		std::vector<unsigned char> frame(WIDTH * HEIGHT, 0x40);
+		std::vector<unsigned char> copy(WIDTH * HEIGHT);
+		std::atomic<int> consumed(0);
+
+		state.start();
+		std::thread consumer([&]{
+			while (consumed.load(std::memory_order_relaxed) < FRAMES){
+				auto result = reader.readLatest([&](const FrameInfo& info, const unsigned char* data){
+					memcpy(copy.data(), data, info.bytes);
+				});
+				if (result == FR_OK)
+					consumed.fetch_add(1, std::memory_order_release);
+			}
+		});
+		FrameInfo info;
+		info.width = WIDTH;
+		info.height = HEIGHT;
+		info.channel = 1;
+		info.bytes = WIDTH * HEIGHT;
+		//ping-pong,the next frame goes out once the previous one was read
+		for (int i = 0; i < FRAMES; i++){
+			info.frameNumber = i;
+			writer.write(info, frame.data());
+			while (consumed.load(std::memory_order_acquire) <= i)
+				std::this_thread::yield();
+		}
+		consumer.join();
+		state.stop(FRAMES);
+	}
+
+	BENCHMARK("framering/handoff_1280x1024", frameRingPath);
+#endif
+
+	void zmqNotifyPath(BenchState& state)
+	{
+		void* context = zmq_ctx_new();
+		void* rep = zmq_socket(context, ZMQ_REP);
+		void* req = zmq_socket(context, ZMQ_REQ);
+		zmq_bind(rep, "inproc://calib-bench-frames");
+		zmq_connect(req, "inproc://calib-bench-frames");
+		std::vector<unsigned char> frame(WIDTH * HEIGHT, 0x40);
+		std::vector<unsigned char> copy(WIDTH * HEIGHT);
+
+		state.start();
+		std::thread consumer([&]{
+			for (int i = 0; i < FRAMES; i++){
+				zmq_msg_t message;
+				zmq_msg_init(&message);
+				zmq_msg_recv(&message, rep, 0);
+				memcpy(copy.data(), zmq_msg_data(&message), zmq_msg_size(&message));
+				zmq_msg_close(&message);
+				zmq_send(rep, "1", 1, 0);
+			}
+		});
+		char ack[4];
+		for (int i = 0; i < FRAMES; i++){
+			zmq_send(req, frame.data(), frame.size(), 0);
+			zmq_recv(req, ack, sizeof(ack), 0);
+		}
+		consumer.join();
+		state.stop(FRAMES);
+
+		zmq_close(req);
+		zmq_close(rep);
+		zmq_ctx_destroy(context);
+	}
+}
+
+BENCHMARK("framering/zmq_notify_1280x1024", zmqNotifyPath);
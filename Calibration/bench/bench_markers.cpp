@@ -0,0 +1,135 @@
+#include <QtDebug>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "benchmark.h"
+#include "markers.h"
+/*
+Marker extraction from a 1280x1024 gray frame with 396 anti-aliased markers of 3 to 8 px radius
+at known sub-pixel centers:on one thread,tiled over the cores,and the refinement alone.
+The first case also logs the centroid error against the ground truth.
+*/
+namespace
+{
+	const int WIDTH = FRAME_WIDTH;
+	const int HEIGHT = FRAME_HEIGHT;
+	const int FRAMES = 50;
+	//samples per pixel side when a marker edge is drawn
+	const int SUPERSAMPLE = 4;
+
+	struct TestMarker
+	{
+		double x;
+		double y;
+		double radius;
+	};
+
+	struct TestFrame
+	{
+		std::vector<unsigned char> pixels;
+		std::vector<TestMarker> truth;
+	};
+
+	TestFrame testFrame()
+	{
+		TestFrame frame;
+		std::mt19937 random(7);
+		std::uniform_real_distribution<double> unit(0, 1);
+		frame.pixels = syntheticFrame(WIDTH, HEIGHT, [&random](int, int){ return 20 + random() % 6; });
+		for (int gy = 0; gy < 18; gy++){
+			for (int gx = 0; gx < 22; gx++){
+				TestMarker marker = { 40 + gx * 55 + unit(random) * 10, 40 + gy * 55 + unit(random) * 10, 3 + unit(random) * 5 };
+				frame.truth.push_back(marker);
+				for (int y = int(marker.y - marker.radius - 2); y <= int(marker.y + marker.radius + 2); y++){
+					for (int x = int(marker.x - marker.radius - 2); x <= int(marker.x + marker.radius + 2); x++){
+						int inside = 0;
+						for (int sy = 0; sy < SUPERSAMPLE; sy++){
+							for (int sx = 0; sx < SUPERSAMPLE; sx++){
+								const double px = x + (sx + 0.5) / SUPERSAMPLE - 0.5, py = y + (sy + 0.5) / SUPERSAMPLE - 0.5;
+								inside += (px - marker.x) * (px - marker.x) + (py - marker.y) * (py - marker.y) <= marker.radius * marker.radius;
+							}
+						}
+						auto& pixel = frame.pixels[size_t(y) * WIDTH + x];
+						pixel = (unsigned char)std::min(255, pixel + inside * 200 / (SUPERSAMPLE * SUPERSAMPLE));
+					}
+				}
+			}
+		}
+		return frame;
+	}
+
+	MarkerParams unbounded()
+	{
+		MarkerParams params;
+		params.budgetUs = 0;
+		return params;
+	}
+
+	void logAccuracy(const TestFrame& frame, const MarkerResult& result)
+	{
+		int matched = 0;
+		double sum = 0, worst = 0;
+		for (const auto& truth : frame.truth){
+			double best = 2;
+			for (const auto& marker : result.markers)
+				best = std::min(best, std::hypot(marker.x - truth.x, marker.y - truth.y));
+			if (best >= 2)
+				continue;
+			matched++;
+			sum += best;
+			worst = std::max(worst, best);
+		}
+		qInfo().noquote() << QString("markers: %1/%2 found, centroid error mean %3 px max %4 px")
+			.arg(matched).arg(frame.truth.size()).arg(matched ? sum / matched : 0, 0, 'f', 4).arg(worst, 0, 'f', 4);
+	}
+
+	void extract(BenchState& state, int threads, bool log)
+	{
+		WorkerPool pool(threads);
+		const auto frame = testFrame();
+		const auto params = unbounded();
+		MarkerResult result;
+		state.start();
+		for (int i = 0; i < FRAMES; i++)
+			result = findMarkers(frame.pixels.data(), WIDTH, HEIGHT, params, &pool);
+		state.stop(FRAMES);
+		if (log)
+			logAccuracy(frame, result);
+	}
+
+	void singlePath(BenchState& state)
+	{
+		extract(state, 1, true);
+	}
+
+	void tiledPath(BenchState& state)
+	{
+		extract(state, analysisThreads(), false);
+	}
+
+	void refinePath(BenchState& state)
+	{
+		const auto frame = testFrame();
+		const auto params = unbounded();
+		BlobParams blobParams;
+		blobParams.tileSize = params.tileSize;
+		blobParams.minContrast = params.minContrast;
+		blobParams.flatBackground = true;
+		blobParams.minArea = params.minArea;
+		blobParams.maxArea = params.maxArea;
+		const auto blobs = findBlobs(frame.pixels.data(), WIDTH, HEIGHT, 1, blobParams);
+		Marker marker;
+		int refined = 0;
+		state.start();
+		for (int i = 0; i < FRAMES; i++){
+			for (const auto& blob : blobs)
+				refined += refineMarker(frame.pixels.data(), WIDTH, HEIGHT, blob, params, marker);
+		}
+		state.stop(qint64(FRAMES) * blobs.size());
+		Q_UNUSED(refined);
+	}
+}
+
+BENCHMARK("markers/extract_1280x1024", singlePath);
+BENCHMARK("markers/extract_tiled_1280x1024", tiledPath);
+BENCHMARK("markers/refine_per_marker", refinePath);
@@ -0,0 +1,57 @@
+#include <QThread>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "benchmark.h"
+#include "metrics.h"
+/*
+Metric updates on the hot paths:one counter increment or histogram observation,
+from one thread and from several threads on the same metric.The target is under 50 ns per increment,
+contended increments stay close to it as long as every thread has its own shard.
+*/
+namespace
+{
+	const int UPDATES = 2000000;
+
+	int contendingThreads()
+	{
+		return qBound(2, QThread::idealThreadCount(), 8);
+	}
+
+	//threads update the same metric UPDATES times each,items are all updates
+	template <typename Update>
+	void run(BenchState& state, int threads, const Update& update)
+	{
+		std::vector<std::thread> workers;
+		state.start();
+		for (int t = 1; t < threads; t++){
+			workers.emplace_back([&update]{
+				for (int i = 0; i < UPDATES; i++)
+					update(i);
+			});
+		}
+		for (int i = 0; i < UPDATES; i++)
+			update(i);
+		for (auto& worker : workers)
+			worker.join();
+		state.stop(qint64(UPDATES) * threads);
+	}
+
+	void counterInc(BenchState& state, int threads)
+	{
+		std::unique_ptr<MetricCounter> counter(new MetricCounter);
+		run(state, threads, [&counter](int){ counter->inc(); });
+	}
+
+	void histogramObserve(BenchState& state, int threads)
+	{
+		std::unique_ptr<MetricHistogram> histogram(new MetricHistogram(MetricHistogram::latencyBounds()));
+		//spread over the buckets like frame and request latencies
+		run(state, threads, [&histogram](int i){ histogram->observe(qint64(i & 0xffff) * 1000); });
+	}
+}
+
+BENCHMARK("metrics/counter_inc", [](BenchState& state){ counterInc(state, 1); });
+BENCHMARK("metrics/counter_inc_contended", [](BenchState& state){ counterInc(state, contendingThreads()); });
+BENCHMARK("metrics/histogram_observe", [](BenchState& state){ histogramObserve(state, 1); });
+BENCHMARK("metrics/histogram_observe_contended", [](BenchState& state){ histogramObserve(state, contendingThreads()); });
@@ -0,0 +1,74 @@
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <vector>
+#include "benchmark.h"
+#include "notification.h"
+/*
+Reading the data processing notifications of a recorded session:the QJsonDocument path DataProcesser used,
+building its reply and the props text per message,against the in-situ reader with its arena and fixed reply.
+Two cameras at 30 fps are 60 notifications a second,the figure that matters is the cost per message on the frame path.
+*/
+namespace
+{
+	const int ROUNDS = 20000;
+
+	//as captured from the SDK,video of both cameras and the occasional point cloud
+	const std::vector<QByteArray>& recordedNotifications()
+	{
+		static const std::vector<QByteArray> notifications = {
+			"{\"key\":\"sn3d_scan_shm_video\",\"name\":\"cam0\",\"offset\":0,\"props\":{\"channel\":1,\"height\":1024,\"rotate\":90,\"width\":1280},\"type\":\"MT_VIDEO_DATA\"}",
+			"{\"key\":\"sn3d_scan_shm_video\",\"name\":\"cam1\",\"offset\":1310720,\"props\":{\"channel\":1,\"height\":1024,\"rotate\":270,\"width\":1280},\"type\":\"MT_VIDEO_DATA\"}",
+			"{\"key\":\"sn3d_scan_shm_video\",\"name\":\"cam0\",\"offset\":0,\"props\":{\"channel\":3,\"height\":1080,\"rotate\":0,\"width\":1920},\"type\":\"MT_VIDEO_DATA\"}",
+			"{\"key\":\"sn3d_scan_shm_cloud\",\"name\":\"\",\"offset\":4096,\"props\":{\"count\":182334,\"hasColor\":true,\"hasNormal\":true,\"frameId\":1187,\"transform\":[1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1]},\"type\":\"MT_POINT_CLOUD\"}"
+		};
+		return notifications;
+	}
+
+	void qtJson(BenchState& state)
+	{
+		const auto& notifications = recordedNotifications();
+		qint64 checksum = 0;
+		state.start();
+		for (int round = 0; round < ROUNDS; round++){
+			for (const auto& raw : notifications){
+				auto jsonObj = QJsonDocument::fromJson(raw).object();
+				auto type = jsonObj["type"].toString();
+				auto name = jsonObj["name"].toString();
+				auto props = jsonObj["props"].toObject();
+				checksum += jsonObj["offset"].toInt() + props["width"].toInt() + props["height"].toInt() + name.size();
+				QJsonDocument jsonDoc;
+				jsonDoc.setObject(props);
+				checksum += jsonDoc.toJson().size() + type.size();
+				QJsonObject backJsonObj{
+					{ QStringLiteral("handled"), true }
+				};
+				checksum += QJsonDocument(backJsonObj).toJson(QJsonDocument::Compact).size();
+			}
+		}
+		state.stop(qint64(ROUNDS) * notifications.size());
+		Q_UNUSED(checksum);
+	}
+
+	void inSitu(BenchState& state)
+	{
+		const auto& notifications = recordedNotifications();
+		JsonArena arena;
+		qint64 checksum = 0;
+		state.start();
+		for (int round = 0; round < ROUNDS; round++){
+			for (const auto& raw : notifications){
+				arena.reset();
+				Notification notification;
+				if (!parseNotification(raw.constData(), raw.size(), arena, &notification))
+					continue;
+				checksum += notification.offset + notification.width + notification.height + notification.name.size;
+				checksum += notification.props.size + notification.type.size;
+			}
+		}
+		state.stop(qint64(ROUNDS) * notifications.size());
+		Q_UNUSED(checksum);
+	}
+}
+
+BENCHMARK("notification/qjsondocument", qtJson);
+BENCHMARK("notification/in_situ", inSitu);
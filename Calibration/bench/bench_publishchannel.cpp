@@ -0,0 +1,60 @@
+#include <QEventLoop>
+#include <thread>
+#include "benchmark.h"
+#include "publishchannel.h"
+#include "subscriber.h"
+/*
+Subscriber thread -> GUI thread delivery:the lock-free PublishChannel against the
+queued publishReceived signal it replaced.Payload mirrors a cali/caliDistStates publish.
+*/
+namespace
+{
+	const int MESSAGES = 200000;
+	const QByteArray PAYLOAD("{\"states\":[true,true,false,false,false]}");
+
+	void publishChannelPath(BenchState& state)
+	{
+		PublishChannel channel(1024);
+		QEventLoop loop;
+		int received = 0;
+		QObject::connect(&channel, &PublishChannel::publishReceived, [&](QString, QString, QByteArray){
+			if (++received == MESSAGES)
+				loop.quit();
+		});
+
+		state.start();
+		std::thread producer([&]{
+			for (int i = 0; i < MESSAGES; i++){
+				PublishMessage message{ QStringLiteral("cali"), QStringLiteral("caliDistStates"), PAYLOAD };
+				channel.push(message);
+			}
+		});
+		loop.exec();
+		state.stop(MESSAGES);
+		producer.join();
+	}
+
+	void queuedSignalPath(BenchState& state)
+	{
+		Subscriber subscriber(nullptr, nullptr);
+		QObject receiver;
+		QEventLoop loop;
+		int received = 0;
+		QObject::connect(&subscriber, &Subscriber::publishReceived, &receiver, [&](QString, QString, QByteArray){
+			if (++received == MESSAGES)
+				loop.quit();
+		}, Qt::QueuedConnection);
+
+		state.start();
+		std::thread producer([&]{
+			for (int i = 0; i < MESSAGES; i++)
+				emit subscriber.publishReceived(QStringLiteral("cali"), QStringLiteral("caliDistStates"), QByteArray(PAYLOAD.constData()));
+		});
+		loop.exec();
+		state.stop(MESSAGES);
+		producer.join();
+	}
+}
+
+BENCHMARK("publish/spsc_channel", publishChannelPath);
+BENCHMARK("publish/queued_signal", queuedSignalPath);
@@ -0,0 +1,76 @@
+#include <QJsonObject>
+#include <vector>
+#include "benchmark.h"
+#include "mainwindow.h"
+#include "sdkmessage.h"
+/*
+Per message work of the GUI side of the protocol:splitting the envelop of every publish on the subscriber thread,
+the json helpers of MainWindow every request and async action goes through,and the caliDistStates payload
+that updates the distance indicators.
+*/
+namespace
+{
+	const int ROUNDS = 20000;
+
+	void envelopes(BenchState& state)
+	{
+		static const std::vector<QByteArray> recorded = {
+			"v1.0/hb",
+			"v1.0/device/event",
+			"v1.0/cali/caliDistStates",
+			"v1.0/cali/currentCaliDist",
+			"v1.0/finishAsyncAction"
+		};
+		QString majorCmd, minorCmd;
+		int accepted = 0;
+		state.start();
+		for (int round = 0; round < ROUNDS; round++){
+			for (const auto& envelop : recorded)
+				accepted += splitEnvelope(envelop.constData(), envelop.size(), "v1.0", &majorCmd, &minorCmd);
+		}
+		state.stop(qint64(ROUNDS) * recorded.size());
+		Q_UNUSED(accepted);
+	}
+
+	void jsonStr(BenchState& state)
+	{
+		const QJsonObject request{
+			{ QStringLiteral("type"), QStringLiteral("CT_STEREO") },
+			{ QStringLiteral("enabled"), true },
+			{ QStringLiteral("group"), 3 }
+		};
+		int bytes = 0;
+		state.start();
+		for (int round = 0; round < ROUNDS; round++)
+			bytes += MainWindow::jsonStr(request).size();
+		state.stop(ROUNDS);
+		Q_UNUSED(bytes);
+	}
+
+	void jsonObject(BenchState& state)
+	{
+		const QByteArray finished = "{\"type\":\"AAT_CALI_CHECK\",\"result\":\"AR_SUCCESS\",\"props\":{\"type\":\"CT_STEREO\",\"progress\":100}}";
+		int members = 0;
+		state.start();
+		for (int round = 0; round < ROUNDS; round++)
+			members += MainWindow::jsonObject(finished).size();
+		state.stop(ROUNDS);
+		Q_UNUSED(members);
+	}
+
+	void distStates(BenchState& state)
+	{
+		const QByteArray states = "{\"states\":[true,true,true,false,false,false,false]}";
+		int done = 0;
+		state.start();
+		for (int round = 0; round < ROUNDS; round++)
+			done += distanceStates(states).count(true);
+		state.stop(ROUNDS);
+		Q_UNUSED(done);
+	}
+}
+
+BENCHMARK("publish/split_envelope", envelopes);
+BENCHMARK("mainwindow/json_str", jsonStr);
+BENCHMARK("mainwindow/json_object", jsonObject);
+BENCHMARK("publish/cali_dist_states", distStates);
@@ -0,0 +1,48 @@
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "benchmark.h"
+#include "workerpool.h"
+/*
+Handing the row bands of one frame to the analysis threads:a run of the persistent pool
+against starting and joining a thread per band,as the kernels did per frame.The bands do no work,
+what is measured is what every parallel kernel pays before its first pixel.
+*/
+namespace
+{
+	const int RUNS = 20000;
+
+	//two at least,one band would run on the caller alone
+	int bands()
+	{
+		return std::max(2, analysisThreads());
+	}
+
+	void poolPath(BenchState& state)
+	{
+		WorkerPool pool(bands());
+		std::vector<int> touched(bands(), 0);
+		state.start();
+		for (int i = 0; i < RUNS; i++)
+			pool.run(int(touched.size()), [&](int band){ touched[band]++; });
+		state.stop(RUNS);
+	}
+
+	void spawnPath(BenchState& state)
+	{
+		std::vector<int> touched(bands(), 0);
+		state.start();
+		for (int i = 0; i < RUNS; i++){
+			std::vector<std::thread> workers;
+			for (int band = 1; band < int(touched.size()); band++)
+				workers.emplace_back([&touched, band]{ touched[band]++; });
+			touched[0]++;
+			for (auto& worker : workers)
+				worker.join();
+		}
+		state.stop(RUNS);
+	}
+}
+
+BENCHMARK("workerpool/run", poolPath);
+BENCHMARK("workerpool/spawn_threads", spawnPath);
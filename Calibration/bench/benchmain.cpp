@@ -0,0 +1,190 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QRegularExpression>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QThread>
+#include <QtDebug>
+#include <algorithm>
+#include "benchmark.h"
+/*
+Calibration-Bench [--filter regex] [--repetitions n] [--warmup-ms ms] [--max-spread fraction] [--json file]
+The CPU is kept busy for warmup-ms first so it leaves its idle clock before anything is measured.
+Every case runs once to warm up,then n times;while the interquartile range of the runs is wider than
+max-spread of their median,up to 4n more runs are taken.The median is reported,--json also writes every
+case with its spread for comparing builds.
+*/
+namespace
+{
+	const int MAX_EXTRA_ROUNDS = 4;
+
+	struct BenchResult
+	{
+		QString name;
+		double median = 0;
+		double min = 0;
+		double max = 0;
+		double spread = 0;//interquartile range / median
+		qint64 items = 0;
+		int repetitions = 0;
+		bool stable = false;
+	};
+
+	//integer work the compiler cannot drop,until the clock has ramped up
+	void spin(int ms)
+	{
+		QElapsedTimer timer;
+		timer.start();
+		volatile quint64 sink = 0;
+		quint64 x = 88172645463325252ull;
+		while (timer.elapsed() < ms){
+			for (int i = 0; i < 100000; i++){
+				x ^= x << 13;
+				x ^= x >> 7;
+				x ^= x << 17;
+			}
+			sink = sink + x;
+		}
+	}
+
+	double spreadOf(std::vector<double> nsPerItem)
+	{
+		std::sort(nsPerItem.begin(), nsPerItem.end());
+		const double median = nsPerItem[nsPerItem.size() / 2];
+		const double iqr = nsPerItem[nsPerItem.size() * 3 / 4] - nsPerItem[nsPerItem.size() / 4];
+		return median > 0 ? iqr / median : 0.0;
+	}
+
+	BenchResult runCase(const BenchCase& benchCase, int repetitions, double maxSpread)
+	{
+		BenchState warmup;
+		benchCase.run(warmup);
+
+		BenchResult result;
+		result.name = benchCase.name;
+		std::vector<double> nsPerItem;
+		const auto measure = [&](int runs){
+			for (int i = 0; i < runs; i++){
+				BenchState state;
+				benchCase.run(state);
+				result.items = state.items();
+				nsPerItem.push_back(state.items() ? double(state.elapsedNs()) / state.items() : 0.0);
+			}
+		};
+		measure(repetitions);
+		result.spread = spreadOf(nsPerItem);
+		for (int round = 0; round < MAX_EXTRA_ROUNDS && result.spread > maxSpread; round++){
+			measure(repetitions);
+			result.spread = spreadOf(nsPerItem);
+		}
+		std::sort(nsPerItem.begin(), nsPerItem.end());
+		result.median = nsPerItem[nsPerItem.size() / 2];
+		result.min = nsPerItem.front();
+		result.max = nsPerItem.back();
+		result.repetitions = int(nsPerItem.size());
+		result.stable = result.spread <= maxSpread;
+		return result;
+	}
+
+	bool writeJson(const QString& path, const std::vector<BenchResult>& results, int repetitions, int warmupMs, double maxSpread)
+	{
+		QJsonObject context{
+			{ "date", QDateTime::currentDateTimeUtc().toString(Qt::ISODate) },
+			{ "host", QSysInfo::machineHostName() },
+			{ "cpus", QThread::idealThreadCount() },
+#ifdef QT_NO_DEBUG
+			{ "build", "release" },
+#else
+			{ "build", "debug" },
+#endif
+			{ "repetitions", repetitions },
+			{ "warmupMs", warmupMs },
+			{ "maxSpread", maxSpread }
+		};
+		QJsonArray benchmarks;
+		for (const auto& result : results){
+			benchmarks.append(QJsonObject{
+				{ "name", result.name },
+				{ "nsPerItem", result.median },
+				{ "itemsPerSecond", result.median > 0 ? 1e9 / result.median : 0.0 },
+				{ "minNsPerItem", result.min },
+				{ "maxNsPerItem", result.max },
+				{ "spread", result.spread },
+				{ "items", double(result.items) },
+				{ "repetitions", result.repetitions },
+				{ "stable", result.stable }
+			});
+		}
+		QFile file(path);
+		if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)){
+			qWarning() << "cannot write" << path;
+			return false;
+		}
+		file.write(QJsonDocument(QJsonObject{ { "context", context }, { "benchmarks", benchmarks } }).toJson());
+		return true;
+	}
+}
+
+std::vector<BenchCase>& benchCases()
+{
+	static std::vector<BenchCase> cases;
+	return cases;
+}
+
+std::vector<unsigned char> rampFrame(int bytesPerPixel, int width, int height)
+{
+	std::vector<unsigned char> frame(size_t(width) * height * bytesPerPixel);
+	for (size_t i = 0; i < frame.size(); i++)
+		frame[i] = (unsigned char)((i * 7 + i / width) & 0xff);
+	return frame;
+}
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication a(argc, argv);
+
+	QCommandLineParser parser;
+	parser.addHelpOption();
+	QCommandLineOption filterOption("filter", "Only run cases matching <regex>", "regex", ".*");
+	QCommandLineOption repetitionsOption("repetitions", "Measured runs per case", "n", "5");
+	QCommandLineOption warmupOption("warmup-ms", "Busy time before the first case", "ms", "500");
+	QCommandLineOption spreadOption("max-spread", "Interquartile range per median a case is repeated until", "fraction", "0.05");
+	QCommandLineOption jsonOption("json", "Also write the results to <file>", "file");
+	parser.addOption(filterOption);
+	parser.addOption(repetitionsOption);
+	parser.addOption(warmupOption);
+	parser.addOption(spreadOption);
+	parser.addOption(jsonOption);
+	parser.process(a);
+
+	QRegularExpression filter(parser.value(filterOption));
+	const int repetitions = qMax(1, parser.value(repetitionsOption).toInt());
+	const int warmupMs = qMax(0, parser.value(warmupOption).toInt());
+	const double maxSpread = parser.value(spreadOption).toDouble();
+
+	spin(warmupMs);
+	std::vector<BenchResult> results;
+	for (auto& benchCase : benchCases()){
+		if (!filter.match(benchCase.name).hasMatch())
+			continue;
+		const auto result = runCase(benchCase, repetitions, maxSpread);
+		qInfo().noquote() << QString("%1  %2 ns/item  %3 items/s  (%4 items, min %5 ns, max %6 ns, spread %7%8)")
+			.arg(result.name, -40)
+			.arg(result.median, 10, 'f', 1)
+			.arg(result.median > 0 ? 1e9 / result.median : 0.0, 12, 'f', 0)
+			.arg(result.items)
+			.arg(result.min, 0, 'f', 1)
+			.arg(result.max, 0, 'f', 1)
+			.arg(QString("%1%").arg(result.spread * 100, 0, 'f', 1))
+			.arg(result.stable ? "" : ", unstable");
+		results.push_back(result);
+	}
+	if (parser.isSet(jsonOption) && !writeJson(parser.value(jsonOption), results, repetitions, warmupMs, maxSpread))
+		return 1;
+	return 0;
+}
@@ -0,0 +1,68 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QString>
+#include <QElapsedTimer>
+#include <functional>
+#include <vector>
+#include "workerpool.h"
+/*
+Minimal benchmark harness for Calibration-Bench.
+A case times its own measured region with start/stop and reports how many items it processed.
+*/
+class BenchState
+{
+public:
+	void start() { m_timer.start(); }
+	void stop(qint64 items) { m_elapsedNs = m_timer.nsecsElapsed(); m_items = items; }
+
+	qint64 elapsedNs() const { return m_elapsedNs; }
+	qint64 items() const { return m_items; }
+private:
+	QElapsedTimer m_timer;
+	qint64 m_elapsedNs = 0;
+	qint64 m_items = 0;
+};
+
+struct BenchCase
+{
+	QString name;
+	std::function<void(BenchState&)> run;
+};
+
+std::vector<BenchCase>& benchCases();
+
+struct BenchRegistrar
+{
+	BenchRegistrar(const char* name, std::function<void(BenchState&)> run)
+	{ benchCases().push_back(BenchCase{ QString::fromLatin1(name), run }); }
+};
+
+#define BENCH_CONCAT_IMPL(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_IMPL(a, b)
+#define BENCHMARK(name, function) static BenchRegistrar BENCH_CONCAT(benchRegistrar_, __LINE__)(name, function)
+
+//frame size of the scanner's cameras,what most cases measure on
+const int FRAME_WIDTH = 1280;
+const int FRAME_HEIGHT = 1024;
+
+/*
+Synthetic gray frame of the scene a case needs,level(x,y) of every pixel
+*/
+template <typename Level>
+std::vector<unsigned char> syntheticFrame(int width, int height, const Level& level)
+{
+	std::vector<unsigned char> frame(size_t(width) * height);
+	for (int y = 0; y < height; y++){
+		for (int x = 0; x < width; x++)
+			frame[size_t(y) * width + x] = (unsigned char)level(x, y);
+	}
+	return frame;
+}
+/*
+bytesPerPixel:1 gray,3 RGB,2 for the 16-bit formats
+Diagonal ramp of byte values,for cases that need pixels but no scene
+*/
+std::vector<unsigned char> rampFrame(int bytesPerPixel = 1, int width = FRAME_WIDTH, int height = FRAME_HEIGHT);
+
+#endif // BENCHMARK_H
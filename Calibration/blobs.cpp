@@ -0,0 +1,247 @@
+#include "blobs.h"
+#include "exposure.h"
+#include <algorithm>
+
+namespace
+{
+	struct Run
+	{
+		int y;
+		int x0;
+		int x1;//exclusive
+		int parent;//union-find,index into all runs
+	};
+
+	//runs of one band,rows [firstRow,lastRow)
+	struct Band
+	{
+		int firstRow = 0;
+		int lastRow = 0;
+		std::vector<Run> runs;
+		int firstRowRuns = 0;//runs [0,firstRowRuns) lie on firstRow
+		int lastRowBegin = 0;//runs [lastRowBegin,size) lie on lastRow-1
+		int offset = 0;//index of runs[0] once all bands are joined
+	};
+
+	int find(std::vector<Run>& runs, int i)
+	{
+		while (runs[i].parent != i){
+			runs[i].parent = runs[runs[i].parent].parent;
+			i = runs[i].parent;
+		}
+		return i;
+	}
+
+	void unite(std::vector<Run>& runs, int a, int b)
+	{
+		a = find(runs, a);
+		b = find(runs, b);
+		if (a == b)
+			return;
+		if (a < b)
+			runs[b].parent = a;
+		else
+			runs[a].parent = b;
+	}
+
+	//union the runs of two neighbouring rows that overlap,4-connectivity
+	void uniteRows(std::vector<Run>& runs, int aBegin, int aEnd, int bBegin, int bEnd)
+	{
+		int a = aBegin, b = bBegin;
+		while (a < aEnd && b < bEnd){
+			if (runs[a].x0 < runs[b].x1 && runs[b].x0 < runs[a].x1)
+				unite(runs, a, b);
+			if (runs[a].x1 < runs[b].x1)
+				a++;
+			else
+				b++;
+		}
+	}
+
+	void processBand(const unsigned char* data, int width, int channel, const BlobParams& params,
+		int globalThreshold, Band& band)
+	{
+		const int stride = width * channel;
+		const int offset = channel == 3 ? 1 : 0;
+		const int tiles = (width + params.tileSize - 1) / params.tileSize;
+		//dark foreground is v < threshold,the same as 255-v > 255-threshold
+		const int flip = params.dark ? 255 : 0;
+		std::vector<int> thresholds(tiles);
+		int previousBegin = -1, previousEnd = -1;
+
+		for (int tileTop = band.firstRow; tileTop < band.lastRow; tileTop += params.tileSize){
+			const int tileBottom = std::min(band.lastRow, tileTop + params.tileSize);
+			//threshold per tile from its range,flipped for dark foreground
+			for (int t = 0; t < tiles; t++){
+				const int x0 = t * params.tileSize, x1 = std::min(width, x0 + params.tileSize);
+				int low = 255, high = 0;
+				for (int y = tileTop; y < tileBottom; y++){
+					auto row = data + size_t(y) * stride + offset;
+					for (int x = x0; x < x1; x++){
+						const int v = row[x * channel];
+						low = std::min(low, v);
+						high = std::max(high, v);
+					}
+				}
+				if (high - low >= params.minContrast)
+					thresholds[t] = ((high + low) / 2) ^ flip;
+				else
+					thresholds[t] = params.flatBackground ? 255 : globalThreshold ^ flip;
+			}
+
+			for (int y = tileTop; y < tileBottom; y++){
+				auto row = data + size_t(y) * stride + offset;
+				const int rowBegin = int(band.runs.size());
+				int runStart = -1;
+				for (int t = 0; t < tiles; t++){
+					const int threshold = thresholds[t];
+					const int x1 = std::min(width, (t + 1) * params.tileSize);
+					for (int x = t * params.tileSize; x < x1; x++){
+						const bool foreground = (row[x * channel] ^ flip) > threshold;
+						if (foreground == (runStart >= 0))
+							continue;
+						if (foreground){
+							runStart = x;
+						}
+						else{
+							band.runs.push_back(Run{ y, runStart, x, int(band.runs.size()) });
+							runStart = -1;
+						}
+					}
+				}
+				if (runStart >= 0)
+					band.runs.push_back(Run{ y, runStart, width, int(band.runs.size()) });
+				const int rowEnd = int(band.runs.size());
+				if (previousBegin >= 0)
+					uniteRows(band.runs, previousBegin, previousEnd, rowBegin, rowEnd);
+				if (y == band.firstRow)
+					band.firstRowRuns = rowEnd;
+				band.lastRowBegin = rowBegin;
+				previousBegin = rowBegin;
+				previousEnd = rowEnd;
+			}
+		}
+	}
+}
+
+int otsuThreshold(const uint32_t* bins)
+{
+	uint64_t total = 0;
+	double sum = 0;
+	for (int i = 0; i < 256; i++){
+		total += bins[i];
+		sum += double(i) * bins[i];
+	}
+	if (!total)
+		return 128;
+	double sumBackground = 0, best = -1;
+	uint64_t background = 0;
+	int threshold = 128;
+	for (int i = 0; i < 256; i++){
+		background += bins[i];
+		if (!background)
+			continue;
+		const uint64_t foreground = total - background;
+		if (!foreground)
+			break;
+		sumBackground += double(i) * bins[i];
+		const double meanBackground = sumBackground / background;
+		const double meanForeground = (sum - sumBackground) / foreground;
+		const double between = double(background) * double(foreground) * (meanBackground - meanForeground) * (meanBackground - meanForeground);
+		if (between > best){
+			best = between;
+			threshold = i;
+		}
+	}
+	return threshold;
+}
+
+std::vector<Blob> findBlobs(const unsigned char* data, int width, int height, int channel, const BlobParams& params, WorkerPool* pool)
+{
+	std::vector<Blob> blobs;
+	if (!data || width <= 0 || height <= 0 || (channel != 1 && channel != 3) || params.tileSize <= 0)
+		return blobs;
+
+	int globalThreshold = 255;
+	if (!params.flatBackground){
+		ExposureHistogram histogram;
+		histogram.accumulate(data, width, height, channel);
+		globalThreshold = otsuThreshold(histogram.bins);
+	}
+
+	//bands are whole tile rows so every tile is thresholded by one thread
+	const int tileRows = (height + params.tileSize - 1) / params.tileSize;
+	const int threads = std::max(1, std::min(pool ? pool->threads() : 1, tileRows));
+	const int tileRowsPerBand = (tileRows + threads - 1) / threads;
+	std::vector<Band> bands;
+	for (int first = 0; first < height; first += tileRowsPerBand * params.tileSize){
+		Band band;
+		band.firstRow = first;
+		band.lastRow = std::min(height, first + tileRowsPerBand * params.tileSize);
+		bands.push_back(band);
+	}
+	auto process = [&](int b){ processBand(data, width, channel, params, globalThreshold, bands[b]); };
+	if (pool)
+		pool->run(int(bands.size()), process);
+	else
+		process(0);
+
+	//join the bands,parents move with their runs
+	std::vector<Run> runs;
+	for (auto& band : bands){
+		band.offset = int(runs.size());
+		for (auto run : band.runs){
+			run.parent += band.offset;
+			runs.push_back(run);
+		}
+	}
+	for (size_t b = 1; b < bands.size(); b++){
+		const auto& above = bands[b - 1];
+		const auto& below = bands[b];
+		//only rows adjacent to the seam,empty when the row had no runs
+		const bool aboveHasLastRow = !above.runs.empty() && above.runs.back().y == above.lastRow - 1;
+		const bool belowHasFirstRow = below.firstRowRuns > 0 && below.runs.front().y == below.firstRow;
+		if (aboveHasLastRow && belowHasFirstRow){
+			uniteRows(runs, above.offset + above.lastRowBegin, above.offset + int(above.runs.size()),
+				below.offset, below.offset + below.firstRowRuns);
+		}
+	}
+
+	std::vector<int> blobOf(runs.size(), -1);
+	for (size_t i = 0; i < runs.size(); i++){
+		const int root = find(runs, int(i));
+		int& index = blobOf[root];
+		if (index < 0){
+			index = int(blobs.size());
+			Blob blob;
+			blob.left = width;
+			blob.top = height;
+			blob.right = -1;
+			blob.bottom = -1;
+			blobs.push_back(blob);
+		}
+		auto& blob = blobs[index];
+		const auto& run = runs[i];
+		const int length = run.x1 - run.x0;
+		blob.area += length;
+		//run of pixels x0..x1-1,their x sum is length*(x0+x1-1)/2
+		blob.x += length * (run.x0 + run.x1 - 1) / 2.0;
+		blob.y += double(length) * run.y;
+		blob.left = std::min(blob.left, run.x0);
+		blob.right = std::max(blob.right, run.x1 - 1);
+		blob.top = std::min(blob.top, run.y);
+		blob.bottom = std::max(blob.bottom, run.y);
+	}
+
+	std::vector<Blob> kept;
+	kept.reserve(blobs.size());
+	for (auto& blob : blobs){
+		if (blob.area < params.minArea || blob.area > params.maxArea)
+			continue;
+		blob.x /= blob.area;
+		blob.y /= blob.area;
+		blob.touchesBorder = blob.left == 0 || blob.top == 0 || blob.right == width - 1 || blob.bottom == height - 1;
+		kept.push_back(blob);
+	}
+	return kept;
+}
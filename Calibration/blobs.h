@@ -0,0 +1,48 @@
+#ifndef BLOBS_H
+#define BLOBS_H
+
+#include <cstdint>
+#include <vector>
+#include "workerpool.h"
+/*
+Threshold a camera frame and label its connected foreground regions.
+The frame is cut into bands of tile rows handled on the threads of a pool:each band picks a threshold per tile
+(mid range of the tile,the global Otsu threshold where a tile has too little contrast),
+run-length encodes its rows and unions overlapping runs.Bands are stitched along their borders afterwards.
+*/
+struct Blob
+{
+	int area = 0;
+	double x = 0;//centroid
+	double y = 0;
+	int left = 0;//bounding box,inclusive
+	int top = 0;
+	int right = 0;
+	int bottom = 0;
+	bool touchesBorder = false;
+
+	int width() const { return right - left + 1; }
+	int height() const { return bottom - top + 1; }
+};
+
+struct BlobParams
+{
+	bool dark = false;//foreground is darker than the threshold
+	int tileSize = 64;
+	int minContrast = 32;//max-min of a tile below this uses the global threshold
+	bool flatBackground = false;//such tiles are background instead,for sparse small targets
+	int minArea = 12;
+	int maxArea = 1 << 20;
+};
+
+/*
+data:width*height*channel pixels,channel 3 is thresholded on green
+pool:a band per thread,null labels on the calling thread
+*/
+std::vector<Blob> findBlobs(const unsigned char* data, int width, int height, int channel, const BlobParams& params, WorkerPool* pool = nullptr);
+/*
+Otsu threshold of a 256 bin histogram
+*/
+int otsuThreshold(const uint32_t* bins);
+
+#endif // BLOBS_H
@@ -0,0 +1,295 @@
+#include "boarddetector.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	//a grid cell is assigned when the candidate maps this close to the cell center,in cells
+	const double CELL_TOLERANCE = 0.3;
+	//fit error the board is still accepted with,fraction of the circle spacing
+	const double MAX_RMS_SPACING = 0.1;
+	const double PI = 3.14159265358979323846;
+
+	BoardPoint point(double x, double y)
+	{
+		BoardPoint p;
+		p.x = x;
+		p.y = y;
+		return p;
+	}
+
+	double cross(const BoardPoint& o, const BoardPoint& a, const BoardPoint& b)
+	{
+		return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+	}
+
+	//counter clockwise,collinear points dropped
+	std::vector<BoardPoint> convexHull(std::vector<BoardPoint> points)
+	{
+		std::sort(points.begin(), points.end(), [](const BoardPoint& a, const BoardPoint& b){
+			return a.x < b.x || (a.x == b.x && a.y < b.y);
+		});
+		std::vector<BoardPoint> hull(points.size() * 2);
+		size_t k = 0;
+		for (size_t i = 0; i < points.size(); i++){
+			while (k >= 2 && cross(hull[k - 2], hull[k - 1], points[i]) <= 0)
+				k--;
+			hull[k++] = points[i];
+		}
+		for (size_t i = points.size() - 1, lower = k + 1; i-- > 0;){
+			while (k >= lower && cross(hull[k - 2], hull[k - 1], points[i]) <= 0)
+				k--;
+			hull[k++] = points[i];
+		}
+		hull.resize(k > 1 ? k - 1 : k);
+		return hull;
+	}
+
+	//the four hull vertices where the outline turns most,the outer circles of the grid
+	bool hullCorners(const std::vector<BoardPoint>& hull, BoardPoint corners[4])
+	{
+		const size_t n = hull.size();
+		if (n < 4)
+			return false;
+		std::vector<std::pair<double, size_t>> turns;
+		for (size_t i = 0; i < n; i++){
+			const auto& previous = hull[(i + n - 1) % n];
+			const auto& next = hull[(i + 1) % n];
+			const double inAngle = std::atan2(hull[i].y - previous.y, hull[i].x - previous.x);
+			const double outAngle = std::atan2(next.y - hull[i].y, next.x - hull[i].x);
+			double turn = std::fabs(outAngle - inAngle);
+			if (turn > PI)
+				turn = 2 * PI - turn;
+			turns.push_back(std::make_pair(turn, i));
+		}
+		std::partial_sort(turns.begin(), turns.begin() + 4, turns.end(), [](const std::pair<double, size_t>& a, const std::pair<double, size_t>& b){
+			return a.first > b.first;
+		});
+		size_t indexes[4];
+		for (int i = 0; i < 4; i++)
+			indexes[i] = turns[i].second;
+		//keep hull order
+		std::sort(indexes, indexes + 4);
+		for (int i = 0; i < 4; i++)
+			corners[i] = hull[indexes[i]];
+		return true;
+	}
+
+	//translate to the centroid and scale to a mean distance of sqrt(2)
+	void normalization(const std::vector<BoardPoint>& points, double t[3])
+	{
+		double cx = 0, cy = 0;
+		for (const auto& p : points){
+			cx += p.x;
+			cy += p.y;
+		}
+		cx /= points.size();
+		cy /= points.size();
+		double distance = 0;
+		for (const auto& p : points)
+			distance += std::hypot(p.x - cx, p.y - cy);
+		distance /= points.size();
+		t[0] = distance > 0 ? std::sqrt(2.0) / distance : 1;
+		t[1] = cx;
+		t[2] = cy;
+	}
+
+	bool solve8(double a[8][9])
+	{
+		for (int col = 0; col < 8; col++){
+			int pivot = col;
+			for (int row = col + 1; row < 8; row++){
+				if (std::fabs(a[row][col]) > std::fabs(a[pivot][col]))
+					pivot = row;
+			}
+			if (std::fabs(a[pivot][col]) < 1e-12)
+				return false;
+			for (int k = 0; k < 9; k++)
+				std::swap(a[col][k], a[pivot][k]);
+			for (int row = 0; row < 8; row++){
+				if (row == col)
+					continue;
+				const double factor = a[row][col] / a[col][col];
+				for (int k = col; k < 9; k++)
+					a[row][k] -= factor * a[col][k];
+			}
+		}
+		for (int row = 0; row < 8; row++)
+			a[row][8] /= a[row][row];
+		return true;
+	}
+
+	//least squares homography src -> dst,h[8] = 1,exact for four points
+	bool homography(const std::vector<BoardPoint>& src, const std::vector<BoardPoint>& dst, double h[9])
+	{
+		if (src.size() < 4 || src.size() != dst.size())
+			return false;
+		double ts[3], td[3];
+		normalization(src, ts);
+		normalization(dst, td);
+		double normal[8][9] = {};
+		for (size_t i = 0; i < src.size(); i++){
+			const double x = (src[i].x - ts[1]) * ts[0], y = (src[i].y - ts[2]) * ts[0];
+			const double u = (dst[i].x - td[1]) * td[0], v = (dst[i].y - td[2]) * td[0];
+			const double rows[2][9] = {
+				{ x, y, 1, 0, 0, 0, -u * x, -u * y, u },
+				{ 0, 0, 0, x, y, 1, -v * x, -v * y, v }
+			};
+			for (const auto& row : rows){
+				for (int r = 0; r < 8; r++){
+					for (int c = 0; c < 9; c++)
+						normal[r][c] += row[r] * row[c];
+				}
+			}
+		}
+		if (!solve8(normal))
+			return false;
+		double hn[9];
+		for (int i = 0; i < 8; i++)
+			hn[i] = normal[i][8];
+		hn[8] = 1;
+		//h = Td^-1 * Hn * Ts
+		const double s[9] = { ts[0], 0, -ts[0] * ts[1], 0, ts[0], -ts[0] * ts[2], 0, 0, 1 };
+		const double d[9] = { 1 / td[0], 0, td[1], 0, 1 / td[0], td[2], 0, 0, 1 };
+		double m[9];
+		for (int r = 0; r < 3; r++){
+			for (int c = 0; c < 3; c++)
+				m[r * 3 + c] = hn[r * 3] * s[c] + hn[r * 3 + 1] * s[3 + c] + hn[r * 3 + 2] * s[6 + c];
+		}
+		for (int r = 0; r < 3; r++){
+			for (int c = 0; c < 3; c++)
+				h[r * 3 + c] = d[r * 3] * m[c] + d[r * 3 + 1] * m[3 + c] + d[r * 3 + 2] * m[6 + c];
+		}
+		return true;
+	}
+
+	BoardPoint apply(const double h[9], const BoardPoint& p)
+	{
+		const double w = h[6] * p.x + h[7] * p.y + h[8];
+		BoardPoint q;
+		q.x = (h[0] * p.x + h[1] * p.y + h[2]) / w;
+		q.y = (h[3] * p.x + h[4] * p.y + h[5]) / w;
+		return q;
+	}
+
+	//grid cell of every candidate through the corner homography,-1 where none fits
+	int assignCells(const std::vector<BoardPoint>& candidates, const BoardPoint corners[4], const BoardPoint gridCorners[4],
+		const BoardSpec& spec, std::vector<int>& cellOf)
+	{
+		std::vector<BoardPoint> image(corners, corners + 4), grid(gridCorners, gridCorners + 4);
+		double h[9];
+		cellOf.assign(candidates.size(), -1);
+		if (!homography(image, grid, h))
+			return 0;
+		std::vector<bool> used(spec.circles(), false);
+		int matched = 0;
+		for (size_t i = 0; i < candidates.size(); i++){
+			const auto g = apply(h, candidates[i]);
+			const double col = std::floor(g.x + 0.5), row = std::floor(g.y + 0.5);
+			if (col < 0 || row < 0 || col >= spec.cols || row >= spec.rows)
+				continue;
+			if (std::fabs(g.x - col) > CELL_TOLERANCE || std::fabs(g.y - row) > CELL_TOLERANCE)
+				continue;
+			const int cell = int(row) * spec.cols + int(col);
+			if (used[cell])
+				continue;
+			used[cell] = true;
+			cellOf[i] = cell;
+			matched++;
+		}
+		return matched;
+	}
+}
+
+BoardDetection fitBoard(const std::vector<Blob>& blobs, const BoardSpec& spec)
+{
+	BoardDetection detection;
+	detection.expected = spec.circles();
+	if (!spec.isValid())
+		return detection;
+
+	//round,filled,whole blobs
+	std::vector<const Blob*> circles;
+	for (const auto& blob : blobs){
+		if (blob.touchesBorder || blob.width() < 3 || blob.height() < 3)
+			continue;
+		const double fill = double(blob.area) / (double(blob.width()) * blob.height());
+		const double aspect = double(std::max(blob.width(), blob.height())) / std::min(blob.width(), blob.height());
+		if (fill < 0.55 || fill > 0.95 || aspect > 3)
+			continue;
+		circles.push_back(&blob);
+	}
+	detection.candidates = int(circles.size());
+	if (detection.candidates < detection.expected)
+		return detection;
+	//board circles share a size,clutter of other sizes is dropped first
+	if (detection.candidates > detection.expected){
+		std::vector<int> areas;
+		for (auto circle : circles)
+			areas.push_back(circle->area);
+		std::nth_element(areas.begin(), areas.begin() + areas.size() / 2, areas.end());
+		const double median = areas[areas.size() / 2];
+		std::sort(circles.begin(), circles.end(), [median](const Blob* a, const Blob* b){
+			return std::fabs(std::log(a->area / median)) < std::fabs(std::log(b->area / median));
+		});
+		circles.resize(detection.expected);
+	}
+
+	std::vector<BoardPoint> candidates;
+	for (auto circle : circles)
+		candidates.push_back(point(circle->x, circle->y));
+	BoardPoint corners[4];
+	if (!hullCorners(convexHull(candidates), corners))
+		return detection;
+
+	//which hull side runs along the columns is unknown,try both
+	const double c = spec.cols - 1, r = spec.rows - 1;
+	const BoardPoint labelings[2][4] = {
+		{ point(0, 0), point(c, 0), point(c, r), point(0, r) },
+		{ point(0, 0), point(0, r), point(c, r), point(c, 0) }
+	};
+	std::vector<int> cellOf, bestCellOf;
+	for (const auto& labeling : labelings){
+		const int matched = assignCells(candidates, corners, labeling, spec, cellOf);
+		if (matched > detection.matched){
+			detection.matched = matched;
+			bestCellOf = cellOf;
+		}
+	}
+	if (detection.matched != detection.expected)
+		return detection;
+
+	std::vector<BoardPoint> grid(candidates.size()), image(candidates.size());
+	for (size_t i = 0; i < candidates.size(); i++){
+		grid[i].x = bestCellOf[i] % spec.cols;
+		grid[i].y = bestCellOf[i] / spec.cols;
+		image[i] = candidates[i];
+	}
+	double h[9];
+	if (!homography(grid, image, h))
+		return detection;
+	double squared = 0;
+	for (size_t i = 0; i < grid.size(); i++){
+		const auto p = apply(h, grid[i]);
+		squared += (p.x - image[i].x) * (p.x - image[i].x) + (p.y - image[i].y) * (p.y - image[i].y);
+	}
+	detection.rmsPx = std::sqrt(squared / grid.size());
+	//spacing of neighbouring circles at the board center
+	const auto a = apply(h, point(c / 2, r / 2)), b = apply(h, point(c / 2 + 1, r / 2));
+	const double spacing = std::hypot(b.x - a.x, b.y - a.y);
+	if (detection.rmsPx > MAX_RMS_SPACING * spacing)
+		return detection;
+
+	detection.points.resize(candidates.size());
+	for (size_t i = 0; i < candidates.size(); i++)
+		detection.points[bestCellOf[i]] = candidates[i];
+	detection.found = true;
+	return detection;
+}
+
+BoardDetection detectBoard(const unsigned char* data, int width, int height, int channel, const BoardSpec& spec, WorkerPool* pool)
+{
+	BlobParams params;
+	params.dark = spec.darkCircles;
+	return fitBoard(findBlobs(data, width, height, channel, params, pool), spec);
+}
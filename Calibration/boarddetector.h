@@ -0,0 +1,45 @@
+#ifndef BOARD_DETECTOR_H
+#define BOARD_DETECTOR_H
+
+#include <vector>
+#include "blobs.h"
+/*
+Finds a circle grid calibration board in a camera frame.
+Circle candidates come from findBlobs,the four outer circles are taken from the convex hull of the candidates,
+a homography from grid to image through them assigns every candidate a grid cell,
+and a least squares homography through all circles gives the fit error.
+The board counts as found only when every circle of the grid was assigned.
+*/
+struct BoardSpec
+{
+	int cols = 0;
+	int rows = 0;
+	bool darkCircles = false;
+
+	bool isValid() const { return cols >= 2 && rows >= 2; }
+	int circles() const { return cols * rows; }
+};
+
+struct BoardPoint
+{
+	double x = 0;
+	double y = 0;
+};
+
+struct BoardDetection
+{
+	bool found = false;
+	int candidates = 0;//circle like blobs
+	int matched = 0;//candidates assigned to a grid cell
+	int expected = 0;
+	double rmsPx = 0;//fit error of the homography through all circles
+	std::vector<BoardPoint> points;//row major,filled when found
+};
+
+BoardDetection detectBoard(const unsigned char* data, int width, int height, int channel, const BoardSpec& spec, WorkerPool* pool = nullptr);
+/*
+Grid fit on blobs that were already found,used by detectBoard and the benchmark
+*/
+BoardDetection fitBoard(const std::vector<Blob>& blobs, const BoardSpec& spec);
+
+#endif // BOARD_DETECTOR_H
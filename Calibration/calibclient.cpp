@@ -0,0 +1,320 @@
+#include "calibclient.h"
+#include <zmq.h>
+#include <cstring>
+
+namespace
+{
+	const char ENVELOPE_PREFIX[] = "v1.0/";
+
+	CalibBatch::ReplyHandler boolHandler(bool* result)
+	{
+		return [result](const std::string& reply){ *result = CalibClient::replyBool(reply); };
+	}
+
+	CalibBatch::ReplyHandler intHandler(int* result)
+	{
+		return [result](const std::string& reply){ *result = CalibClient::replyInt(reply); };
+	}
+
+	//text replies are NUL terminated C strings
+	CalibBatch::ReplyHandler textHandler(std::string* result)
+	{
+		return [result](const std::string& reply){ *result = std::string(reply.c_str()); };
+	}
+}
+
+void CalibBatch::request(const std::string& cmd, const std::string& data, ReplyHandler handler)
+{
+	Entry entry;
+	entry.cmd = cmd;
+	entry.data = data;
+	entry.handler = handler;
+	m_entries.push_back(entry);
+}
+
+void CalibBatch::pull(std::string* json)
+{
+	request("pull", std::string(), [json](const std::string& reply){ *json = reply; });
+}
+
+void CalibBatch::deviceCheck(bool* result)
+{
+	request("device/check", std::string(), boolHandler(result));
+}
+
+void CalibBatch::setDevSubType(const std::string& subType, bool* result)
+{
+	request("device/devSubType/set", subType, boolHandler(result));
+}
+
+void CalibBatch::caliEnter(bool* result)
+{
+	request("cali/enter", std::string(), boolHandler(result));
+}
+
+void CalibBatch::caliExit(bool* result)
+{
+	request("cali/exit", std::string(), boolHandler(result));
+}
+
+void CalibBatch::caliSetType(const std::string& type, bool* result)
+{
+	request("cali/type/set", type, boolHandler(result));
+}
+
+void CalibBatch::caliTime(std::string* time)
+{
+	request("cali/time", std::string(), textHandler(time));
+}
+
+void CalibBatch::caliCurrentGroup(int* group)
+{
+	request("cali/currentCaliGroup", std::string(), intHandler(group));
+}
+
+void CalibBatch::caliCurrentDist(int* dist)
+{
+	request("cali/currentCaliDist", std::string(), intHandler(dist));
+}
+
+void CalibBatch::caliSetSnapEnabled(bool enabled, bool* result)
+{
+	request("cali/snapEnabled/set", enabled ? "1" : "0", boolHandler(result));
+}
+
+CalibClient::CalibClient(void* socket)
+{
+	setSocket(socket);
+}
+
+CalibClient::~CalibClient()
+{
+	close();
+}
+
+void CalibClient::setSocket(void* socket)
+{
+	close();
+	m_socket = socket;
+	m_dealer = false;
+	if (!socket)
+		return;
+	int type = 0;
+	size_t typeSize = sizeof(type);
+	if (zmq_getsockopt(socket, ZMQ_TYPE, &type, &typeSize) == 0)
+		m_dealer = type == ZMQ_DEALER;
+}
+
+bool CalibClient::connect(void* context, const std::string& endpoint, bool pipelined, int timeoutMs)
+{
+	close();
+	m_context = context;
+	m_endpoint = endpoint;
+	m_timeoutMs = timeoutMs;
+	m_dealer = pipelined;
+	m_socket = zmq_socket(context, pipelined ? ZMQ_DEALER : ZMQ_REQ);
+	if (!m_socket)
+		return fail("socket", endpoint);
+	m_ownsSocket = true;
+	zmq_setsockopt(m_socket, ZMQ_SNDTIMEO, &timeoutMs, sizeof(timeoutMs));
+	zmq_setsockopt(m_socket, ZMQ_RCVTIMEO, &timeoutMs, sizeof(timeoutMs));
+	//pending requests are dropped on close,not kept until the SDK answers
+	int linger = 0;
+	zmq_setsockopt(m_socket, ZMQ_LINGER, &linger, sizeof(linger));
+	if (m_socketOptions)
+		m_socketOptions(m_socket);
+	if (zmq_connect(m_socket, endpoint.c_str()) != 0){
+		fail("connect", endpoint);
+		close();
+		return false;
+	}
+	return true;
+}
+
+void CalibClient::close()
+{
+	if (m_ownsSocket && m_socket)
+		zmq_close(m_socket);
+	m_socket = nullptr;
+	m_ownsSocket = false;
+	m_broken = false;
+}
+
+bool CalibClient::reconnect()
+{
+	if (!m_broken)
+		return true;
+	//a socket of the caller cannot be replaced,its next reply may belong to a failed request
+	if (!m_ownsSocket)
+		return true;
+	void* context = m_context;
+	const std::string endpoint = m_endpoint;
+	return connect(context, endpoint, m_dealer, m_timeoutMs);
+}
+
+bool CalibClient::fail(const std::string& what, const std::string& cmd)
+{
+	m_lastErrno = zmq_errno();
+	m_lastError = what + " " + cmd + ": " + zmq_strerror(m_lastErrno);
+	m_broken = true;
+	return false;
+}
+
+bool CalibClient::send(const CalibBatch::Entry& entry)
+{
+	//the REP side of the SDK expects the empty delimiter a REQ socket adds by itself
+	if (m_dealer && zmq_send(m_socket, "", 0, ZMQ_SNDMORE) != 0)
+		return fail("send delimiter", entry.cmd);
+	const std::string envelope = ENVELOPE_PREFIX + entry.cmd;
+	if (zmq_send(m_socket, envelope.data(), envelope.size(), entry.data.empty() ? 0 : ZMQ_SNDMORE) != int(envelope.size()))
+		return fail("send envelope", entry.cmd);
+	if (!entry.data.empty() && zmq_send(m_socket, entry.data.data(), entry.data.size(), 0) != int(entry.data.size()))
+		return fail("send data", entry.cmd);
+	return true;
+}
+
+bool CalibClient::receive(std::string* reply)
+{
+	zmq_msg_t message;
+	zmq_msg_init(&message);
+	if (m_dealer){
+		if (zmq_msg_recv(&message, m_socket, 0) < 0 || zmq_msg_size(&message) != 0 || !zmq_msg_more(&message)){
+			zmq_msg_close(&message);
+			return fail("receive delimiter", std::string());
+		}
+	}
+	if (zmq_msg_recv(&message, m_socket, 0) < 0){
+		zmq_msg_close(&message);
+		return fail("receive reply", std::string());
+	}
+	reply->assign(static_cast<const char*>(zmq_msg_data(&message)), zmq_msg_size(&message));
+	//the protocol replies with one frame,drop anything unexpected so the socket stays in step
+	while (zmq_msg_more(&message)){
+		if (zmq_msg_recv(&message, m_socket, 0) < 0)
+			break;
+	}
+	zmq_msg_close(&message);
+	return true;
+}
+
+bool CalibClient::run(const CalibBatch& batch, size_t maxInFlight)
+{
+	if (!m_socket){
+		m_lastError = "no socket";
+		m_lastErrno = 0;
+		return false;
+	}
+	if (!reconnect())
+		return false;
+	const auto& entries = batch.m_entries;
+	//REQ allows one request in flight
+	const size_t window = m_dealer ? (maxInFlight ? maxInFlight : 1) : 1;
+	size_t sent = 0;
+	std::string reply;
+	for (size_t received = 0; received < entries.size(); received++){
+		while (sent < entries.size() && sent - received < window){
+			if (!send(entries[sent]))
+				return false;
+			sent++;
+		}
+		if (!receive(&reply)){
+			m_lastError += " (" + entries[received].cmd + ")";
+			return false;
+		}
+		if (entries[received].handler)
+			entries[received].handler(reply);
+	}
+	return true;
+}
+
+bool CalibClient::request(const std::string& cmd, const std::string& data, std::string* reply)
+{
+	CalibBatch batch;
+	batch.request(cmd, data, [reply](const std::string& frame){
+		if (reply)
+			*reply = frame;
+	});
+	return run(batch);
+}
+
+bool CalibClient::pull(std::string* json)
+{
+	CalibBatch batch;
+	batch.pull(json);
+	return run(batch);
+}
+
+bool CalibClient::deviceCheck(bool* result)
+{
+	CalibBatch batch;
+	batch.deviceCheck(result);
+	return run(batch);
+}
+
+bool CalibClient::setDevSubType(const std::string& subType, bool* result)
+{
+	CalibBatch batch;
+	batch.setDevSubType(subType, result);
+	return run(batch);
+}
+
+bool CalibClient::caliEnter(bool* result)
+{
+	CalibBatch batch;
+	batch.caliEnter(result);
+	return run(batch);
+}
+
+bool CalibClient::caliExit(bool* result)
+{
+	CalibBatch batch;
+	batch.caliExit(result);
+	return run(batch);
+}
+
+bool CalibClient::caliSetType(const std::string& type, bool* result)
+{
+	CalibBatch batch;
+	batch.caliSetType(type, result);
+	return run(batch);
+}
+
+bool CalibClient::caliTime(std::string* time)
+{
+	CalibBatch batch;
+	batch.caliTime(time);
+	return run(batch);
+}
+
+bool CalibClient::caliCurrentGroup(int* group)
+{
+	CalibBatch batch;
+	batch.caliCurrentGroup(group);
+	return run(batch);
+}
+
+bool CalibClient::caliCurrentDist(int* dist)
+{
+	CalibBatch batch;
+	batch.caliCurrentDist(dist);
+	return run(batch);
+}
+
+bool CalibClient::caliSetSnapEnabled(bool enabled, bool* result)
+{
+	CalibBatch batch;
+	batch.caliSetSnapEnabled(enabled, result);
+	return run(batch);
+}
+
+bool CalibClient::replyBool(const std::string& reply)
+{
+	return replyInt(reply) != 0;
+}
+
+int CalibClient::replyInt(const std::string& reply)
+{
+	int value = 0;
+	memcpy(&value, reply.data(), reply.size() < sizeof(value) ? reply.size() : sizeof(value));
+	return value;
+}
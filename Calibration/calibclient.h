@@ -0,0 +1,136 @@
+#ifndef CALIB_CLIENT_H
+#define CALIB_CLIENT_H
+
+#include <functional>
+#include <string>
+#include <vector>
+/*
+SDK requests in plain C++ over libzmq,no Qt,built as the calibclient library.
+Over a REQ socket every request is one round trip.Over a DEALER socket the requests of a CalibBatch are
+written out ahead of their replies,which come back in order,so a batch costs about one round trip.
+Calls return false when a request could not be delivered,lastError tells why.
+*/
+class CalibBatch
+{
+public:
+	typedef std::function<void(const std::string&)> ReplyHandler;
+
+	/*
+	cmd:envelope without the version prefix,e.g. cali/enter
+	data:optional second frame
+	handler:called with the first reply frame when the batch runs
+	*/
+	void request(const std::string& cmd, const std::string& data = std::string(), ReplyHandler handler = ReplyHandler());
+
+	//typed requests,the result is written when the batch runs
+	void pull(std::string* json);
+	void deviceCheck(bool* result);
+	/*
+	subType:DST_PRO or DST_PRO_PLUS
+	*/
+	void setDevSubType(const std::string& subType, bool* result);
+	void caliEnter(bool* result);
+	void caliExit(bool* result);
+	/*
+	type:CT_STEREO,CT_WHITE_BALANCE,CT_HD or CT_DEFINITION
+	*/
+	void caliSetType(const std::string& type, bool* result);
+	void caliTime(std::string* time);
+	void caliCurrentGroup(int* group);
+	void caliCurrentDist(int* dist);
+	void caliSetSnapEnabled(bool enabled, bool* result);
+
+	size_t size() const { return m_entries.size(); }
+	bool empty() const { return m_entries.empty(); }
+	void clear() { m_entries.clear(); }
+private:
+	friend class CalibClient;
+	struct Entry
+	{
+		std::string cmd;
+		std::string data;
+		ReplyHandler handler;
+	};
+	std::vector<Entry> m_entries;
+};
+
+class CalibClient
+{
+public:
+	/*
+	socket:REQ or DEALER socket owned by the caller,may be set later
+	*/
+	explicit CalibClient(void* socket = nullptr);
+	~CalibClient();
+	CalibClient(const CalibClient&) = delete;
+	CalibClient& operator=(const CalibClient&) = delete;
+
+	void setSocket(void* socket);
+	void* socket() const { return m_socket; }
+	/*
+	Create a socket of our own connected to endpoint,DEALER when pipelined,REQ otherwise
+	timeoutMs:send and receive timeout,a timed out socket is reconnected before the next call
+	*/
+	bool connect(void* context, const std::string& endpoint, bool pipelined, int timeoutMs = 10000);
+	void close();
+	/*
+	apply:called on every socket connect creates,after the timeouts and before it connects,e.g. high-water marks
+	*/
+	void setSocketOptions(const std::function<void(void*)>& apply) { m_socketOptions = apply; }
+	bool isPipelined() const { return m_dealer; }
+
+	/*
+	reply:first reply frame
+	*/
+	bool request(const std::string& cmd, const std::string& data, std::string* reply);
+	/*
+	Run the requests of the batch in order and call their handlers.
+	maxInFlight:requests written ahead of their replies on a DEALER socket,a REQ socket runs them one by one
+	Returns false at the first failure,the handlers of the requests before it have run
+	*/
+	bool run(const CalibBatch& batch, size_t maxInFlight = 64);
+
+	//blocking typed requests,a batch of one
+	bool pull(std::string* json);
+	bool deviceCheck(bool* result);
+	bool setDevSubType(const std::string& subType, bool* result);
+	bool caliEnter(bool* result);
+	bool caliExit(bool* result);
+	bool caliSetType(const std::string& type, bool* result);
+	bool caliTime(std::string* time);
+	bool caliCurrentGroup(int* group);
+	bool caliCurrentDist(int* dist);
+	bool caliSetSnapEnabled(bool enabled, bool* result);
+
+	const std::string& lastError() const { return m_lastError; }
+	/*
+	zmq_errno() of the last failure,EAGAIN when a timeout of connect ran out
+	*/
+	int lastErrno() const { return m_lastErrno; }
+
+	/*
+	Replies of device,set and enter/exit requests are a native int used as bool
+	*/
+	static bool replyBool(const std::string& reply);
+	static int replyInt(const std::string& reply);
+private:
+	bool send(const CalibBatch::Entry& entry);
+	bool receive(std::string* reply);
+	bool fail(const std::string& what, const std::string& cmd);
+	bool reconnect();
+
+	void* m_socket = nullptr;
+	bool m_dealer = false;
+	//set by connect
+	bool m_ownsSocket = false;
+	void* m_context = nullptr;
+	std::string m_endpoint;
+	int m_timeoutMs = 0;
+	std::function<void(void*)> m_socketOptions;
+	//replies may still be queued for requests that failed,the owned socket is replaced first
+	bool m_broken = false;
+	std::string m_lastError;
+	int m_lastErrno = 0;
+};
+
+#endif // CALIB_CLIENT_H
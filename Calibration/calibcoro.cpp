@@ -0,0 +1,479 @@
+#include "calibcoro.h"
+#include <zmq.h>
+#include <algorithm>
+#include "calibclient.h"
+
+namespace
+{
+	const char ENVELOPE_PREFIX[] = "v1.0/";
+	//the loop wakes at least this often to notice stop()
+	const int MAX_POLL_MS = 100;
+
+	bool decodeBool(const std::string& reply)
+	{
+		return CalibClient::replyBool(reply);
+	}
+
+	int decodeInt(const std::string& reply)
+	{
+		return CalibClient::replyInt(reply);
+	}
+
+	//text replies are NUL terminated C strings
+	std::string decodeText(const std::string& reply)
+	{
+		return std::string(reply.c_str());
+	}
+
+	std::string decodeRaw(const std::string& reply)
+	{
+		return reply;
+	}
+
+	bool receiveFrame(void* socket, zmq_msg_t* message, int flags)
+	{
+		return zmq_msg_recv(message, socket, flags) >= 0;
+	}
+
+	std::string frameString(zmq_msg_t* message)
+	{
+		return std::string(static_cast<const char*>(zmq_msg_data(message)), zmq_msg_size(message));
+	}
+
+	//drop the rest of a multipart message
+	void skipFrames(void* socket, zmq_msg_t* message)
+	{
+		while (zmq_msg_more(message)){
+			if (!receiveFrame(socket, message, 0))
+				break;
+		}
+	}
+}
+
+struct CoSubscription::State
+{
+	std::string major;
+	std::string minor;
+	std::deque<CoPublish> buffered;
+	std::shared_ptr<CoWait> wait;
+};
+
+CoSubscription::CoSubscription(CoDevice& device, const std::string& major, const std::string& minor)
+	: m_device(device), m_state(std::make_shared<State>())
+{
+	m_state->major = major;
+	m_state->minor = minor;
+	m_device.m_subscriptions.push_back(m_state.get());
+}
+
+CoSubscription::~CoSubscription()
+{
+	auto& subscriptions = m_device.m_subscriptions;
+	subscriptions.erase(std::remove(subscriptions.begin(), subscriptions.end(), m_state.get()), subscriptions.end());
+	//a timer may still hold the wait,it must not resume a destroyed frame
+	if (m_state->wait)
+		m_state->wait->done = true;
+}
+
+bool CoSubscription::Next::await_ready() const
+{
+	return !subscription->m_state->buffered.empty();
+}
+
+void CoSubscription::Next::await_suspend(std::coroutine_handle<> handle)
+{
+	auto wait = std::make_shared<CoWait>();
+	wait->handle = handle;
+	subscription->m_state->wait = wait;
+	if (timeoutMs > 0)
+		subscription->m_device.m_loop.addTimer(timeoutMs, wait);
+}
+
+std::optional<CoPublish> CoSubscription::Next::await_resume()
+{
+	auto& state = *subscription->m_state;
+	state.wait.reset();
+	if (state.buffered.empty())
+		return std::nullopt;
+	auto publish = std::move(state.buffered.front());
+	state.buffered.pop_front();
+	return publish;
+}
+
+CoDevice::CoDevice(CoLoop& loop, const std::string& name, const std::string& requestEndpoint, const std::string& publishEndpoint)
+	: m_loop(loop), m_name(name), m_requestEndpoint(requestEndpoint)
+{
+	connectRequest();
+	m_publishSocket = zmq_socket(loop.m_context, ZMQ_SUB);
+	zmq_setsockopt(m_publishSocket, ZMQ_SUBSCRIBE, "v1.0", 4);
+	zmq_connect(m_publishSocket, publishEndpoint.c_str());
+}
+
+CoDevice::~CoDevice()
+{
+	if (m_requestSocket)
+		zmq_close(m_requestSocket);
+	zmq_close(m_publishSocket);
+}
+
+bool CoDevice::connectRequest()
+{
+	if (m_requestSocket)
+		zmq_close(m_requestSocket);
+	m_requestSocket = zmq_socket(m_loop.m_context, ZMQ_DEALER);
+	int linger = 0;
+	zmq_setsockopt(m_requestSocket, ZMQ_LINGER, &linger, sizeof(linger));
+	return zmq_connect(m_requestSocket, m_requestEndpoint.c_str()) == 0;
+}
+
+bool CoDevice::write(const std::string& cmd, const std::string& data)
+{
+	//the REP side of the SDK expects the empty delimiter a REQ socket adds by itself
+	if (zmq_send(m_requestSocket, "", 0, ZMQ_SNDMORE | ZMQ_DONTWAIT) != 0)
+		return false;
+	const std::string envelope = ENVELOPE_PREFIX + cmd;
+	if (zmq_send(m_requestSocket, envelope.data(), envelope.size(), ZMQ_DONTWAIT | (data.empty() ? 0 : ZMQ_SNDMORE)) != int(envelope.size()))
+		return false;
+	return data.empty() || zmq_send(m_requestSocket, data.data(), data.size(), ZMQ_DONTWAIT) == int(data.size());
+}
+
+void CoDevice::enqueue(const std::shared_ptr<CoWait>& wait, std::coroutine_handle<> handle)
+{
+	wait->handle = handle;
+	wait->device = this;
+	m_pending.push_back(wait);
+	m_loop.addTimer(m_loop.m_requestTimeoutMs, wait);
+}
+
+void CoDevice::resetRequests()
+{
+	for (auto& wait : m_pending){
+		if (wait->done)
+			continue;
+		wait->done = true;
+		m_loop.resumeLater(wait->handle);
+	}
+	m_pending.clear();
+	connectRequest();
+}
+
+void CoDevice::readReplies()
+{
+	zmq_msg_t message;
+	zmq_msg_init(&message);
+	while (receiveFrame(m_requestSocket, &message, ZMQ_DONTWAIT)){
+		//delimiter,then the reply
+		if (zmq_msg_size(&message) != 0 || !zmq_msg_more(&message) || !receiveFrame(m_requestSocket, &message, 0)){
+			skipFrames(m_requestSocket, &message);
+			continue;
+		}
+		auto reply = frameString(&message);
+		skipFrames(m_requestSocket, &message);
+		if (m_pending.empty())
+			continue;
+		auto wait = m_pending.front();
+		m_pending.pop_front();
+		if (wait->done)
+			continue;
+		wait->done = true;
+		wait->ok = true;
+		wait->reply = std::move(reply);
+		m_loop.resumeLater(wait->handle);
+	}
+	zmq_msg_close(&message);
+}
+
+void CoDevice::readPublishes()
+{
+	zmq_msg_t message;
+	zmq_msg_init(&message);
+	while (receiveFrame(m_publishSocket, &message, ZMQ_DONTWAIT)){
+		//v1.0/major/minor,then the data unless it is a heartbeat
+		auto envelope = frameString(&message);
+		CoPublish publish;
+		if (zmq_msg_more(&message) && receiveFrame(m_publishSocket, &message, 0))
+			publish.data = decodeText(frameString(&message));
+		skipFrames(m_publishSocket, &message);
+		if (envelope.compare(0, sizeof(ENVELOPE_PREFIX) - 1, ENVELOPE_PREFIX) != 0)
+			continue;
+		envelope.erase(0, sizeof(ENVELOPE_PREFIX) - 1);
+		const auto slash = envelope.find('/');
+		publish.major = envelope.substr(0, slash);
+		if (slash != std::string::npos)
+			publish.minor = envelope.substr(slash + 1, envelope.find('/', slash + 1) - slash - 1);
+		if (publish.major != "hb")
+			deliver(publish);
+	}
+	zmq_msg_close(&message);
+}
+
+void CoDevice::deliver(const CoPublish& publish)
+{
+	for (auto state : m_subscriptions){
+		if (!state->major.empty() && state->major != publish.major)
+			continue;
+		if (!state->minor.empty() && state->minor != publish.minor)
+			continue;
+		state->buffered.push_back(publish);
+		auto wait = state->wait;
+		if (wait && !wait->done){
+			wait->done = true;
+			m_loop.resumeLater(wait->handle);
+		}
+	}
+}
+
+CoDevice::Request<std::string> CoDevice::request(const std::string& cmd, const std::string& data)
+{
+	return Request<std::string>{ this, cmd, data, decodeRaw, nullptr };
+}
+
+CoDevice::Request<bool> CoDevice::deviceCheck()
+{
+	return Request<bool>{ this, "device/check", std::string(), decodeBool, nullptr };
+}
+
+CoDevice::Request<bool> CoDevice::setDevSubType(const std::string& subType)
+{
+	return Request<bool>{ this, "device/devSubType/set", subType, decodeBool, nullptr };
+}
+
+CoDevice::Request<bool> CoDevice::caliEnter()
+{
+	return Request<bool>{ this, "cali/enter", std::string(), decodeBool, nullptr };
+}
+
+CoDevice::Request<bool> CoDevice::caliExit()
+{
+	return Request<bool>{ this, "cali/exit", std::string(), decodeBool, nullptr };
+}
+
+CoDevice::Request<bool> CoDevice::caliSetType(const std::string& type)
+{
+	return Request<bool>{ this, "cali/type/set", type, decodeBool, nullptr };
+}
+
+CoDevice::Request<std::string> CoDevice::caliTime()
+{
+	return Request<std::string>{ this, "cali/time", std::string(), decodeText, nullptr };
+}
+
+CoDevice::Request<int> CoDevice::caliCurrentGroup()
+{
+	return Request<int>{ this, "cali/currentCaliGroup", std::string(), decodeInt, nullptr };
+}
+
+CoDevice::Request<int> CoDevice::caliCurrentDist()
+{
+	return Request<int>{ this, "cali/currentCaliDist", std::string(), decodeInt, nullptr };
+}
+
+CoDevice::Request<bool> CoDevice::caliSetSnapEnabled(bool enabled)
+{
+	return Request<bool>{ this, "cali/snapEnabled/set", enabled ? "1" : "0", decodeBool, nullptr };
+}
+
+CoLoop::CoLoop(void* context, int requestTimeoutMs)
+	: m_context(context), m_requestTimeoutMs(requestTimeoutMs), m_stopped(false)
+{
+}
+
+CoLoop::~CoLoop()
+{
+	//unfinished frames hold subscriptions of the devices
+	m_spawned.clear();
+	for (auto device : m_devices)
+		delete device;
+}
+
+CoDevice* CoLoop::addDevice(const std::string& name, const std::string& requestEndpoint, const std::string& publishEndpoint)
+{
+	auto device = new CoDevice(*this, name, requestEndpoint, publishEndpoint);
+	m_devices.push_back(device);
+	return device;
+}
+
+void CoLoop::spawn(CoTask<bool> task, std::function<void(bool)> done)
+{
+	m_spawned.push_back(Spawned{ std::move(task), done, false });
+}
+
+void CoLoop::Sleep::await_suspend(std::coroutine_handle<> handle)
+{
+	auto wait = std::make_shared<CoWait>();
+	wait->handle = handle;
+	loop->addTimer(ms, wait);
+}
+
+void CoLoop::addTimer(int ms, const std::shared_ptr<CoWait>& wait)
+{
+	m_timers.insert(std::make_pair(Clock::now() + std::chrono::milliseconds(ms), wait));
+}
+
+void CoLoop::fireTimers()
+{
+	const auto now = Clock::now();
+	while (!m_timers.empty() && m_timers.begin()->first <= now){
+		auto wait = m_timers.begin()->second;
+		m_timers.erase(m_timers.begin());
+		if (wait->done)
+			continue;
+		if (wait->device){
+			//the replies of this device are out of step from here on
+			wait->device->resetRequests();
+			continue;
+		}
+		wait->done = true;
+		resumeLater(wait->handle);
+	}
+}
+
+void CoLoop::resumeReady()
+{
+	//a resumed coroutine may make others ready
+	while (!m_ready.empty()){
+		auto ready = std::move(m_ready);
+		m_ready.clear();
+		for (auto handle : ready)
+			handle.resume();
+	}
+}
+
+void CoLoop::startSpawned()
+{
+	//a task may spawn more,the list keeps its iterators
+	for (auto& spawned : m_spawned){
+		if (spawned.started)
+			continue;
+		spawned.started = true;
+		spawned.task.start();
+	}
+}
+
+void CoLoop::sweepSpawned()
+{
+	for (auto it = m_spawned.begin(); it != m_spawned.end();){
+		if (!it->started || !it->task.isDone()){
+			++it;
+			continue;
+		}
+		bool result = false;
+		try{
+			result = it->task.result();
+		}
+		catch (...){
+			result = false;
+		}
+		auto done = it->done;
+		it = m_spawned.erase(it);
+		if (done)
+			done(result);
+	}
+}
+
+void CoLoop::run()
+{
+	std::vector<zmq_pollitem_t> items;
+	while (!m_stopped){
+		startSpawned();
+		resumeReady();
+		sweepSpawned();
+		if (m_spawned.empty())
+			break;
+
+		items.clear();
+		for (auto device : m_devices){
+			zmq_pollitem_t request = { device->m_requestSocket, 0, ZMQ_POLLIN, 0 };
+			zmq_pollitem_t publish = { device->m_publishSocket, 0, ZMQ_POLLIN, 0 };
+			items.push_back(request);
+			items.push_back(publish);
+		}
+		long timeoutMs = MAX_POLL_MS;
+		if (!m_timers.empty()){
+			const auto untilTimer = std::chrono::duration_cast<std::chrono::milliseconds>(m_timers.begin()->first - Clock::now()).count() + 1;
+			timeoutMs = std::max(0L, std::min(timeoutMs, long(untilTimer)));
+		}
+		if (zmq_poll(items.data(), int(items.size()), timeoutMs) < 0)
+			break;
+		for (size_t i = 0; i < m_devices.size(); i++){
+			if (items[i * 2].revents & ZMQ_POLLIN)
+				m_devices[i]->readReplies();
+			if (items[i * 2 + 1].revents & ZMQ_POLLIN)
+				m_devices[i]->readPublishes();
+		}
+		fireTimers();
+	}
+}
+
+std::pair<int, int> coDistanceStates(const std::string& states)
+{
+	int done = 0, total = 0;
+	auto key = states.find("\"states\"");
+	if (key == std::string::npos)
+		return std::make_pair(0, 0);
+	auto open = states.find('[', key);
+	auto close = states.find(']', key);
+	if (open == std::string::npos || close == std::string::npos || close < open)
+		return std::make_pair(0, 0);
+	for (auto pos = open + 1; pos < close; pos++){
+		if (states.compare(pos, 4, "true") == 0){
+			done++;
+			total++;
+			pos += 3;
+		}
+		else if (states.compare(pos, 5, "false") == 0){
+			total++;
+			pos += 4;
+		}
+	}
+	return std::make_pair(done, total);
+}
+
+namespace
+{
+	//type set,then snap on every scanner click until all distances are done
+	CoTask<bool> captureDistances(CoDevice& device, const std::string& caliType, const CoSequenceOptions& options)
+	{
+		CoSubscription publishes(device, std::string());
+		if (!(co_await device.caliSetType(caliType)).value_or(false))
+			co_return false;
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.captureTimeoutMs);
+		for (;;){
+			const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+			if (remaining <= 0)
+				co_return false;
+			auto publish = co_await publishes.next(int(remaining));
+			if (!publish)
+				co_return false;
+			if (publish->major == "device" && publish->minor == "event" && publish->data == "DE_CLICK"){
+				co_await device.caliSetSnapEnabled(true);
+			}
+			else if (publish->major == "cali" && publish->minor == "caliDistStates"){
+				const auto states = coDistanceStates(publish->data);
+				if (states.second && states.first == states.second)
+					co_return true;
+			}
+		}
+	}
+}
+
+CoTask<bool> calibrationSequence(CoDevice& device, std::string subType, std::string caliType, CoSequenceOptions options)
+{
+	//device check and enter end with finishAsyncAction,subscribed before the request goes out
+	CoSubscription asyncActions(device, "finishAsyncAction");
+	if (!(co_await device.deviceCheck()).value_or(false))
+		co_return false;
+	if (!co_await asyncActions.next(options.asyncActionTimeoutMs))
+		co_return false;
+	if (!(co_await device.setDevSubType(subType)).value_or(false))
+		co_return false;
+	if (!(co_await device.caliEnter()).value_or(false))
+		co_return false;
+
+	bool ok = false;
+	if (co_await asyncActions.next(options.asyncActionTimeoutMs))
+		ok = co_await captureDistances(device, caliType, options);
+	//exit is owed once enter succeeded
+	const auto exited = co_await device.caliExit();
+	co_return ok && exited.value_or(false);
+}
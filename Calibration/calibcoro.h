@@ -0,0 +1,307 @@
+#ifndef CALIB_CORO_H
+#define CALIB_CORO_H
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+/*
+C++20 coroutine face of the SDK protocol,built with CALIBRATION_COROUTINES.
+One CoLoop thread owns the sockets of every device and resumes the coroutines waiting on them:
+a request is a co_await on its reply,a publish is a co_await on a CoSubscription.
+Requests of a device share one DEALER socket and are answered in order,so many sequences
+and many requests in flight cost no thread each.Everything here is used from the loop thread only.
+*/
+class CoLoop;
+class CoDevice;
+
+/*
+Lazily started coroutine returning T,started by co_await or CoLoop::spawn
+*/
+template<typename T>
+class CoTask
+{
+public:
+	struct promise_type
+	{
+		std::optional<T> value;
+		std::exception_ptr error;
+		std::coroutine_handle<> continuation;
+
+		CoTask get_return_object() { return CoTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		//hand control back to the awaiting coroutine
+		auto final_suspend() noexcept
+		{
+			struct Final
+			{
+				bool await_ready() noexcept { return false; }
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+				{
+					auto continuation = handle.promise().continuation;
+					return continuation ? continuation : std::noop_coroutine();
+				}
+				void await_resume() noexcept {}
+			};
+			return Final{};
+		}
+		void return_value(T result) { value = std::move(result); }
+		void unhandled_exception() { error = std::current_exception(); }
+	};
+
+	CoTask(CoTask&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+	CoTask(const CoTask&) = delete;
+	CoTask& operator=(const CoTask&) = delete;
+	~CoTask()
+	{
+		if (m_handle)
+			m_handle.destroy();
+	}
+
+	bool await_ready() const noexcept { return false; }
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+	{
+		m_handle.promise().continuation = awaiting;
+		return m_handle;
+	}
+	T await_resume() { return result(); }
+
+	//driven by CoLoop for spawned tasks
+	void start() { m_handle.resume(); }
+	bool isDone() const { return m_handle.done(); }
+	T result()
+	{
+		auto& promise = m_handle.promise();
+		if (promise.error)
+			std::rethrow_exception(promise.error);
+		return std::move(*promise.value);
+	}
+private:
+	explicit CoTask(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+	std::coroutine_handle<promise_type> m_handle;
+};
+
+struct CoPublish
+{
+	std::string major;
+	std::string minor;
+	std::string data;
+};
+
+/*
+Publishes of one device matching major(and minor when not empty),buffered from construction on,
+so a publish that answers a request is not lost while the request is still in flight.
+An empty major matches every publish but the heartbeat.
+*/
+class CoSubscription
+{
+public:
+	CoSubscription(CoDevice& device, const std::string& major, const std::string& minor = std::string());
+	~CoSubscription();
+	CoSubscription(const CoSubscription&) = delete;
+	CoSubscription& operator=(const CoSubscription&) = delete;
+
+	struct State;
+	/*
+	Next buffered or arriving publish,empty after timeoutMs
+	*/
+	struct Next
+	{
+		CoSubscription* subscription;
+		int timeoutMs;
+		bool await_ready() const;
+		void await_suspend(std::coroutine_handle<> handle);
+		std::optional<CoPublish> await_resume();
+	};
+	Next next(int timeoutMs) { return Next{ this, timeoutMs }; }
+private:
+	CoDevice& m_device;
+	std::shared_ptr<State> m_state;
+};
+
+/*
+Every waiting coroutine,resumed once by whichever of reply,publish or timer comes first
+*/
+struct CoWait
+{
+	std::coroutine_handle<> handle;
+	bool done = false;
+	bool ok = false;
+	std::string reply;
+	CoDevice* device = nullptr;//set for requests,their timeout resets the device's request socket
+};
+
+class CoDevice
+{
+public:
+	const std::string& name() const { return m_name; }
+
+	/*
+	Awaitable SDK request,the reply decoded by decode,empty when it failed or timed out
+	*/
+	template<typename T>
+	struct Request
+	{
+		CoDevice* device;
+		std::string cmd;
+		std::string data;
+		T (*decode)(const std::string&);
+		std::shared_ptr<CoWait> wait;
+
+		bool await_ready() { return device->send(*this); }
+		void await_suspend(std::coroutine_handle<> handle) { device->enqueue(wait, handle); }
+		std::optional<T> await_resume()
+		{
+			if (!wait->ok)
+				return std::nullopt;
+			return decode(wait->reply);
+		}
+	};
+
+	/*
+	cmd:envelope without the version prefix,e.g. cali/enter
+	*/
+	Request<std::string> request(const std::string& cmd, const std::string& data = std::string());
+	Request<bool> deviceCheck();
+	/*
+	subType:DST_PRO or DST_PRO_PLUS
+	*/
+	Request<bool> setDevSubType(const std::string& subType);
+	Request<bool> caliEnter();
+	Request<bool> caliExit();
+	/*
+	type:CT_STEREO,CT_WHITE_BALANCE,CT_HD or CT_DEFINITION
+	*/
+	Request<bool> caliSetType(const std::string& type);
+	Request<std::string> caliTime();
+	Request<int> caliCurrentGroup();
+	Request<int> caliCurrentDist();
+	Request<bool> caliSetSnapEnabled(bool enabled);
+private:
+	friend class CoLoop;
+	friend class CoSubscription;
+	CoDevice(CoLoop& loop, const std::string& name, const std::string& requestEndpoint, const std::string& publishEndpoint);
+	~CoDevice();
+
+	bool connectRequest();
+	//writes the request,true when it failed and there is nothing to wait for
+	template<typename T>
+	bool send(Request<T>& request)
+	{
+		request.wait = std::make_shared<CoWait>();
+		return !write(request.cmd, request.data);
+	}
+	bool write(const std::string& cmd, const std::string& data);
+	void enqueue(const std::shared_ptr<CoWait>& wait, std::coroutine_handle<> handle);
+	void readReplies();
+	void readPublishes();
+	void deliver(const CoPublish& publish);
+	//replies still owed are lost with the socket,their requests fail
+	void resetRequests();
+
+	CoLoop& m_loop;
+	std::string m_name;
+	std::string m_requestEndpoint;
+	void* m_requestSocket = nullptr;
+	void* m_publishSocket = nullptr;
+	std::deque<std::shared_ptr<CoWait> > m_pending;
+	std::vector<CoSubscription::State*> m_subscriptions;
+};
+
+class CoLoop
+{
+public:
+	/*
+	context:ZMQ context,terminated by the caller after the loop is gone
+	requestTimeoutMs:an unanswered request fails after this and resets the device's request socket
+	*/
+	explicit CoLoop(void* context, int requestTimeoutMs = 10000);
+	~CoLoop();
+	CoLoop(const CoLoop&) = delete;
+	CoLoop& operator=(const CoLoop&) = delete;
+
+	/*
+	publishEndpoint:SDK PUB socket,requestEndpoint:SDK REP socket,e.g. tcp://host:port
+	*/
+	CoDevice* addDevice(const std::string& name, const std::string& requestEndpoint, const std::string& publishEndpoint);
+	/*
+	Start task on the next run,done is called with its result
+	*/
+	void spawn(CoTask<bool> task, std::function<void(bool)> done = std::function<void(bool)>());
+
+	struct Sleep
+	{
+		CoLoop* loop;
+		int ms;
+		bool await_ready() const { return ms <= 0; }
+		void await_suspend(std::coroutine_handle<> handle);
+		void await_resume() const {}
+	};
+	Sleep sleep(int ms) { return Sleep{ this, ms }; }
+
+	/*
+	Poll until every spawned task finished or stop was called
+	*/
+	void run();
+	//any thread
+	void stop() { m_stopped = true; }
+	int liveTasks() const { return int(m_spawned.size()); }
+	int requestTimeoutMs() const { return m_requestTimeoutMs; }
+private:
+	friend class CoDevice;
+	friend class CoSubscription;
+	typedef std::chrono::steady_clock Clock;
+	void addTimer(int ms, const std::shared_ptr<CoWait>& wait);
+	void fireTimers();
+	//resumed after the socket that satisfied them has been drained
+	void resumeLater(std::coroutine_handle<> handle) { m_ready.push_back(handle); }
+	void resumeReady();
+	void startSpawned();
+	void sweepSpawned();
+
+	void* m_context = nullptr;
+	int m_requestTimeoutMs = 0;
+	std::vector<CoDevice*> m_devices;
+	std::multimap<Clock::time_point, std::shared_ptr<CoWait> > m_timers;
+	std::vector<std::coroutine_handle<> > m_ready;
+	struct Spawned
+	{
+		CoTask<bool> task;
+		std::function<void(bool)> done;
+		bool started;
+	};
+	std::list<Spawned> m_spawned;
+	std::atomic<bool> m_stopped;
+};
+
+/*
+Timeouts of calibrationSequence,in ms
+*/
+struct CoSequenceOptions
+{
+	int asyncActionTimeoutMs = 30000;//finishAsyncAction after device check and enter
+	int captureTimeoutMs = 600000;//every distance snapped
+};
+
+/*
+device check -> sub type -> enter -> type set -> capture -> exit,like CalibrationSequencer.
+A DE_CLICK of the scanner snaps during capture,exit is sent whenever enter succeeded.
+*/
+CoTask<bool> calibrationSequence(CoDevice& device, std::string subType, std::string caliType, CoSequenceOptions options = CoSequenceOptions());
+
+/*
+states:caliDistStates payload,{"states":[true,false,...]}
+Returns the done and total distance counts,total 0 when the payload is not understood
+*/
+std::pair<int, int> coDistanceStates(const std::string& states);
+
+#endif // CALIB_CORO_H
@@ -0,0 +1,152 @@
+#include "calibrationclient.h"
+#include <QElapsedTimer>
+#include <QtDebug>
+#include "tracing.h"
+
+CalibrationClient::CalibrationClient(void* reqSocket)
+	: m_client(reqSocket)
+{
+	m_roundTripMetric = MetricsRegistry::instance().histogram("calib_request_seconds", "SDK request round trip time");
+	m_failureMetric = MetricsRegistry::instance().counter("calib_request_failures_total", "SDK requests that could not be delivered");
+}
+
+bool CalibrationClient::connect(void* context, const QString& endpoint, bool pipelined, int timeoutMs, const SocketTuning& tuning)
+{
+	m_client.setSocketOptions([tuning](void* socket){ tuning.apply(socket); });
+	if (!m_client.connect(context, endpoint.toStdString(), pipelined, timeoutMs)){
+		qCritical() << "cannot connect the request socket" << QString::fromStdString(m_client.lastError());
+		return false;
+	}
+	return true;
+}
+
+bool CalibrationClient::request(const QString& cmd, const QByteArray& data, QByteArray* reply)
+{
+	TRACE_SCOPE("request");
+	QElapsedTimer roundTrip;
+	roundTrip.start();
+	std::string frame;
+	if (!m_client.request(cmd.toStdString(), std::string(data.constData(), size_t(data.size())), &frame)){
+		qCritical() << "SDK request error!" << QString::fromStdString(m_client.lastError());
+		m_failureMetric->inc();
+		return false;
+	}
+	if (reply)
+		*reply = QByteArray(frame.data(), int(frame.size()));
+	m_roundTripMetric->observe(roundTrip.nsecsElapsed());
+	return true;
+}
+
+bool CalibrationClient::run(const CalibBatch& batch)
+{
+	TRACE_SCOPE("requestBatch");
+	QElapsedTimer roundTrip;
+	roundTrip.start();
+	if (!m_client.run(batch)){
+		qCritical() << "SDK batch error!" << QString::fromStdString(m_client.lastError());
+		m_failureMetric->inc();
+		return false;
+	}
+	m_roundTripMetric->observe(roundTrip.nsecsElapsed());
+	return true;
+}
+
+bool CalibrationClient::replyBool(const QByteArray& reply)
+{
+	return replyInt(reply) != 0;
+}
+
+int CalibrationClient::replyInt(const QByteArray& reply)
+{
+	return CalibClient::replyInt(std::string(reply.constData(), size_t(reply.size())));
+}
+
+bool CalibrationClient::pull(QJsonDocument* result)
+{
+	QByteArray reply;
+	if (!request(QStringLiteral("pull"), QByteArray(), &reply))
+		return false;
+	*result = QJsonDocument::fromJson(reply);
+	return true;
+}
+
+bool CalibrationClient::deviceCheck(bool* result)
+{
+	QByteArray reply;
+	if (!request(QStringLiteral("device/check"), QByteArray(), &reply))
+		return false;
+	*result = replyBool(reply);
+	return true;
+}
+
+bool CalibrationClient::setDevSubType(const QString& subType, bool* result)
+{
+	QByteArray reply;
+	if (!request(QStringLiteral("device/devSubType/set"), subType.toLatin1(), &reply))
+		return false;
+	*result = replyBool(reply);
+	return true;
+}
+
+bool CalibrationClient::caliEnter(bool* result)
+{
+	QByteArray reply;
+	if (!request(QStringLiteral("cali/enter"), QByteArray(), &reply))
+		return false;
+	*result = replyBool(reply);
+	return true;
+}
+
+bool CalibrationClient::caliExit(bool* result)
+{
+	QByteArray reply;
+	if (!request(QStringLiteral("cali/exit"), QByteArray(), &reply))
+		return false;
+	*result = replyBool(reply);
+	return true;
+}
+
+bool CalibrationClient::caliSetType(const QString& type, bool* result)
+{
+	QByteArray reply;
+	if (!request(QStringLiteral("cali/type/set"), type.toLatin1(), &reply))
+		return false;
+	*result = replyBool(reply);
+	return true;
+}
+
+bool CalibrationClient::caliTime(QString* time)
+{
+	QByteArray reply;
+	if (!request(QStringLiteral("cali/time"), QByteArray(), &reply))
+		return false;
+	*time = QString(reply.constData());
+	return true;
+}
+
+bool CalibrationClient::caliCurrentGroup(int* group)
+{
+	QByteArray reply;
+	if (!request(QStringLiteral("cali/currentCaliGroup"), QByteArray(), &reply))
+		return false;
+	*group = replyInt(reply);
+	return true;
+}
+
+bool CalibrationClient::caliCurrentDist(int* dist)
+{
+	QByteArray reply;
+	if (!request(QStringLiteral("cali/currentCaliDist"), QByteArray(), &reply))
+		return false;
+	*dist = replyInt(reply);
+	return true;
+}
+
+bool CalibrationClient::caliSetSnapEnabled(bool enabled, bool* result)
+{
+	QByteArray reply;
+	if (!request(QStringLiteral("cali/snapEnabled/set"), QByteArray(enabled ? "1" : "0"), &reply))
+		return false;
+	*result = replyBool(reply);
+	return true;
+}
@@ -0,0 +1,68 @@
+#ifndef CALIBRATION_CLIENT_H
+#define CALIBRATION_CLIENT_H
+
+#include <QString>
+#include <QByteArray>
+#include <QJsonDocument>
+#include <cerrno>
+#include "metrics.h"
+#include "sockettuning.h"
+#include "calibclient.h"
+/*
+Qt face of CalibClient shared by the GUI and the headless runner,adds logging and the request metrics.
+Every call blocks until its reply,returns false when the request could not be delivered.
+*/
+class CalibrationClient
+{
+public:
+	explicit CalibrationClient(void* reqSocket = nullptr);
+
+	void setSocket(void* reqSocket) { m_client.setSocket(reqSocket); }
+	void* socket() const { return m_client.socket(); }
+	/*
+	Connect a socket of our own instead,DEALER when pipelined,with tuning applied before it connects
+	timeoutMs:a request not sent or answered by then fails and timedOut() is true,the socket is replaced before the next one
+	*/
+	bool connect(void* context, const QString& endpoint, bool pipelined, int timeoutMs, const SocketTuning& tuning);
+	void close() { m_client.close(); }
+	bool timedOut() const { return m_client.lastErrno() == EAGAIN; }
+	/*
+	cmd:envelope without the version prefix,e.g. cali/enter
+	data:optional second frame
+	reply:first reply frame
+	*/
+	bool request(const QString& cmd, const QByteArray& data, QByteArray* reply);
+	/*
+	Requests of the batch in one go,pipelined when the socket is a DEALER
+	*/
+	bool run(const CalibBatch& batch);
+
+	bool pull(QJsonDocument* result);
+	bool deviceCheck(bool* result);
+	/*
+	subType:DST_PRO or DST_PRO_PLUS
+	*/
+	bool setDevSubType(const QString& subType, bool* result);
+	bool caliEnter(bool* result);
+	bool caliExit(bool* result);
+	/*
+	type:CT_STEREO,CT_WHITE_BALANCE,CT_HD or CT_DEFINITION
+	*/
+	bool caliSetType(const QString& type, bool* result);
+	bool caliTime(QString* time);
+	bool caliCurrentGroup(int* group);
+	bool caliCurrentDist(int* dist);
+	bool caliSetSnapEnabled(bool enabled, bool* result);
+
+	/*
+	Replies of device,set and enter/exit requests are a native int used as bool
+	*/
+	static bool replyBool(const QByteArray& reply);
+	static int replyInt(const QByteArray& reply);
+private:
+	CalibClient m_client;
+	MetricHistogram* m_roundTripMetric = nullptr;
+	MetricCounter* m_failureMetric = nullptr;
+};
+
+#endif // CALIBRATION_CLIENT_H
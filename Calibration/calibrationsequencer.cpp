@@ -0,0 +1,247 @@
+#include "calibrationsequencer.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QStringList>
+#include <QtDebug>
+#include <cerrno>
+#include "calibrationclient.h"
+#include "sdkmessage.h"
+
+CalibrationSequencer::CalibrationSequencer(void* context, const QString& requestAddr, const SocketTuning& tuning, QObject *parent)
+	: QObject(parent)
+{
+	m_requester = new AsyncRequester(context, requestAddr, tuning, this);
+	connect(m_requester, &AsyncRequester::replied, this, &CalibrationSequencer::onReply);
+
+	//device check and enter start an SDK async action,the step is over when it finishes
+	m_policies[SS_DEVICE_CHECK].timeoutMs = 10000;
+	m_policies[SS_DEVICE_CHECK].awaitAsyncAction = true;
+	m_policies[SS_ENTER].timeoutMs = 30000;
+	m_policies[SS_ENTER].retries = 0;
+	m_policies[SS_ENTER].awaitAsyncAction = true;
+	//an operator snaps every distance by hand
+	m_policies[SS_CAPTURE].timeoutMs = 600000;
+	m_policies[SS_CAPTURE].retries = 0;
+
+	m_stepTimer.setSingleShot(true);
+	connect(&m_stepTimer, &QTimer::timeout, this, &CalibrationSequencer::onStepTimeout);
+}
+
+const char* CalibrationSequencer::stepName(SequenceStep step)
+{
+	switch (step){
+	case SS_DEVICE_CHECK: return "deviceCheck";
+	case SS_SUB_TYPE: return "subType";
+	case SS_ENTER: return "enter";
+	case SS_TYPE_SET: return "typeSet";
+	case SS_CAPTURE: return "capture";
+	case SS_EXIT: return "exit";
+	default: return "unknown";
+	}
+}
+
+void CalibrationSequencer::start(const QString& subType, const QString& caliType)
+{
+	if (m_running){
+		qWarning() << "calibration sequence already running";
+		return;
+	}
+	m_subType = subType;
+	m_caliType = caliType;
+	m_running = true;
+	m_entered = false;
+	m_failure = SR_SUCCESS;
+	m_failedStep = SS_COUNT;
+	for (int i = 0; i < SS_COUNT; i++){
+		m_records[i] = StepRecord();
+		if (!m_stepMetrics[i]){
+			m_stepMetrics[i] = MetricsRegistry::instance().histogram("calib_sequence_step_seconds", "Duration of one calibration sequence step",
+				QString("device=\"%1\",step=\"%2\"").arg(m_deviceName, stepName(SequenceStep(i))));
+		}
+	}
+	enterStep(SS_DEVICE_CHECK);
+}
+
+void CalibrationSequencer::abort()
+{
+	if (m_running)
+		fail(SR_ABORTED);
+}
+
+void CalibrationSequencer::enterStep(SequenceStep step)
+{
+	m_step = step;
+	m_stepOpen = true;
+	m_attempt = 0;
+	m_stepClock.start();
+	qInfo() << "calibration step" << stepName(step);
+	emit stepStarted(step);
+	if (step == SS_CAPTURE){
+		m_records[step].attempts = 1;
+		m_stepTimer.start(m_policies[step].timeoutMs);
+		return;
+	}
+	sendStepRequest();
+}
+
+void CalibrationSequencer::sendStepRequest()
+{
+	m_attempt++;
+	m_records[m_step].attempts = m_attempt;
+	m_replied = false;
+	m_asyncFinished = false;
+	m_stepTimer.start(m_policies[m_step].timeoutMs);
+
+	int error = 0;
+	switch (m_step){
+	case SS_DEVICE_CHECK: error = m_requester->send(QStringLiteral("device/check")); break;
+	case SS_SUB_TYPE: error = m_requester->send(QStringLiteral("device/devSubType/set"), m_subType.toLatin1()); break;
+	case SS_ENTER: error = m_requester->send(QStringLiteral("cali/enter")); break;
+	case SS_TYPE_SET: error = m_requester->send(QStringLiteral("cali/type/set"), m_caliType.toLatin1()); break;
+	case SS_EXIT: error = m_requester->send(QStringLiteral("cali/exit")); break;
+	default: break;
+	}
+	m_pending = RK_STEP;
+	//not connected yet,the step timer resends
+	if (error == EAGAIN)
+		qWarning() << stepName(m_step) << "request not sent,SDK not connected";
+	else if (error)
+		completeStep(false);
+}
+
+void CalibrationSequencer::onReply(QByteArray reply)
+{
+	auto kind = m_pending;
+	m_pending = RK_NONE;
+	if (kind == RK_SNAP){
+		qInfo() << "snap:" << CalibrationClient::replyBool(reply);
+		return;
+	}
+	if (!m_running || !m_stepOpen)
+		return;
+	if (!CalibrationClient::replyBool(reply)){
+		qWarning() << stepName(m_step) << "rejected by the SDK";
+		completeStep(false);
+		return;
+	}
+	m_replied = true;
+	if (!m_policies[m_step].awaitAsyncAction || m_asyncFinished)
+		completeStep(true);
+}
+
+void CalibrationSequencer::onPublishReceived(QString majorCmd, QString minorCmd, QByteArray data)
+{
+	if (!m_running || !m_stepOpen)
+		return;
+	if (majorCmd == QStringLiteral("finishAsyncAction")){
+		if (!m_policies[m_step].awaitAsyncAction || m_attempt == 0)
+			return;
+		m_asyncFinished = true;
+		if (m_replied)
+			completeStep(true);
+	}
+	else if (m_step != SS_CAPTURE){
+		return;
+	}
+	else if (majorCmd == QStringLiteral("device") && minorCmd == QStringLiteral("event")){
+		if (QString(data) != "DE_CLICK")
+			return;
+		if (m_requester->isPending()){
+			qWarning() << "DE_CLICK ignored,previous request still pending";
+			return;
+		}
+		if (!m_requester->send(QStringLiteral("cali/snapEnabled/set"), QByteArray("1")))
+			m_pending = RK_SNAP;
+	}
+	else if (majorCmd == QStringLiteral("cali") && minorCmd == QStringLiteral("caliDistStates")){
+		const auto states = distanceStates(data);
+		if (states.isEmpty())
+			return;
+		const int done = states.count(true);
+		qInfo() << "distances done:" << done << "/" << states.count();
+		if (done == states.count())
+			completeStep(true);
+	}
+}
+
+void CalibrationSequencer::onStepTimeout()
+{
+	if (!m_running || !m_stepOpen)
+		return;
+	if (m_step != SS_CAPTURE && m_attempt <= m_policies[m_step].retries){
+		qWarning() << stepName(m_step) << "timed out after" << m_policies[m_step].timeoutMs << "ms,retrying";
+		sendStepRequest();
+		return;
+	}
+	qWarning() << stepName(m_step) << "timed out after" << m_attempt << "attempts";
+	fail(SR_TIMEOUT);
+}
+
+void CalibrationSequencer::endStep(bool ok)
+{
+	m_stepOpen = false;
+	m_stepTimer.stop();
+	auto& record = m_records[m_step];
+	record.durationNs = m_stepClock.nsecsElapsed();
+	record.ok = ok;
+	m_stepMetrics[m_step]->observe(record.durationNs);
+	emit stepFinished(m_step, record.durationNs, ok);
+}
+
+void CalibrationSequencer::completeStep(bool ok)
+{
+	endStep(ok);
+	if (!ok){
+		fail(SR_REJECTED);
+		return;
+	}
+	if (m_step == SS_ENTER)
+		m_entered = true;
+	if (m_step == SS_EXIT){
+		m_entered = false;
+		finish(m_failure);
+		return;
+	}
+	enterStep(SequenceStep(m_step + 1));
+}
+
+void CalibrationSequencer::fail(SequenceResult result)
+{
+	if (m_stepOpen)
+		endStep(false);
+	//keep the first failure,cleanup errors are secondary
+	if (m_failure == SR_SUCCESS){
+		m_failure = result;
+		m_failedStep = m_step;
+	}
+	if (m_entered && m_step != SS_EXIT){
+		enterStep(SS_EXIT);
+		return;
+	}
+	finish(m_failure);
+}
+
+void CalibrationSequencer::finish(SequenceResult result)
+{
+	m_running = false;
+	m_stepTimer.stop();
+	qInfo().noquote() << "calibration sequence" << (result == SR_SUCCESS ? "succeeded" : "failed") << "\n" << report();
+	emit finished(result, m_failedStep);
+}
+
+QString CalibrationSequencer::report() const
+{
+	QStringList lines;
+	qint64 totalNs = 0;
+	for (int i = 0; i < SS_COUNT; i++){
+		const auto& record = m_records[i];
+		if (!record.attempts)
+			continue;
+		totalNs += record.durationNs;
+		lines << QString("  %1 %2 ms attempts=%3 %4").arg(stepName(SequenceStep(i)), -12)
+			.arg(record.durationNs / 1e6, 10, 'f', 1).arg(record.attempts).arg(record.ok ? "ok" : "failed");
+	}
+	lines << QString("  %1 %2 ms").arg("total", -12).arg(totalNs / 1e6, 10, 'f', 1);
+	return lines.join('\n');
+}
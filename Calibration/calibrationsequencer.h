@@ -0,0 +1,140 @@
+#ifndef CALIBRATION_SEQUENCER_H
+#define CALIBRATION_SEQUENCER_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+#include "sockettuning.h"
+#include "asyncrequester.h"
+#include "metrics.h"
+/*
+Steps of one calibration run,in order
+*/
+enum SequenceStep
+{
+	SS_DEVICE_CHECK = 0,
+	SS_SUB_TYPE,
+	SS_ENTER,
+	SS_TYPE_SET,
+	SS_CAPTURE,//all groups/distances snapped,driven by the scanner button
+	SS_EXIT,
+	SS_COUNT
+};
+
+enum SequenceResult
+{
+	SR_SUCCESS = 0,
+	SR_REJECTED,//the SDK answered false or a request could not be sent
+	SR_TIMEOUT,//a step ran out of time and retries
+	SR_ABORTED//abort() was called
+};
+
+/*
+Timeout and retry budget of one step
+*/
+struct StepPolicy
+{
+	int timeoutMs = 5000;
+	int retries = 1;//resends after a timeout,a false reply is never retried
+	bool awaitAsyncAction = false;//the step ends with finishAsyncAction,not with the reply
+};
+
+/*
+Calibration flow as an explicit state machine:
+device check -> sub type -> enter -> type set -> capture -> exit
+Requests go out through an AsyncRequester so the event loop never blocks,
+publishes are fed in through onPublishReceived.
+Every step is timed so a run can be broken down afterwards.
+*/
+class CalibrationSequencer : public QObject
+{
+	Q_OBJECT
+public:
+	/*
+	context:ZMQ context of the device,requestAddr:SDK REQ endpoint
+	*/
+	CalibrationSequencer(void* context, const QString& requestAddr, const SocketTuning& tuning = SocketTuning(),
+		QObject *parent = nullptr);
+
+	/*
+	Set up before start
+	*/
+	void setPolicy(SequenceStep step, const StepPolicy& policy) { m_policies[step] = policy; }
+	const StepPolicy& policy(SequenceStep step) const { return m_policies[step]; }
+	void setDeviceName(const QString& name) { m_deviceName = name; }
+	/*
+	subType:DST_PRO or DST_PRO_PLUS
+	caliType:CT_STEREO,CT_WHITE_BALANCE,CT_HD or CT_DEFINITION
+	*/
+	void start(const QString& subType, const QString& caliType);
+	void abort();
+	bool isRunning() const { return m_running; }
+
+	struct StepRecord
+	{
+		qint64 durationNs = 0;
+		int attempts = 0;
+		bool ok = false;
+	};
+	const StepRecord& record(SequenceStep step) const { return m_records[step]; }
+	/*
+	One line per step with duration and attempts,logged when the run ends
+	*/
+	QString report() const;
+	/*
+	Close the request socket,called before the context terminates
+	*/
+	void close() { m_requester->close(); }
+	static const char* stepName(SequenceStep step);
+signals:
+	void stepStarted(int step);
+	void stepFinished(int step, qint64 durationNs, bool ok);
+	/*
+	result:SequenceResult,failedStep:SS_COUNT on success
+	*/
+	void finished(int result, int failedStep);
+public slots:
+	void onPublishReceived(QString majorCmd, QString minorCmd, QByteArray data);
+private slots:
+	void onReply(QByteArray reply);
+	void onStepTimeout();
+private:
+	enum RequestKind
+	{
+		RK_NONE,
+		RK_STEP,
+		RK_SNAP
+	};
+	void enterStep(SequenceStep step);
+	void sendStepRequest();
+	void endStep(bool ok);
+	void completeStep(bool ok);
+	void fail(SequenceResult result);
+	void finish(SequenceResult result);
+
+	AsyncRequester* m_requester = nullptr;
+	QString m_deviceName;
+	StepPolicy m_policies[SS_COUNT];
+	StepRecord m_records[SS_COUNT];
+	MetricHistogram* m_stepMetrics[SS_COUNT] = {};
+
+	QString m_subType;
+	QString m_caliType;
+	bool m_running = false;
+	bool m_entered = false;//cali/exit is owed to the SDK
+	SequenceStep m_step = SS_DEVICE_CHECK;
+	bool m_stepOpen = false;
+	int m_attempt = 0;
+	bool m_replied = false;
+	bool m_asyncFinished = false;
+	RequestKind m_pending = RK_NONE;
+	SequenceResult m_failure = SR_SUCCESS;
+	SequenceStep m_failedStep = SS_COUNT;
+	QTimer m_stepTimer;
+	QElapsedTimer m_stepClock;
+};
+
+#endif // CALIBRATION_SEQUENCER_H
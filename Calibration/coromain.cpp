@@ -0,0 +1,235 @@
+#include <zmq.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include "calibcoro.h"
+/*
+Calibration-Coroutines [--mock n] [--device name reqEndpoint pubEndpoint]... [--sub-type t] [--cali-type t] [--timeout-ms ms]
+Runs calibrationSequence on every device at once,all on one CoLoop thread.
+--mock serves n scanners from an in-process SDK that answers every request,publishes finishAsyncAction
+after device check and enter,and clicks the scanner button until its five distances are snapped.
+*/
+namespace
+{
+	const int MOCK_DISTANCES = 5;
+	const int MOCK_ASYNC_ACTION_MS = 20;
+	const int MOCK_CLICK_MS = 10;
+	const int MOCK_HEARTBEAT_MS = 50;
+
+	typedef std::chrono::steady_clock Clock;
+
+	void publish(void* socket, const std::string& envelope, const std::string& data)
+	{
+		zmq_send(socket, envelope.data(), envelope.size(), data.empty() ? 0 : ZMQ_SNDMORE);
+		if (!data.empty())
+			zmq_send(socket, data.data(), data.size(), 0);
+	}
+
+	class MockSdk
+	{
+	public:
+		MockSdk(void* context, int devices)
+		{
+			for (int i = 0; i < devices; i++){
+				Device device;
+				device.reply = zmq_socket(context, ZMQ_REP);
+				device.publish = zmq_socket(context, ZMQ_PUB);
+				zmq_bind(device.reply, requestEndpoint(i).c_str());
+				zmq_bind(device.publish, publishEndpoint(i).c_str());
+				m_devices.push_back(device);
+			}
+			m_thread = std::thread([this]{ serve(); });
+		}
+
+		~MockSdk()
+		{
+			m_stopped = true;
+			m_thread.join();
+			for (auto& device : m_devices){
+				zmq_close(device.reply);
+				zmq_close(device.publish);
+			}
+		}
+
+		static std::string requestEndpoint(int i) { return "inproc://mock-req-" + std::to_string(i); }
+		static std::string publishEndpoint(int i) { return "inproc://mock-pub-" + std::to_string(i); }
+	private:
+		struct Device
+		{
+			void* reply = nullptr;
+			void* publish = nullptr;
+			int snapped = 0;
+			bool capturing = false;
+		};
+		struct Due
+		{
+			int device;
+			std::string envelope;
+			std::string data;
+		};
+
+		void later(int device, int ms, const std::string& envelope, const std::string& data = std::string())
+		{
+			m_due.insert(std::make_pair(Clock::now() + std::chrono::milliseconds(ms), Due{ device, envelope, data }));
+		}
+
+		std::string states(const Device& device) const
+		{
+			std::string json = "{\"states\":[";
+			for (int i = 0; i < MOCK_DISTANCES; i++)
+				json += std::string(i ? "," : "") + (i < device.snapped ? "true" : "false");
+			return json + "]}";
+		}
+
+		int answer(int index, const std::string& cmd)
+		{
+			auto& device = m_devices[index];
+			if (cmd == "v1.0/device/check" || cmd == "v1.0/cali/enter"){
+				later(index, MOCK_ASYNC_ACTION_MS, "v1.0/finishAsyncAction", "{}");
+				if (cmd == "v1.0/cali/enter")
+					device.snapped = 0;
+				return 1;
+			}
+			if (cmd == "v1.0/cali/type/set"){
+				device.capturing = true;
+				later(index, MOCK_CLICK_MS, "v1.0/device/event", "DE_CLICK");
+				return 1;
+			}
+			if (cmd == "v1.0/cali/snapEnabled/set"){
+				if (!device.capturing)
+					return 0;
+				device.snapped++;
+				later(index, 0, "v1.0/cali/caliDistStates", states(device));
+				if (device.snapped < MOCK_DISTANCES)
+					later(index, MOCK_CLICK_MS, "v1.0/device/event", "DE_CLICK");
+				else
+					device.capturing = false;
+				return 1;
+			}
+			if (cmd == "v1.0/cali/exit"){
+				device.capturing = false;
+				return 1;
+			}
+			return cmd == "v1.0/device/devSubType/set" ? 1 : 0;
+		}
+
+		void serve()
+		{
+			std::vector<zmq_pollitem_t> items;
+			for (auto& device : m_devices){
+				zmq_pollitem_t item = { device.reply, 0, ZMQ_POLLIN, 0 };
+				items.push_back(item);
+			}
+			auto heartbeat = Clock::now();
+			while (!m_stopped){
+				zmq_poll(items.data(), int(items.size()), 1);
+				for (size_t i = 0; i < items.size(); i++){
+					if (!(items[i].revents & ZMQ_POLLIN))
+						continue;
+					char envelope[256] = { 0 };
+					const int size = zmq_recv(m_devices[i].reply, envelope, sizeof(envelope) - 1, 0);
+					int more = 0;
+					size_t moreSize = sizeof(more);
+					while (zmq_getsockopt(m_devices[i].reply, ZMQ_RCVMORE, &more, &moreSize) == 0 && more){
+						char data[256];
+						zmq_recv(m_devices[i].reply, data, sizeof(data), 0);
+					}
+					const int result = size > 0 ? answer(int(i), std::string(envelope, size_t(size))) : 0;
+					zmq_send(m_devices[i].reply, &result, sizeof(result), 0);
+				}
+				const auto now = Clock::now();
+				while (!m_due.empty() && m_due.begin()->first <= now){
+					const auto& due = m_due.begin()->second;
+					publish(m_devices[due.device].publish, due.envelope, due.data);
+					m_due.erase(m_due.begin());
+				}
+				if (now - heartbeat >= std::chrono::milliseconds(MOCK_HEARTBEAT_MS)){
+					for (auto& device : m_devices)
+						publish(device.publish, "v1.0/hb", std::string());
+					heartbeat = now;
+				}
+			}
+		}
+
+		std::vector<Device> m_devices;
+		std::multimap<Clock::time_point, Due> m_due;
+		std::atomic<bool> m_stopped{ false };
+		std::thread m_thread;
+	};
+
+	struct DeviceArgument
+	{
+		std::string name;
+		std::string requestEndpoint;
+		std::string publishEndpoint;
+	};
+
+	int usage()
+	{
+		fprintf(stderr, "usage: Calibration-Coroutines [--mock n] [--device name reqEndpoint pubEndpoint]... "
+			"[--sub-type DST_PRO] [--cali-type CT_STEREO] [--timeout-ms 600000]\n");
+		return 1;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	int mock = 0;
+	std::vector<DeviceArgument> devices;
+	std::string subType = "DST_PRO", caliType = "CT_STEREO";
+	CoSequenceOptions options;
+	for (int i = 1; i < argc; i++){
+		const std::string argument = argv[i];
+		if (argument == "--mock" && i + 1 < argc)
+			mock = atoi(argv[++i]);
+		else if (argument == "--device" && i + 3 < argc){
+			devices.push_back(DeviceArgument{ argv[i + 1], argv[i + 2], argv[i + 3] });
+			i += 3;
+		}
+		else if (argument == "--sub-type" && i + 1 < argc)
+			subType = argv[++i];
+		else if (argument == "--cali-type" && i + 1 < argc)
+			caliType = argv[++i];
+		else if (argument == "--timeout-ms" && i + 1 < argc)
+			options.captureTimeoutMs = atoi(argv[++i]);
+		else
+			return usage();
+	}
+	if (mock <= 0 && devices.empty())
+		return usage();
+
+	void* context = zmq_ctx_new();
+	int succeeded = 0, failed = 0;
+	const auto start = Clock::now();
+	{
+		MockSdk* sdk = mock > 0 ? new MockSdk(context, mock) : nullptr;
+		for (int i = 0; i < mock; i++)
+			devices.push_back(DeviceArgument{ "mock" + std::to_string(i), MockSdk::requestEndpoint(i), MockSdk::publishEndpoint(i) });
+
+		CoLoop loop(context);
+		for (const auto& argument : devices){
+			auto device = loop.addDevice(argument.name, argument.requestEndpoint, argument.publishEndpoint);
+			loop.spawn(calibrationSequence(*device, subType, caliType, options), [&, device](bool ok){
+				if (ok)
+					succeeded++;
+				else
+					failed++;
+				if (mock <= 0)
+					printf("%s %s\n", device->name().c_str(), ok ? "succeeded" : "failed");
+			});
+		}
+		loop.run();
+		delete sdk;
+	}
+	zmq_ctx_term(context);
+
+	const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	printf("%d sequences on one thread: %d succeeded, %d failed in %.2f s\n", succeeded + failed, succeeded, failed, seconds);
+	return failed ? 1 : 0;
+}
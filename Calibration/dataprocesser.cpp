@@ -1,158 +1,430 @@
-#include "DataProcesser.h"
-#include <cassert>
-#include "mainwindow.h"
+#include "dataprocesser.h"
+#include "protocol.h"
 #include <QtDebug>
 #include <QSharedMemory>
-#include <QMessageBox>
+#include <QElapsedTimer>
+#include <chrono>
+#include <cstring>
+#include "frameconvert.h"
+#include "metrics.h"
+#include "calibclient.h"
+#include "tracing.h"
+
+namespace
+{
+	//upper bound of the frame ring latency added by waiting for notifications
+	const int FRAME_RING_POLL_MS = 1;
+	//a ring without frames this long is checked for a restarted producer
+	const int FRAME_RING_IDLE_MS = 2000;
+	//the operator reads the figures,faster updates only cost GUI time
+	const int EXPOSURE_PUBLISH_MS = 200;
+	//below this a frame is histogrammed on this thread alone
+	const int EXPOSURE_PARALLEL_PIXELS = 1024 * 1024;
+	//the operator moves the board by hand,the cue has to follow quickly
+	const int SHARPNESS_PUBLISH_MS = 100;
+	const int SHARPNESS_PARALLEL_PIXELS = 512 * 1024;
+	const int BOARD_PUBLISH_MS = 100;
+	const int MARKERS_PUBLISH_MS = 100;
+	//an unchanged frame still goes out this often,the board gate(500 ms) and the overlays need fresh results
+	const int UNCHANGED_REFRESH_MS = 200;
+	const int UNCHANGED_RATIO_MS = 1000;
+	//the replies never change,they are not built per notification
+	const char HANDLED_REPLY[] = "{\"handled\":true}";
+	const char REJECTED_REPLY[] = "{\"handled\":false}";
+}
 DataProcesser::DataProcesser(MainWindow *mainWindow, void *context, QObject *parent)
 	: QObject(parent), m_mainWindow(mainWindow), m_context(context)
 {
-
+	m_frameConverter.setPool(&m_pool);
 }
 
-void DataProcesser::setup(int port)//12000
+void DataProcesser::setup(int port, const QString& advertisedAddr)
 {
+	TRACE_THREAD_NAME("DataProcesser");
 	m_socket = zmq_socket(m_context, ZMQ_REP);
+	m_tuning.apply(m_socket);
 
 	auto bindAddrBytes = QString("tcp://*:%1").arg(port).toLocal8Bit();
 	int rc = zmq_bind(m_socket, bindAddrBytes);
 	qDebug() << "rc" << rc << endl;
 	qDebug() << "bindAddrBytes" << bindAddrBytes << endl;
-	assert(!rc);
+	if (rc){
+		qWarning() << "cannot bind the data processer to" << bindAddrBytes << zmq_strerror(zmq_errno());
+		emit registered(false);
+		zmq_close(m_socket);
+		return;
+	}
 	const char * envelop = "v1.0/scan/register";
 	auto nbytes = zmq_send(m_reqSocket, envelop, strlen(envelop), ZMQ_SNDMORE);
 	if (nbytes != strlen(envelop)){
 		qWarning() << "cannot send register envelop!";
+		emit registered(false);
+		zmq_close(m_socket);
 		return;
 	}
-	auto connectAddrBytes = QString("tcp://localhost:%1").arg(port).toLocal8Bit();
+	auto connectAddrBytes = advertisedAddr.toLocal8Bit();
 	nbytes = zmq_send(m_reqSocket, connectAddrBytes.constData(), connectAddrBytes.size(), 0);
 	if (nbytes != connectAddrBytes.size()){
 		qWarning() << "cannot send register processurl!";
+		emit registered(false);
+		zmq_close(m_socket);
 		return;
 	}
 
 	char replybuf[MAX_DATA_LENGTH + 1] = { 0 };
-	zmq_recv(m_reqSocket, replybuf, MAX_DATA_LENGTH, 0);
+	const int replySize = zmq_recv(m_reqSocket, replybuf, MAX_DATA_LENGTH, 0);
+	if (replySize == -1){
+		if (zmq_errno() != ETERM){
+			qWarning() << "no reply to register!" << zmq_strerror(zmq_errno());
+			emit registered(false);
+		}
+		zmq_close(m_socket);
+		return;
+	}
+	//the reply is a native int used as bool like the other SDK replies
+	if (!CalibClient::replyBool(std::string(replybuf, qMin(replySize, int(MAX_DATA_LENGTH))))){
+		qWarning() << "the SDK rejected register of" << advertisedAddr;
+		emit registered(false);
+		zmq_close(m_socket);
+		return;
+	}
+	emit registered(true);
+
+	auto& registry = MetricsRegistry::instance();
+	const auto labels = QString("device=\"%1\"").arg(m_deviceName);
+	auto notificationsMetric = registry.counter("calib_data_notifications_total", "Data processing notifications from the SDK", labels);
+	auto invalidMetric = registry.counter("calib_data_invalid_notifications_total", "Notifications that were not valid json", labels);
+	auto processMetric = registry.histogram("calib_data_process_seconds", "Time from notification received to reply sent", labels);
+	registerMetrics();
+	QElapsedTimer processClock;
 
 	while (true){
-		char rawData[MAX_DATA_LENGTH + 1] = { 0 };
-		nbytes = zmq_recv(m_socket, rawData, sizeof(rawData), 0);
-		QByteArray data(rawData);
-		auto jsonDoc = QJsonDocument::fromJson(data);
-		if (jsonDoc.isNull()){
+		if (!m_frameRingName.isEmpty()){
+			//frames do not wake us,look at the rings between short waits for notifications
+			zmq_pollitem_t item = { m_socket, 0, ZMQ_POLLIN, 0 };
+			if (zmq_poll(&item, 1, FRAME_RING_POLL_MS) == -1 && zmq_errno() == ETERM)
+				break;
+			pollFrameRings();
+			if (!(item.revents & ZMQ_POLLIN))
+				continue;
+		}
+		nbytes = zmq_recv(m_socket, m_receiveBuffer, MAX_DATA_LENGTH, 0);
+		if (nbytes == -1){
+			if (zmq_errno() == ETERM)
+				break;
+			continue;
+		}
+		processClock.start();
+		notificationsMetric->inc();
+		//zmq_recv returns the full size of a truncated message,a cut off object does not parse
+		if (!consumeNotification(m_receiveBuffer, qMin(int(nbytes), MAX_DATA_LENGTH))){
 			qWarning() << "Invalid data processing json message!";
+			invalidMetric->inc();
+			//REP has to answer before it can receive again
+			zmq_send(m_socket, REJECTED_REPLY, sizeof(REJECTED_REPLY) - 1, 0);
 			continue;
 		}
-		auto jsonObj = jsonDoc.object();
-		//qInfo() << "data process:" << jsonObj;
-		QJsonObject backJsonObj{
-			{ QStringLiteral("handled"), true }
-		};
-		auto backJsonObjStr = MainWindow::jsonStr(backJsonObj);
-		processData(jsonObj);
-		nbytes = zmq_send(m_socket, backJsonObjStr, backJsonObjStr.size(), 0);
+		nbytes = zmq_send(m_socket, HANDLED_REPLY, sizeof(HANDLED_REPLY) - 1, 0);
+		processMetric->observe(processClock.nsecsElapsed());
+		//the SDK got its reply once the shared memory was read,it does not wait for the analyses
+		runPendingAnalysis();
+	}
+	zmq_close(m_socket);
+	m_socket = nullptr;
+}
+
+void DataProcesser::registerMetrics()
+{
+	if (m_metricsRegistered)
+		return;
+	m_metricsRegistered = true;
+	auto& registry = MetricsRegistry::instance();
+	const auto labels = QString("device=\"%1\"").arg(m_deviceName);
+	m_frameRingFramesMetric = registry.counter("calib_frame_ring_frames_total", "Frames read from the shared memory rings", labels);
+	m_frameRingTornMetric = registry.counter("calib_frame_ring_torn_total", "Ring reads discarded because the producer overwrote the slot", labels);
+	m_frameRingLatencyMetric = registry.histogram("calib_frame_ring_latency_seconds", "Time from frame written to frame converted", labels);
+	m_exposureMetric = registry.histogram("calib_exposure_histogram_seconds", "Time to histogram one video frame", labels);
+	m_sharpnessMetric = registry.histogram("calib_sharpness_seconds", "Time to score the focus of one video frame", labels);
+	m_markersMetric = registry.histogram("calib_markers_seconds", "Time to extract the marker centroids of one gray video frame", labels);
+	m_boardMetric = registry.histogram("calib_board_detect_seconds", "Time to search one video frame for the calibration board", labels);
+	m_changeMetric = registry.histogram("calib_frame_change_seconds", "Time to compare one video frame with the last delivered one", labels);
+	for (int camID = 0; camID < 2; camID++){
+		const auto cameraLabels = QString("%1,camera=\"cam%2\"").arg(labels).arg(camID);
+		m_exposureMeanMetric[camID] = registry.gauge("calib_exposure_mean", "Mean intensity of the newest video frame", cameraLabels);
+		m_exposureSaturatedMetric[camID] = registry.gauge("calib_exposure_saturated_permille", "Saturated pixels of the newest video frame,per mille", cameraLabels);
+		m_markersCountMetric[camID] = registry.gauge("calib_markers", "Markers found in the newest gray video frame", cameraLabels);
+		m_markersBudgetMetric[camID] = registry.counter("calib_markers_budget_exceeded_total", "Gray video frames whose marker refinement was cut short by the time budget", cameraLabels);
+		m_boardCirclesMetric[camID] = registry.gauge("calib_board_circles", "Board circles matched in the newest video frame", cameraLabels);
+		m_sharpnessScoreMetric[camID] = registry.gauge("calib_sharpness_score", "Laplacian variance in the sharpness ROI of the newest video frame", cameraLabels);
+		m_unchangedMetric[camID] = registry.counter("calib_video_unchanged_total", "Video frames neither converted nor delivered because they did not change", cameraLabels);
+		m_unchangedRatioMetric[camID] = registry.gauge("calib_video_unchanged_permille", "Video frames skipped as unchanged during the last second,per mille", cameraLabels);
 	}
+	//started once,not per frame
+	m_pool.setThreads(analysisThreads());
 }
 
-void DataProcesser::processData(QJsonObject jsonObj)
+bool DataProcesser::processNotification(const char* text, int size)
 {
-	auto type = jsonObj["type"].toString();
-	auto key = jsonObj["key"].toString();
-	auto name = jsonObj["name"].toString();
-	auto props = jsonObj["props"].toObject();
-	auto offset = jsonObj["offset"].toInt();
+	const bool valid = consumeNotification(text, size);
+	runPendingAnalysis();
+	return valid;
+}
 
-	QSharedMemory shm;
-	shm.setNativeKey(key);
-	shm.attach(QSharedMemory::ReadWrite);
-	auto data = static_cast<unsigned char*>(shm.data()) + offset;
+bool DataProcesser::consumeNotification(const char* text, int size)
+{
+	registerMetrics();
+	m_notificationArena.reset();
+	Notification notification;
+	if (!parseNotification(text, size, m_notificationArena, &notification))
+		return false;
+	processData(notification);
+	return true;
+}
 
-	QJsonDocument jsonDoc;
-	jsonDoc.setObject(props);
-	auto msg = jsonDoc.toJson();
+void DataProcesser::processData(const Notification& notification)
+{
+	TRACE_SCOPE("processData");
+	const auto& type = notification.type;
 
-	if (type == QStringLiteral("MT_VIDEO_DATA")){
-		auto rotate = props["rotate"].toInt();
-		auto width = props["width"].toInt();
-		auto height = props["height"].toInt();
-		auto channel = props["channel"].toInt();
+	QSharedMemory shm;
+	shm.setNativeKey(QString::fromUtf8(notification.key.data, notification.key.size));
+	shm.attach(QSharedMemory::ReadWrite);
+	auto data = static_cast<unsigned char*>(shm.data()) + notification.offset;
+	if (!shm.data() && type.equals("MT_VIDEO_DATA")){
+		qWarning() << "cannot attach video shared memory" << shm.nativeKey();
+		return;
+	}
 
-		auto pixmap = createPixmap(data, width, height, channel, rotate);
-		if (name == QStringLiteral("cam0")){
-			emit videoImageReady(0, pixmap);
+	if (type.equals("MT_VIDEO_DATA")){
+		auto rotate = notification.rotate;
+		auto width = notification.width;
+		auto height = notification.height;
+		auto channel = notification.channel;
+		const auto format = pixelFormatFromName(notification.pixelFormat.data, notification.pixelFormat.size, channel);
+		if (format == PF_UNKNOWN){
+			qWarning() << "unsupported video pixel format" << QByteArray(notification.pixelFormat.data, notification.pixelFormat.size) << "channel" << channel;
+			return;
 		}
-		else if (name == QStringLiteral("cam1")){
-			emit videoImageReady(1, pixmap);
+
+		int camID = -1;
+		if (notification.name.equals("cam0"))
+			camID = 0;
+		else if (notification.name.equals("cam1"))
+			camID = 1;
+		if (camID >= 0){
+			if (!frameChanged(camID, data, width, height, pixelFormatBytes(format)))
+				return;
+			VideoFrame frame;
+			frame.image = m_frameConverter.convert(data, width, height, format, rotate, notification.windowLow, notification.windowHigh);
+			if (frame.isNull())
+				return;
+			frame.sequence = ++m_frameSequence[camID];
+			frame.timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+			emit videoImageReady(camID, frame);
+			//the shared memory may be reused once the SDK has its reply,the analyses run on a copy after it
+			auto& pending = m_pendingAnalysis;
+			pending.camID = camID;
+			pending.width = width;
+			pending.height = height;
+			pending.channel = m_frameConverter.analysisChannel();
+			//Bayer heads are texture cameras like RGB ones
+			pending.markers = !isBayer(format);
+			pending.pixels.resize(size_t(width) * height * pending.channel);
+			memcpy(pending.pixels.data(), m_frameConverter.analysisData(), pending.pixels.size());
 		}
 	}
-	else if (type == QStringLiteral("MT_POINT_CLOUD")) {
-		emit sharedMemoryMsg(type, msg);
-	}
-	else if (type == QStringLiteral("MY_DELETE_POINTS")) {
-		emit sharedMemoryMsg(type, msg);
-	}
-	else if (type == QStringLiteral("MT_MARKERS")) {
-		emit sharedMemoryMsg(type, msg);
-	}
-	else if (type == QStringLiteral("MY_TRI_MESH")) {
-		emit sharedMemoryMsg(type, msg);
+	else if (type.equals("MT_POINT_CLOUD") || type.equals("MY_DELETE_POINTS") || type.equals("MT_MARKERS")
+		|| type.equals("MY_TRI_MESH") || type.equals("MT_RANGE_DATA")) {
+		//props as the SDK sent them,not parsed and serialized again
+		emit sharedMemoryMsg(QString::fromLatin1(type.data, type.size), QByteArray(notification.props.data, notification.props.size));
 	}
-	else if (type == QStringLiteral("MT_RANGE_DATA")) {
-		emit sharedMemoryMsg(type, msg);
+}
+
+
+void DataProcesser::pollFrameRings()
+{
+	TRACE_SCOPE("pollFrameRings");
+	const bool retryDue = !m_frameRingRetry.isValid() || m_frameRingRetry.elapsed() >= 1000;
+	for (int camID = 0; camID < 2; camID++){
+		auto& ring = m_frameRings[camID];
+		//a restarted producer unlinks the ring we mapped and writes a new one,our mapping never changes again
+		if (ring.isOpen() && retryDue && ring.idleNs() >= FRAME_RING_IDLE_MS * 1000000LL && ring.replaced()){
+			qInfo() << "frame ring of cam" << camID << "replaced,attaching again";
+			ring.close();
+		}
+		if (!ring.isOpen()){
+			//the producer may start after us,look for it once a second
+			if (!retryDue)
+				continue;
+			auto name = QString("%1%2.cam%3").arg(m_frameRingName.startsWith('/') ? "" : "/", m_frameRingName).arg(camID);
+			if (!ring.open(name.toLocal8Bit().constData()))
+				continue;
+			qInfo() << "frame ring attached:" << name;
+		}
+
+		//the producer may overwrite the slot while it is read,only a copy that passed the sequence check is used
+		auto& copy = m_frameRingCopy[camID];
+		FrameInfo info;
+		auto result = ring.readLatest([&](const FrameInfo& slotInfo, const unsigned char* data){
+			info = slotInfo;
+			copy.resize(slotInfo.bytes);
+			memcpy(copy.data(), data, slotInfo.bytes);
+		});
+		if (result == FR_TORN){
+			m_frameRingTornMetric->inc();
+			continue;
+		}
+		if (result == FR_RESTARTED){
+			qInfo() << "frame ring of cam" << camID << "started over,attaching again";
+			ring.close();
+			continue;
+		}
+		if (result != FR_OK)
+			continue;
+		m_frameRingFramesMetric->inc();
+		const auto data = copy.data();
+		const int width = int(info.width), height = int(info.height), channel = int(info.channel);
+		if (size_t(width) * height * channel > copy.size() || !frameChanged(camID, data, width, height, channel)){
+			m_frameRingLatencyMetric->observe(frameRingNow() - info.timestampNs);
+			continue;
+		}
+		VideoFrame frame;
+		frame.image = convertFrame(data, width, height, channel, info.rotate);
+		m_frameRingLatencyMetric->observe(frameRingNow() - info.timestampNs);
+		if (frame.isNull())
+			continue;
+		frame.sequence = ++m_frameSequence[camID];
+		frame.timestampNs = info.timestampNs;
+		emit videoImageReady(camID, frame);
+		updateExposure(camID, data, width, height, channel);
+		updateSharpness(camID, data, width, height, channel);
+		updateBoard(camID, data, width, height, channel);
+		updateMarkers(camID, data, width, height, channel);
 	}
+	if (retryDue)
+		m_frameRingRetry.start();
 }
 
+void DataProcesser::runPendingAnalysis()
+{
+	auto& pending = m_pendingAnalysis;
+	if (pending.camID < 0)
+		return;
+	const auto data = pending.pixels.data();
+	updateExposure(pending.camID, data, pending.width, pending.height, pending.channel);
+	updateSharpness(pending.camID, data, pending.width, pending.height, pending.channel);
+	updateBoard(pending.camID, data, pending.width, pending.height, pending.channel);
+	if (pending.markers)
+		updateMarkers(pending.camID, data, pending.width, pending.height, pending.channel);
+	pending.camID = -1;
+}
 
-QPixmap DataProcesser::createPixmap(unsigned char* data, int width, int height, int channel, int rotate)
+bool DataProcesser::frameChanged(int camID, const unsigned char* data, int width, int height, int bytesPerPixel)
 {
-	int sizeColor = width * height * 3;
-	int sizeSingle = width * height * channel;
-	int byte_per_line = 0;
-	unsigned char* pDataColor = new unsigned char[sizeColor];
-	if (3 == channel)
-	{
-		byte_per_line = width*channel;
-		memcpy(pDataColor, data, sizeSingle);
+	TRACE_SCOPE("frameChanged");
+	QElapsedTimer clock;
+	clock.start();
+	auto& detector = m_frameChange[camID];
+	auto& delivered = m_frameDelivered[camID];
+	const bool changed = !delivered.isValid() || delivered.elapsed() >= UNCHANGED_REFRESH_MS
+		|| detector.changed(data, width, height, bytesPerPixel);
+	if (changed){
+		//later frames are compared with this one,slow drift adds up until it shows
+		detector.update(data, width, height, bytesPerPixel);
+		delivered.start();
+	}
+	m_changeMetric->observe(clock.nsecsElapsed());
 
+	m_changeWindowFrames[camID]++;
+	if (!changed){
+		m_changeWindowSkipped[camID]++;
+		m_unchangedMetric[camID]->inc();
 	}
-	else
-	{
-		for (int i = 0; i < sizeSingle; i++)
-		{
-			pDataColor[i * 3] = data[i];
-			pDataColor[i * 3 + 1] = data[i];
-			pDataColor[i * 3 + 2] = data[i];
-			if (data[i] > 230)
-			{
-				pDataColor[i * 3] = 255;
-				pDataColor[i * 3 + 1] = 0;
-				pDataColor[i * 3 + 2] = 0;
-			}
-		}// ʾɫ add by lzy
+	auto& window = m_changeWindow[camID];
+	if (!window.isValid())
+		window.start();
+	else if (window.elapsed() >= UNCHANGED_RATIO_MS){
+		m_unchangedRatioMetric[camID]->set(m_changeWindowSkipped[camID] * 1000LL / m_changeWindowFrames[camID]);
+		m_changeWindowFrames[camID] = 0;
+		m_changeWindowSkipped[camID] = 0;
+		window.restart();
 	}
+	return changed;
+}
 
-	QMatrix left_matrix_;
-	left_matrix_.rotate(rotate);
+void DataProcesser::updateExposure(int camID, const unsigned char* data, int width, int height, int channel)
+{
+	TRACE_SCOPE("updateExposure");
+	QElapsedTimer clock;
+	clock.start();
+	ExposureHistogram histogram;
+	histogram.accumulateParallel(data, width, height, channel, width * height >= EXPOSURE_PARALLEL_PIXELS ? &m_pool : nullptr);
+	const auto stats = histogram.stats();
+	m_exposureMetric->observe(clock.nsecsElapsed());
+	m_exposureMeanMetric[camID]->set(qRound(stats.mean));
+	m_exposureSaturatedMetric[camID]->set(qRound(stats.saturatedFraction * 1000));
 
+	auto& published = m_exposurePublished[camID];
+	if (published.isValid() && published.elapsed() < EXPOSURE_PUBLISH_MS)
+		return;
+	published.start();
+	emit exposureUpdated(camID, stats);
+}
 
-	QImage* image_ = 0;
-	if (byte_per_line > 0)
-		image_ = new QImage(pDataColor, width, height, byte_per_line, QImage::Format_RGB888);
-	else
-		image_ = new QImage(pDataColor, width, height, QImage::Format_RGB888);
+void DataProcesser::updateSharpness(int camID, const unsigned char* data, int width, int height, int channel)
+{
+	TRACE_SCOPE("updateSharpness");
+	QElapsedTimer clock;
+	clock.start();
+	const double roiPixels = width * m_sharpnessRoi.width * height * m_sharpnessRoi.height;
+	const double score = laplacianVariance(data, width, height, channel, m_sharpnessRoi, roiPixels >= SHARPNESS_PARALLEL_PIXELS ? &m_pool : nullptr);
+	m_sharpnessMetric->observe(clock.nsecsElapsed());
+	m_sharpnessScoreMetric[camID]->set(qRound64(score));
 
-	if (width != 1280)
-		*image_ = image_->transformed(left_matrix_).mirrored(true); //sign 1121
-	else
-		*image_ = image_->transformed(left_matrix_); //sign 1121
+	auto& published = m_sharpnessPublished[camID];
+	if (published.isValid() && published.elapsed() < SHARPNESS_PUBLISH_MS)
+		return;
+	published.start();
+	emit sharpnessUpdated(camID, score);
+}
 
-	QPixmap pixmap = QPixmap::fromImage(*image_);
+void DataProcesser::updateBoard(int camID, const unsigned char* data, int width, int height, int channel)
+{
+	if (!m_board.isValid())
+		return;
+	TRACE_SCOPE("updateBoard");
+	QElapsedTimer clock;
+	clock.start();
+	const auto detection = detectBoard(data, width, height, channel, m_board, &m_pool);
+	m_boardMetric->observe(clock.nsecsElapsed());
+	m_boardCirclesMetric[camID]->set(detection.matched);
 
-	delete image_;
+	//a change is published at once,snaps are gated on it
+	auto& published = m_boardPublished[camID];
+	if (detection.found == m_boardFound[camID] && published.isValid() && published.elapsed() < BOARD_PUBLISH_MS)
+		return;
+	m_boardFound[camID] = detection.found;
+	published.start();
+	emit boardDetected(camID, detection);
+}
 
-	delete[]pDataColor;
-	pDataColor = NULL;
+void DataProcesser::updateMarkers(int camID, const unsigned char* data, int width, int height, int channel)
+{
+	//markers are imaged by the gray cameras,color frames are texture
+	if (!m_markersEnabled || channel != 1)
+		return;
+	TRACE_SCOPE("updateMarkers");
+	QElapsedTimer clock;
+	clock.start();
+	const auto result = findMarkers(data, width, height, m_markerParams, &m_pool);
+	m_markersMetric->observe(clock.nsecsElapsed());
+	m_markersCountMetric[camID]->set(qint64(result.markers.size()));
+	if (!result.complete)
+		m_markersBudgetMetric[camID]->inc();
 
-	return pixmap;
-}
\ No newline at end of file
+	auto& published = m_markersPublished[camID];
+	if (published.isValid() && published.elapsed() < MARKERS_PUBLISH_MS)
+		return;
+	published.start();
+	emit markersUpdated(camID, result);
+}
@@ -6,8 +6,25 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
-#include <QPixmap>
+#include "videoframe.h"
 #include <QByteArray>
+#include "sockettuning.h"
+#include "framering.h"
+#include "exposure.h"
+#include "sharpness.h"
+#include "boarddetector.h"
+#include "markers.h"
+#include "notification.h"
+#include "frameconvert.h"
+#include "framechange.h"
+#include "workerpool.h"
+#include "protocol.h"
+#include "metrics.h"
+#include <QElapsedTimer>
+
+Q_DECLARE_METATYPE(ExposureStats)
+Q_DECLARE_METATYPE(BoardDetection)
+Q_DECLARE_METATYPE(MarkerResult)
 /*
 Get data from shared memory
 */
@@ -20,36 +37,166 @@ public:
 
 	void setReqSocket(void* s)
 	{ m_reqSocket = s; }
+	/*
+	Options of the REP socket,set before setup
+	*/
+	void setTuning(const SocketTuning& tuning)
+	{ m_tuning = tuning; }
+	/*
+	name:device label of the exported metrics,set before setup
+	*/
+	void setDeviceName(const QString& name)
+	{ m_deviceName = name; }
+	/*
+	baseName:POSIX shm rings <baseName>.cam0 and <baseName>.cam1,Linux only,set before setup
+	Video frames are then read from the rings instead of per frame notifications
+	*/
+	void setFrameRing(const QString& baseName)
+	{ m_frameRingName = baseName; }
+	/*
+	roi:region the focus score is computed over,set before setup
+	*/
+	void setSharpnessRoi(const SharpnessRoi& roi)
+	{ m_sharpnessRoi = roi; }
+	/*
+	spec:circle grid searched in every video frame,none while invalid,set before setup
+	*/
+	void setBoard(const BoardSpec& spec)
+	{ m_board = spec; }
+	/*
+	params:marker centroids are extracted from every gray video frame,set before setup
+	*/
+	void setMarkers(const MarkerParams& params)
+	{ m_markerParams = params; m_markersEnabled = true; }
+	/*
+	tolerance:mean level difference of the sampled blocks below which a video frame is unchanged,
+	it is then neither converted nor delivered;negative converts every frame,set before setup
+	*/
+	void setChangeTolerance(int tolerance)
+	{ m_frameChange[0].setTolerance(tolerance); m_frameChange[1].setTolerance(tolerance); }
+	/*
+	text:one data processing notification,size bytes
+	Handled on the calling thread like one received by setup,analyses included,false when it is not valid json
+	*/
+	bool processNotification(const char* text, int size);
 signals:
 	/*Send image data to mainwindow
 	camID: image area displayed on the main interface
-	pixmap:image data
+	frame:image data,built on this thread as a QImage,QPixmap is GUI thread only
 	*/
-	void videoImageReady(int camID, QPixmap pixmap);
+	void videoImageReady(int camID, VideoFrame frame);
+	/*
+	Exposure of the newest frame of a camera,at most every EXPOSURE_PUBLISH_MS
+	*/
+	void exposureUpdated(int camID, ExposureStats stats);
+	/*
+	score:variance of the Laplacian in the ROI,at most every SHARPNESS_PUBLISH_MS
+	*/
+	void sharpnessUpdated(int camID, double score);
+	/*
+	Emitted when the board appears or disappears and at most every BOARD_PUBLISH_MS otherwise
+	*/
+	void boardDetected(int camID, BoardDetection detection);
+	/*
+	Markers of the newest gray frame of a camera,at most every MARKERS_PUBLISH_MS
+	*/
+	void markersUpdated(int camID, MarkerResult result);
 	void sharedMemoryMsg(QString ,QByteArray);
+	/*
+	ok:the SDK accepted scan/register,emitted once from setup
+	*/
+	void registered(bool ok);
 public slots:
 	/*
 	port:Port number for registering shared memory
+	advertisedAddr:address registered with the SDK,it connects back to it and must reach port
 	Communicate with SDK through ZMQ to deal with shared memory.
 	*/
-    void setup(int port);
+    void setup(int port, const QString& advertisedAddr);
 private:
 	/*
-	jsonObj:shared memory data
+	notification:shared memory data,its fields point into m_receiveBuffer and m_notificationArena
 	Processing shared meory for specific situations
 	*/
-	void processData(QJsonObject jsonObj);
+	void processData(const Notification& notification);
+	/*
+	Parses and processes a notification up to the emitted frame,the analyses wait in m_pendingAnalysis
+	*/
+	bool consumeNotification(const char* text, int size);
+	/*
+	Exposure,sharpness,board and markers of the frame the last notification left,after the reply is sent
+	*/
+	void runPendingAnalysis();
+	void registerMetrics();
+	/*
+	Attach to rings that appeared and emit the newest frame of every camera
+	*/
+	void pollFrameRings();
 	/*
-	data:The data of picture
-	rotateoThe rotation angle of the picture
+	Histogram one frame into the exposure metrics,emits exposureUpdated when it is due
 	*/
-	QPixmap createPixmap(unsigned char* data, int width, int height, int channel, int rotate);
+	bool frameChanged(int camID, const unsigned char* data, int width, int height, int bytesPerPixel);
+	void updateExposure(int camID, const unsigned char* data, int width, int height, int channel);
+	void updateSharpness(int camID, const unsigned char* data, int width, int height, int channel);
+	void updateBoard(int camID, const unsigned char* data, int width, int height, int channel);
+	void updateMarkers(int camID, const unsigned char* data, int width, int height, int channel);
 private:
     QString m_addr;
     void* m_context = nullptr;
     void* m_socket = nullptr;
 	void* m_reqSocket = nullptr;
     MainWindow* m_mainWindow = nullptr;
+	SocketTuning m_tuning;
+	QString m_deviceName;
+	bool m_metricsRegistered = false;
+	char m_receiveBuffer[MAX_DATA_LENGTH];
+	JsonArena m_notificationArena;
+	struct PendingAnalysis
+	{
+		int camID = -1;//none
+		int width = 0;
+		int height = 0;
+		int channel = 1;
+		bool markers = false;
+		std::vector<unsigned char> pixels;//copy of the analysis input,the shared memory belongs to the SDK again
+	} m_pendingAnalysis;
+	FrameConverter m_frameConverter;
+	FrameChangeDetector m_frameChange[2];
+	QElapsedTimer m_frameDelivered[2];
+	QElapsedTimer m_changeWindow[2];
+	int m_changeWindowFrames[2] = { 0, 0 };
+	int m_changeWindowSkipped[2] = { 0, 0 };
+	MetricHistogram* m_changeMetric = nullptr;
+	MetricCounter* m_unchangedMetric[2] = { nullptr, nullptr };
+	MetricGauge* m_unchangedRatioMetric[2] = { nullptr, nullptr };
+	quint64 m_frameSequence[2] = { 0, 0 };
+	QString m_frameRingName;
+	FrameRingReader m_frameRings[2];
+	std::vector<unsigned char> m_frameRingCopy[2];//newest slot of every ring,kept to reuse its capacity
+	QElapsedTimer m_frameRingRetry;
+	MetricCounter* m_frameRingFramesMetric = nullptr;
+	MetricCounter* m_frameRingTornMetric = nullptr;
+	MetricHistogram* m_frameRingLatencyMetric = nullptr;
+	WorkerPool m_pool;//bands of the conversion and the analyses
+	QElapsedTimer m_exposurePublished[2];
+	MetricHistogram* m_exposureMetric = nullptr;
+	MetricGauge* m_exposureMeanMetric[2] = { nullptr, nullptr };
+	MetricGauge* m_exposureSaturatedMetric[2] = { nullptr, nullptr };
+	SharpnessRoi m_sharpnessRoi;
+	QElapsedTimer m_sharpnessPublished[2];
+	MetricHistogram* m_sharpnessMetric = nullptr;
+	MetricGauge* m_sharpnessScoreMetric[2] = { nullptr, nullptr };
+	BoardSpec m_board;
+	bool m_boardFound[2] = { false, false };
+	QElapsedTimer m_boardPublished[2];
+	MetricHistogram* m_boardMetric = nullptr;
+	MetricGauge* m_boardCirclesMetric[2] = { nullptr, nullptr };
+	bool m_markersEnabled = false;
+	MarkerParams m_markerParams;
+	QElapsedTimer m_markersPublished[2];
+	MetricHistogram* m_markersMetric = nullptr;
+	MetricGauge* m_markersCountMetric[2] = { nullptr, nullptr };
+	MetricCounter* m_markersBudgetMetric[2] = { nullptr, nullptr };
 };
 
 #endif // DATA_PROCESSER_H
@@ -0,0 +1,66 @@
+#include "deviceendpoint.h"
+#include <QStringList>
+#include <QSet>
+#include <QSysInfo>
+#include <QtDebug>
+
+QString DeviceEndpoint::dataAddr() const
+{
+	auto advertised = dataHost;
+	if (advertised.isEmpty())
+		advertised = isLocal() ? QStringLiteral("localhost") : QSysInfo::machineHostName();
+	return QString("tcp://%1:%2").arg(advertised).arg(dataPort);
+}
+
+bool DeviceEndpoint::isLocal() const
+{
+	return host == QLatin1String("localhost") || host.startsWith(QLatin1String("127.")) || host == QLatin1String("::1");
+}
+
+bool DeviceEndpoint::parse(const QString& spec, DeviceEndpoint& endpoint)
+{
+	auto rest = spec;
+	auto at = rest.indexOf('@');
+	if (at >= 0){
+		endpoint.name = rest.left(at);
+		rest = rest.mid(at + 1);
+	}
+	auto parts = rest.split(':');
+	if (parts.size() != 1 && parts.size() != 4 && parts.size() != 5)
+		return false;
+	if (parts[0].isEmpty())
+		return false;
+	endpoint.host = parts[0];
+	if (parts.size() >= 4){
+		bool ok[3];
+		endpoint.publishPort = parts[1].toInt(&ok[0]);
+		endpoint.requestPort = parts[2].toInt(&ok[1]);
+		endpoint.dataPort = parts[3].toInt(&ok[2]);
+		if (!ok[0] || !ok[1] || !ok[2] || endpoint.dataPort <= 0)
+			return false;
+	}
+	if (parts.size() == 5){
+		if (parts[4].isEmpty())
+			return false;
+		endpoint.dataHost = parts[4];
+	}
+	if (endpoint.name.isEmpty())
+		endpoint.name = rest;
+	return true;
+}
+
+bool DeviceEndpoint::assignDataPorts(QList<DeviceEndpoint>& endpoints)
+{
+	QSet<int> ports;
+	for (int i = 0; i < endpoints.size(); i++){
+		auto& endpoint = endpoints[i];
+		if (endpoint.dataPort <= 0)
+			endpoint.dataPort = DATA_PORT_BASE + i;
+		if (ports.contains(endpoint.dataPort)){
+			qCritical() << "data port" << endpoint.dataPort << "of" << endpoint.name << "is already bound by another device";
+			return false;
+		}
+		ports.insert(endpoint.dataPort);
+	}
+	return true;
+}
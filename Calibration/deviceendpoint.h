@@ -0,0 +1,35 @@
+#ifndef DEVICE_ENDPOINT_H
+#define DEVICE_ENDPOINT_H
+
+#include <QString>
+#include <QList>
+/*
+Endpoints of one SDK instance(one scanner)
+*/
+struct DeviceEndpoint
+{
+	static const int DATA_PORT_BASE = 12000;
+
+	QString name;
+	QString host = QStringLiteral("localhost");
+	int publishPort = 11398;
+	int requestPort = 11399;
+	int dataPort = 0;//bound by the client,the SDK connects back to it,0 takes DATA_PORT_BASE plus the device index
+	QString dataHost;//advertised to the SDK for dataAddr,empty takes localhost for a local SDK and else this machine's host name
+
+	QString publishAddr() const { return QString("tcp://%1:%2").arg(host).arg(publishPort); }
+	QString requestAddr() const { return QString("tcp://%1:%2").arg(host).arg(requestPort); }
+	QString dataAddr() const;
+	bool isLocal() const;
+	/*
+	spec:[name@]host[:pubPort:reqPort:dataPort[:dataHost]]
+	*/
+	static bool parse(const QString& spec, DeviceEndpoint& endpoint);
+	/*
+	Give every endpoint without a data port DATA_PORT_BASE plus its index
+	return:false when two endpoints would bind the same data port
+	*/
+	static bool assignDataPorts(QList<DeviceEndpoint>& endpoints);
+};
+
+#endif // DEVICE_ENDPOINT_H
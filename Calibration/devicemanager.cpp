@@ -0,0 +1,205 @@
+#include "devicemanager.h"
+#include <QtDebug>
+#include <cassert>
+#include <QStringList>
+#include "metrics.h"
+
+namespace
+{
+	//the GUI counts 10 heartbeat ticks of 210ms before reporting the platform dead
+	const int HEARTBEAT_TIMEOUT_MS = 2100;
+	const int DEVICES_PER_IO_THREAD = 4;
+	const int PUBLISH_QUEUE_CAPACITY = 1024;
+}
+
+int DeviceManager::ioThreadsFor(int deviceCount)
+{
+	return qMax(1, (deviceCount + DEVICES_PER_IO_THREAD - 1) / DEVICES_PER_IO_THREAD);
+}
+
+DeviceManager::DeviceManager(const QList<DeviceEndpoint>& endpoints, const SocketTuningConfig& tuning, QObject *parent)
+	: QObject(parent)
+{
+	qRegisterMetaType<VideoFrame>("VideoFrame");
+	qRegisterMetaType<ExposureStats>("ExposureStats");
+	qRegisterMetaType<BoardDetection>("BoardDetection");
+	qRegisterMetaType<MarkerResult>("MarkerResult");
+	m_context = zmq_ctx_new();
+	//must be set before the first socket is created
+	auto ioThreads = ioThreadsFor(endpoints.size());
+	zmq_ctx_set(m_context, ZMQ_IO_THREADS, ioThreads);
+	qInfo() << "zmq context:" << endpoints.size() << "devices," << ioThreads << "io threads";
+	tuning.report();
+	m_requestTuning = tuning.tuning(SC_REQUEST);
+	//a duplicate data port is logged,that data processer fails to bind and reports registered(false)
+	auto resolved = endpoints;
+	DeviceEndpoint::assignDataPorts(resolved);
+
+	for (int i = 0; i < resolved.size(); i++){
+		auto device = new Device;
+		device->endpoint = resolved[i];
+
+		device->subscriberThread = new QThread(this);
+		device->subscriber = new Subscriber(nullptr, m_context);
+		device->subscriber->setTuning(tuning.tuning(SC_PUBLISH));
+		device->subscriber->setDeviceName(device->endpoint.name);
+		device->subscriber->moveToThread(device->subscriberThread);
+		connect(device->subscriberThread, &QThread::finished, device->subscriber, &QObject::deleteLater);
+		device->channel = new PublishChannel(PUBLISH_QUEUE_CAPACITY, this);
+		device->channel->setDeviceName(device->endpoint.name);
+		//state topics only matter by their newest value,everything else drives the flow and must not be lost
+		device->channel->setPolicy(QStringLiteral("progress"), OP_LATEST);
+		device->channel->setPolicy(QStringLiteral("cali/time"), OP_LATEST);
+		device->channel->setPolicy(QStringLiteral("cali/currentCaliDist"), OP_LATEST);
+		device->channel->setPolicy(QStringLiteral("cali/caliDistStates"), OP_LATEST);
+		device->channel->setPolicy(QStringLiteral("cali/snapEnabled"), OP_LATEST);
+		device->subscriber->setChannel(device->channel);
+		connect(device->channel, &PublishChannel::heartbeat, this, [this, i]{ onHeartbeat(i); });
+		connect(device->channel, &PublishChannel::publishReceived, this, [this, i](QString majorCmd, QString minorCmd, QByteArray data){
+			emit publishReceived(i, majorCmd, minorCmd, data);
+		});
+
+		device->dataProcesserThread = new QThread(this);
+		device->dataProcesser = new DataProcesser(nullptr, m_context);
+		device->dataProcesser->setTuning(tuning.tuning(SC_DATA_PROCESS));
+		device->dataProcesser->setDeviceName(device->endpoint.name);
+		device->dataProcesser->moveToThread(device->dataProcesserThread);
+		connect(device->dataProcesserThread, &QThread::finished, device->dataProcesser, &QObject::deleteLater);
+		connect(device->dataProcesser, &DataProcesser::videoImageReady, this, [this, i](int camID, VideoFrame frame){
+			emit videoImageReady(i, camID, frame);
+		}, Qt::QueuedConnection);
+		connect(device->dataProcesser, &DataProcesser::exposureUpdated, this, [this, i](int camID, ExposureStats stats){
+			emit exposureUpdated(i, camID, stats);
+		}, Qt::QueuedConnection);
+		connect(device->dataProcesser, &DataProcesser::sharpnessUpdated, this, [this, i](int camID, double score){
+			emit sharpnessUpdated(i, camID, score);
+		}, Qt::QueuedConnection);
+		connect(device->dataProcesser, &DataProcesser::boardDetected, this, [this, i](int camID, BoardDetection detection){
+			emit boardDetected(i, camID, detection);
+		}, Qt::QueuedConnection);
+		connect(device->dataProcesser, &DataProcesser::markersUpdated, this, [this, i](int camID, MarkerResult result){
+			emit markersUpdated(i, camID, result);
+		}, Qt::QueuedConnection);
+		connect(device->dataProcesser, &DataProcesser::registered, this, [this, i](bool ok){
+			emit dataProcesserRegistered(i, ok);
+		}, Qt::QueuedConnection);
+
+		auto reqAddr = device->endpoint.requestAddr().toLocal8Bit();
+		device->reqSocket = zmq_socket(m_context, ZMQ_REQ);
+		tuning.tuning(SC_REQUEST).apply(device->reqSocket);
+		auto rc = zmq_connect(device->reqSocket, reqAddr.constData());
+		assert(!rc);
+		//the data processer registers from its own thread,it cannot share the GUI's REQ socket
+		device->registerSocket = zmq_socket(m_context, ZMQ_REQ);
+		tuning.tuning(SC_REGISTER).apply(device->registerSocket);
+		rc = zmq_connect(device->registerSocket, reqAddr.constData());
+		assert(!rc);
+		device->dataProcesser->setReqSocket(device->registerSocket);
+
+		m_devices.append(device);
+	}
+
+	m_onlineMetric = MetricsRegistry::instance().gauge("calib_devices_online", "Scanners with a live heartbeat");
+	MetricsRegistry::instance().gauge("calib_devices", "Scanners served by this process")->set(m_devices.size());
+
+	m_statusTimer = new QTimer(this);
+	m_statusTimer->setInterval(HEARTBEAT_TIMEOUT_MS / 4);
+	connect(m_statusTimer, &QTimer::timeout, this, &DeviceManager::checkStatus);
+}
+
+DeviceManager::~DeviceManager()
+{
+	shutdown();
+	qDeleteAll(m_devices);
+}
+
+void DeviceManager::start()
+{
+	for (auto device : m_devices){
+		device->subscriberThread->start();
+		device->dataProcesserThread->start();
+		QMetaObject::invokeMethod(device->subscriber, "setup", Qt::QueuedConnection,
+			Q_ARG(QString, device->endpoint.publishAddr()));
+		QMetaObject::invokeMethod(device->dataProcesser, "setup", Qt::QueuedConnection,
+			Q_ARG(int, device->endpoint.dataPort), Q_ARG(QString, device->endpoint.dataAddr()));
+	}
+	m_statusTimer->start();
+}
+
+void DeviceManager::shutdown()
+{
+	if (!m_context)
+		return;
+	m_statusTimer->stop();
+	for (auto requester : m_requesters){
+		if (requester)
+			requester->close();
+	}
+	//blocked zmq_recv calls in the worker threads return ETERM
+	zmq_ctx_shutdown(m_context);
+	for (auto device : m_devices){
+		device->channel->close();
+		device->subscriberThread->quit();
+		device->dataProcesserThread->quit();
+	}
+	for (auto device : m_devices){
+		device->subscriberThread->wait();
+		device->dataProcesserThread->wait();
+		zmq_close(device->reqSocket);
+		zmq_close(device->registerSocket);
+	}
+	zmq_ctx_term(m_context);
+	m_context = nullptr;
+}
+
+AsyncRequester* DeviceManager::createRequester(int device, QObject* parent)
+{
+	auto requester = new AsyncRequester(m_context, m_devices[device]->endpoint.requestAddr(), m_requestTuning, parent);
+	m_requesters.append(requester);
+	return requester;
+}
+
+int DeviceManager::aliveCount() const
+{
+	int count = 0;
+	for (auto device : m_devices){
+		if (device->alive)
+			count++;
+	}
+	return count;
+}
+
+QString DeviceManager::statusSummary() const
+{
+	QStringList states;
+	for (auto device : m_devices)
+		states << QString("%1:%2").arg(device->endpoint.name, device->alive ? "online" : "offline");
+	return QString("%1/%2 online (%3)").arg(aliveCount()).arg(m_devices.size()).arg(states.join(", "));
+}
+
+void DeviceManager::onHeartbeat(int device)
+{
+	auto d = m_devices[device];
+	d->lastHeartbeat.start();
+	if (!d->alive){
+		d->alive = true;
+		m_onlineMetric->set(aliveCount());
+		emit deviceStatusChanged(device, true);
+		emit statusChanged(aliveCount(), m_devices.size());
+	}
+	emit heartbeat(device);
+}
+
+void DeviceManager::checkStatus()
+{
+	for (int i = 0; i < m_devices.size(); i++){
+		auto d = m_devices[i];
+		if (d->alive && d->lastHeartbeat.elapsed() > HEARTBEAT_TIMEOUT_MS){
+			d->alive = false;
+			qWarning() << "device" << d->endpoint.name << "lost heartbeat";
+			m_onlineMetric->set(aliveCount());
+			emit deviceStatusChanged(i, false);
+			emit statusChanged(aliveCount(), m_devices.size());
+		}
+	}
+}
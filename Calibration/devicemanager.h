@@ -0,0 +1,99 @@
+#ifndef DEVICE_MANAGER_H
+#define DEVICE_MANAGER_H
+
+#include <QObject>
+#include <QList>
+#include <QVector>
+#include <QThread>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <zmq.h>
+#include "subscriber.h"
+#include "dataprocesser.h"
+#include "sockettuning.h"
+#include "metrics.h"
+#include "deviceendpoint.h"
+#include "asyncrequester.h"
+/*
+Owns one connection set(REQ socket,Subscriber thread,DataProcesser thread) per scanner,
+all sharing a single ZMQ context,and aggregates their heartbeat status.
+*/
+class DeviceManager : public QObject
+{
+	Q_OBJECT
+public:
+	explicit DeviceManager(const QList<DeviceEndpoint>& endpoints, const SocketTuningConfig& tuning = SocketTuningConfig(),
+		QObject *parent = nullptr);
+	~DeviceManager();
+
+	int deviceCount() const { return m_devices.size(); }
+	void* context() const { return m_context; }
+	const DeviceEndpoint& endpoint(int device) const { return m_devices[device]->endpoint; }
+	void* requestSocket(int device) const { return m_devices[device]->reqSocket; }
+	Subscriber* subscriber(int device) const { return m_devices[device]->subscriber; }
+	PublishChannel* publishChannel(int device) const { return m_devices[device]->channel; }
+	DataProcesser* dataProcesser(int device) const { return m_devices[device]->dataProcesser; }
+
+	bool isAlive(int device) const { return m_devices[device]->alive; }
+	int aliveCount() const;
+	QString statusSummary() const;
+	/*
+	Start the subscriber loops and register the data processers with every SDK
+	*/
+	void start();
+	/*
+	Unblock the worker threads,join them and terminate the context
+	*/
+	void shutdown();
+	/*
+	Non-blocking REQ socket to the device on the shared context,closed by shutdown
+	*/
+	AsyncRequester* createRequester(int device, QObject* parent = nullptr);
+	const SocketTuning& requestTuning() const { return m_requestTuning; }
+
+	/*
+	deviceCount:number of scanners served by one context
+	ZMQ I/O threads needed,frames travel through shared memory so one thread serves several devices
+	*/
+	static int ioThreadsFor(int deviceCount);
+signals:
+	void heartbeat(int device);
+	void publishReceived(int device, QString majorCmd, QString minorCmd, QByteArray data);
+	void videoImageReady(int device, int camID, VideoFrame frame);
+	void exposureUpdated(int device, int camID, ExposureStats stats);
+	void sharpnessUpdated(int device, int camID, double score);
+	void boardDetected(int device, int camID, BoardDetection detection);
+	void markersUpdated(int device, int camID, MarkerResult result);
+	void deviceStatusChanged(int device, bool alive);
+	void statusChanged(int alive, int total);
+	/*
+	ok:the device's DataProcesser registered with the SDK
+	*/
+	void dataProcesserRegistered(int device, bool ok);
+private:
+	struct Device
+	{
+		DeviceEndpoint endpoint;
+		void* reqSocket = nullptr;
+		void* registerSocket = nullptr;
+		QThread* subscriberThread = nullptr;
+		Subscriber* subscriber = nullptr;
+		PublishChannel* channel = nullptr;
+		QThread* dataProcesserThread = nullptr;
+		DataProcesser* dataProcesser = nullptr;
+		QElapsedTimer lastHeartbeat;
+		bool alive = false;
+	};
+	void onHeartbeat(int device);
+	void checkStatus();
+
+	void* m_context = nullptr;
+	SocketTuning m_requestTuning;
+	QVector<Device*> m_devices;
+	QList<QPointer<AsyncRequester>> m_requesters;
+	QTimer* m_statusTimer = nullptr;
+	MetricGauge* m_onlineMetric = nullptr;
+};
+
+#endif // DEVICE_MANAGER_H
@@ -0,0 +1,161 @@
+#include "exposure.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define EXPOSURE_SSE2
+#endif
+
+namespace
+{
+	const int BANKS = 4;
+
+	//bank b counts every 4th byte,neighbouring equal pixels land in different banks
+	inline void count8(uint32_t (*banks)[256], uint64_t word)
+	{
+		banks[0][word & 0xff]++;
+		banks[1][(word >> 8) & 0xff]++;
+		banks[2][(word >> 16) & 0xff]++;
+		banks[3][(word >> 24) & 0xff]++;
+		banks[0][(word >> 32) & 0xff]++;
+		banks[1][(word >> 40) & 0xff]++;
+		banks[2][(word >> 48) & 0xff]++;
+		banks[3][word >> 56]++;
+	}
+}
+
+void ExposureHistogram::clear()
+{
+	memset(bins, 0, sizeof(bins));
+}
+
+void ExposureHistogram::merge(const ExposureHistogram& other)
+{
+	for (int i = 0; i < 256; i++)
+		bins[i] += other.bins[i];
+}
+
+void ExposureHistogram::accumulateScalar(const unsigned char* data, size_t pixels)
+{
+	for (size_t i = 0; i < pixels; i++)
+		bins[data[i]]++;
+}
+
+void ExposureHistogram::accumulateGray(const unsigned char* data, size_t pixels)
+{
+	uint32_t banks[BANKS][256];
+	memset(banks, 0, sizeof(banks));
+	size_t i = 0;
+#ifdef EXPOSURE_SSE2
+	//one 16 byte load,the two halves are binned from registers
+	for (; i + 16 <= pixels; i += 16){
+		const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+#if defined(__x86_64__) || defined(_M_X64)
+		count8(banks, uint64_t(_mm_cvtsi128_si64(block)));
+		count8(banks, uint64_t(_mm_cvtsi128_si64(_mm_unpackhi_epi64(block, block))));
+#else
+		uint64_t words[2];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(words), block);
+		count8(banks, words[0]);
+		count8(banks, words[1]);
+#endif
+	}
+#else
+	for (; i + 8 <= pixels; i += 8){
+		uint64_t word;
+		memcpy(&word, data + i, sizeof(word));
+		count8(banks, word);
+	}
+#endif
+	for (; i < pixels; i++)
+		banks[0][data[i]]++;
+	for (int b = 0; b < 256; b++)
+		bins[b] += banks[0][b] + banks[1][b] + banks[2][b] + banks[3][b];
+}
+
+void ExposureHistogram::accumulateRgb(const unsigned char* data, size_t pixels)
+{
+	uint32_t banks[2][256];
+	memset(banks, 0, sizeof(banks));
+	size_t i = 0;
+	//luma (r+2g+b)/4
+	for (; i + 2 <= pixels; i += 2, data += 6){
+		banks[0][(data[0] + 2 * data[1] + data[2]) >> 2]++;
+		banks[1][(data[3] + 2 * data[4] + data[5]) >> 2]++;
+	}
+	if (i < pixels)
+		banks[0][(data[0] + 2 * data[1] + data[2]) >> 2]++;
+	for (int b = 0; b < 256; b++)
+		bins[b] += banks[0][b] + banks[1][b];
+}
+
+void ExposureHistogram::accumulate(const unsigned char* data, int width, int height, int channel)
+{
+	if (!data || width <= 0 || height <= 0)
+		return;
+	const size_t pixels = size_t(width) * size_t(height);
+	if (channel == 3)
+		accumulateRgb(data, pixels);
+	else if (channel == 1)
+		accumulateGray(data, pixels);
+}
+
+void ExposureHistogram::accumulateParallel(const unsigned char* data, int width, int height, int channel, WorkerPool* pool)
+{
+	const int threads = std::max(1, std::min(pool ? pool->threads() : 1, height));
+	if (threads == 1){
+		accumulate(data, width, height, channel);
+		return;
+	}
+	//partials are separate objects,no two threads write the same bins
+	std::vector<ExposureHistogram> partials(threads);
+	const int band = (height + threads - 1) / threads;
+	pool->run(threads, [&](int t){
+		const int first = t * band;
+		const int rows = std::min(band, height - first);
+		if (rows > 0)
+			partials[t].accumulate(data + size_t(first) * width * channel, width, rows, channel);
+	});
+	for (const auto& partial : partials)
+		merge(partial);
+}
+
+ExposureStats ExposureHistogram::stats(int saturationLevel) const
+{
+	ExposureStats stats;
+	uint64_t sum = 0, saturated = 0;
+	for (int i = 0; i < 256; i++){
+		stats.pixels += bins[i];
+		sum += uint64_t(bins[i]) * i;
+		if (i > saturationLevel)
+			saturated += bins[i];
+	}
+	if (!stats.pixels)
+		return stats;
+	stats.mean = double(sum) / stats.pixels;
+	stats.saturatedFraction = double(saturated) / stats.pixels;
+
+	const uint64_t p5 = stats.pixels * 5 / 100, p50 = stats.pixels / 2, p95 = stats.pixels * 95 / 100, p99 = stats.pixels * 99 / 100;
+	uint64_t cumulative = 0;
+	stats.min = -1;
+	for (int i = 0; i < 256; i++){
+		if (!bins[i])
+			continue;
+		if (stats.min < 0)
+			stats.min = i;
+		stats.max = i;
+		const uint64_t before = cumulative;
+		cumulative += bins[i];
+		//first bin whose cumulative count passes the rank
+		if (before <= p5 && cumulative > p5)
+			stats.p5 = i;
+		if (before <= p50 && cumulative > p50)
+			stats.p50 = i;
+		if (before <= p95 && cumulative > p95)
+			stats.p95 = i;
+		if (before <= p99 && cumulative > p99)
+			stats.p99 = i;
+	}
+	return stats;
+}
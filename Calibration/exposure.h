@@ -0,0 +1,53 @@
+#ifndef EXPOSURE_H
+#define EXPOSURE_H
+
+#include <cstddef>
+#include <cstdint>
+#include "workerpool.h"
+/*
+256 bin intensity histogram of a camera frame and the exposure figures derived from it.
+The histogram is counted into several banks so that runs of equal pixels do not serialize on one bin,
+the banks and the per-thread partials of accumulateParallel are summed at the end.
+*/
+const int SATURATION_LEVEL = 230;//pixels above are saturated,same as the red overlay
+
+struct ExposureStats
+{
+	uint64_t pixels = 0;
+	double mean = 0;
+	double saturatedFraction = 0;
+	int p5 = 0;//percentiles,bin index
+	int p50 = 0;
+	int p95 = 0;
+	int p99 = 0;
+	int min = 0;
+	int max = 0;
+};
+
+class ExposureHistogram
+{
+public:
+	void clear();
+	/*
+	data:width*height*channel pixels,channel 1 or 3(binned by luma)
+	*/
+	void accumulate(const unsigned char* data, int width, int height, int channel);
+	/*
+	Splits the rows into a band per thread of pool,each counted into its own partial histogram,
+	a null pool counts on the calling thread
+	*/
+	void accumulateParallel(const unsigned char* data, int width, int height, int channel, WorkerPool* pool);
+	/*
+	Single bank byte by byte,reference for the benchmark
+	*/
+	void accumulateScalar(const unsigned char* data, size_t pixels);
+	void merge(const ExposureHistogram& other);
+	ExposureStats stats(int saturationLevel = SATURATION_LEVEL) const;
+
+	uint32_t bins[256] = {};
+private:
+	void accumulateGray(const unsigned char* data, size_t pixels);
+	void accumulateRgb(const unsigned char* data, size_t pixels);
+};
+
+#endif // EXPOSURE_H
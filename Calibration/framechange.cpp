@@ -0,0 +1,81 @@
+#include "framechange.h"
+#include <cstdlib>
+#include <cstring>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRAMECHANGE_SSE2
+#endif
+
+namespace
+{
+	const int BLOCK_SIZE = FrameChangeDetector::BLOCK_BYTES * FrameChangeDetector::BLOCK_ROWS;
+
+	//sum of absolute differences of one block row
+	inline int rowDifference(const unsigned char* a, const unsigned char* b)
+	{
+#ifdef FRAMECHANGE_SSE2
+		const __m128i sad = _mm_sad_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a)),
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(b)));
+		return _mm_cvtsi128_si32(sad) + _mm_cvtsi128_si32(_mm_srli_si128(sad, 8));
+#else
+		int sum = 0;
+		for (int i = 0; i < FrameChangeDetector::BLOCK_BYTES; i++)
+			sum += std::abs(int(a[i]) - int(b[i]));
+		return sum;
+#endif
+	}
+}
+
+bool FrameChangeDetector::layout(int rowBytes, int height, int* columns, int* rows) const
+{
+	if (rowBytes < BLOCK_BYTES * BLOCKS_X || height < BLOCK_ROWS * BLOCKS_Y)
+		return false;
+	//centered in equal cells,never on the frame border
+	for (int i = 0; i < BLOCKS_X; i++)
+		columns[i] = int((2LL * i + 1) * rowBytes / (2 * BLOCKS_X)) - BLOCK_BYTES / 2;
+	for (int j = 0; j < BLOCKS_Y; j++)
+		rows[j] = int((2LL * j + 1) * height / (2 * BLOCKS_Y)) - BLOCK_ROWS / 2;
+	return true;
+}
+
+bool FrameChangeDetector::changed(const unsigned char* data, int width, int height, int bytesPerPixel) const
+{
+	const int rowBytes = width * bytesPerPixel;
+	int columns[BLOCKS_X], rows[BLOCKS_Y];
+	if (m_reference.empty() || rowBytes != m_rowBytes || height != m_height || !layout(rowBytes, height, columns, rows))
+		return true;
+	const int limit = m_tolerance * BLOCK_SIZE;
+	const unsigned char* reference = m_reference.data();
+	for (int j = 0; j < BLOCKS_Y; j++){
+		for (int i = 0; i < BLOCKS_X; i++, reference += BLOCK_SIZE){
+			const unsigned char* block = data + size_t(rows[j]) * rowBytes + columns[i];
+			int difference = 0;
+			for (int r = 0; r < BLOCK_ROWS; r++)
+				difference += rowDifference(block + size_t(r) * rowBytes, reference + r * BLOCK_BYTES);
+			if (difference > limit)
+				return true;
+		}
+	}
+	return false;
+}
+
+void FrameChangeDetector::update(const unsigned char* data, int width, int height, int bytesPerPixel)
+{
+	const int rowBytes = width * bytesPerPixel;
+	int columns[BLOCKS_X], rows[BLOCKS_Y];
+	if (!layout(rowBytes, height, columns, rows)){
+		m_reference.clear();
+		return;
+	}
+	m_rowBytes = rowBytes;
+	m_height = height;
+	m_reference.resize(size_t(BLOCKS_X) * BLOCKS_Y * BLOCK_SIZE);
+	unsigned char* reference = m_reference.data();
+	for (int j = 0; j < BLOCKS_Y; j++){
+		for (int i = 0; i < BLOCKS_X; i++){
+			const unsigned char* block = data + size_t(rows[j]) * rowBytes + columns[i];
+			for (int r = 0; r < BLOCK_ROWS; r++, reference += BLOCK_BYTES)
+				memcpy(reference, block + size_t(r) * rowBytes, BLOCK_BYTES);
+		}
+	}
+}
@@ -0,0 +1,47 @@
+#ifndef FRAME_CHANGE_H
+#define FRAME_CHANGE_H
+
+#include <vector>
+/*
+Cheap test whether a camera frame differs from the last one delivered.
+A grid of BLOCKS_X*BLOCKS_Y small blocks spread over the frame is sampled,about 2% of a 1280x1024 gray frame,
+and every block is compared by its sum of absolute differences to the same block of the reference.
+Any block whose mean difference exceeds the tolerance makes the frame changed,so a board moved in a corner
+is not averaged away by the still rest of the frame.
+*/
+class FrameChangeDetector
+{
+public:
+	static const int BLOCKS_X = 16;
+	static const int BLOCKS_Y = 12;
+	static const int BLOCK_BYTES = 16;//one SSE2 register per block row
+	static const int BLOCK_ROWS = 8;
+
+	/*
+	tolerance:mean absolute difference per sampled byte still counted as unchanged,sensor noise
+	*/
+	explicit FrameChangeDetector(int tolerance = 3) : m_tolerance(tolerance) {}
+	void setTolerance(int tolerance) { m_tolerance = tolerance; }
+
+	/*
+	data:height rows of width*bytesPerPixel bytes
+	Returns true for the first frame,after a size change,for frames too small to sample
+	and when any block differs from the reference by more than the tolerance
+	*/
+	bool changed(const unsigned char* data, int width, int height, int bytesPerPixel) const;
+	/*
+	Samples data as the reference the next frames are compared with
+	*/
+	void update(const unsigned char* data, int width, int height, int bytesPerPixel);
+	void reset() { m_reference.clear(); }
+private:
+	//byte offset of every block in a frame of this size,false when it is too small
+	bool layout(int rowBytes, int height, int* columns, int* rows) const;
+
+	int m_tolerance = 3;
+	int m_rowBytes = 0;
+	int m_height = 0;
+	std::vector<unsigned char> m_reference;//blocks in grid order,BLOCK_ROWS rows of BLOCK_BYTES each
+};
+
+#endif // FRAME_CHANGE_H
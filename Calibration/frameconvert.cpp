@@ -0,0 +1,368 @@
+#include "frameconvert.h"
+#include <QMatrix>
+#include <algorithm>
+#include <cstring>
+#include "exposure.h"
+#include "tracing.h"
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRAMECONVERT_SSE2
+#endif
+
+namespace
+{
+	//below this a frame is converted on the calling thread alone
+	const int PARALLEL_PIXELS = 512 * 1024;
+
+	//gray levels as they are,saturated levels red
+	QVector<QRgb> grayColorTable()
+	{
+		QVector<QRgb> table(256);
+		for (int level = 0; level < 256; level++)
+			table[level] = level > SATURATION_LEVEL ? qRgb(255, 0, 0) : qRgb(level, level, level);
+		return table;
+	}
+
+	const QVector<QRgb>& grayColors()
+	{
+		static const QVector<QRgb> colorTable = grayColorTable();
+		return colorTable;
+	}
+
+	QImage orient(const QImage& image, int width, int rotate)
+	{
+		//rotation and mirroring keep the format and the color table
+		QImage oriented = image;
+		if (rotate % 360 != 0)
+		{
+			QMatrix left_matrix_;
+			left_matrix_.rotate(rotate);
+			oriented = oriented.transformed(left_matrix_);
+		}
+		if (width != 1280)
+			oriented = oriented.mirrored(true); //sign 1121
+		return oriented;
+	}
+
+	//rows [first,last) of a band per thread of pool,all rows on the calling thread without one
+	template <typename Rows>
+	void forEachBand(int height, WorkerPool* pool, const Rows& rows)
+	{
+		const int threads = std::max(1, std::min(pool ? pool->threads() : 1, height));
+		if (threads == 1){
+			rows(0, height);
+			return;
+		}
+		const int band = (height + threads - 1) / threads;
+		pool->run(threads, [&](int t){
+			const int first = t * band;
+			const int last = std::min(height, first + band);
+			if (first < last)
+				rows(first, last);
+		});
+	}
+
+	/*
+	Bilinear demosaic:every color a site lacks is the mean of its nearest sites of that color,
+	which are the left/right,above/below,all four of them or the four diagonals
+	*/
+	enum BayerSource
+	{
+		BS_CENTER,
+		BS_HORIZONTAL,
+		BS_VERTICAL,
+		BS_CROSS,
+		BS_DIAGONAL
+	};
+
+	//red,green and blue of the sites in even and odd columns of a row
+	struct BayerRow
+	{
+		BayerSource even[3];
+		BayerSource odd[3];
+	};
+
+	//0 red,1 green,2 blue,of the 2x2 cell in row major order
+	const int BAYER_CELLS[4][4] = {
+		{ 0, 1, 1, 2 },//RG
+		{ 2, 1, 1, 0 },//BG
+		{ 1, 0, 2, 1 },//GR
+		{ 1, 2, 0, 1 }//GB
+	};
+
+	void sourcesOf(int site, bool redRow, BayerSource* sources)
+	{
+		static const BayerSource red[3] = { BS_CENTER, BS_CROSS, BS_DIAGONAL };
+		static const BayerSource blue[3] = { BS_DIAGONAL, BS_CROSS, BS_CENTER };
+		static const BayerSource greenOnRed[3] = { BS_HORIZONTAL, BS_CENTER, BS_VERTICAL };
+		static const BayerSource greenOnBlue[3] = { BS_VERTICAL, BS_CENTER, BS_HORIZONTAL };
+		const BayerSource* chosen = site == 0 ? red : site == 2 ? blue : redRow ? greenOnRed : greenOnBlue;
+		std::copy(chosen, chosen + 3, sources);
+	}
+
+	BayerRow bayerRow(PixelFormat format, int y)
+	{
+		const int* cell = BAYER_CELLS[format - PF_BAYER_RG8] + (y & 1) * 2;
+		const bool redRow = cell[0] == 0 || cell[1] == 0;
+		BayerRow row;
+		sourcesOf(cell[0], redRow, row.even);
+		sourcesOf(cell[1], redRow, row.odd);
+		return row;
+	}
+
+	//rounds like _mm_avg_epu8,so both paths give the same pixels
+	inline unsigned average(unsigned a, unsigned b)
+	{
+		return (a + b + 1) >> 1;
+	}
+
+	inline unsigned bayerValue(BayerSource source, const unsigned char* above, const unsigned char* center, const unsigned char* below,
+		int left, int x, int right)
+	{
+		switch (source){
+		case BS_CENTER:
+			return center[x];
+		case BS_HORIZONTAL:
+			return average(center[left], center[right]);
+		case BS_VERTICAL:
+			return average(above[x], below[x]);
+		case BS_CROSS:
+			return average(average(center[left], center[right]), average(above[x], below[x]));
+		default:
+			return average(average(above[left], above[right]), average(below[left], below[right]));
+		}
+	}
+
+#ifdef FRAMECONVERT_SSE2
+	struct BayerVectors
+	{
+		__m128i values[5];//indexed by BayerSource
+	};
+
+	inline __m128i load16(const unsigned char* p)
+	{
+		return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+	}
+
+	//lanes set in mask take the first source,the others the second
+	inline __m128i pick(const BayerVectors& vectors, __m128i mask, BayerSource set, BayerSource clear)
+	{
+		return _mm_or_si128(_mm_and_si128(mask, vectors.values[set]), _mm_andnot_si128(mask, vectors.values[clear]));
+	}
+
+	//luminance of 8 pixels widened to 16 bits,rounded like the scalar path
+	inline __m128i luminance8(__m128i red, __m128i green, __m128i blue)
+	{
+		const __m128i sum = _mm_add_epi16(_mm_add_epi16(red, blue), _mm_add_epi16(green, green));
+		return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+	}
+#endif
+
+	/*
+	above,below:neighbouring rows,mirrored at the frame border so they keep the mosaic phase
+	gray:(red+2*green+blue)/4 of every pixel,the luminance the analyses read instead of the mosaic
+	*/
+	void demosaicRow(const unsigned char* above, const unsigned char* center, const unsigned char* below, int width,
+		const BayerRow& row, QRgb* dst, unsigned char* gray)
+	{
+		const auto pixel = [&](int x){
+			//mirrored at the border as well
+			const int left = x > 0 ? x - 1 : 1;
+			const int right = x + 1 < width ? x + 1 : x - 1;
+			const BayerSource* sources = (x & 1) ? row.odd : row.even;
+			const unsigned red = bayerValue(sources[0], above, center, below, left, x, right);
+			const unsigned green = bayerValue(sources[1], above, center, below, left, x, right);
+			const unsigned blue = bayerValue(sources[2], above, center, below, left, x, right);
+			dst[x] = qRgb(red, green, blue);
+			gray[x] = (unsigned char)((red + 2 * green + blue + 2) >> 2);
+		};
+		pixel(0);
+		int x = 1;
+#ifdef FRAMECONVERT_SSE2
+		//16 pixels per step from column 1,so lane 0 is an odd column
+		const __m128i oddColumns = _mm_set1_epi16(0x00ff);
+		const __m128i alpha = _mm_set1_epi8(char(0xff));
+		const __m128i zero = _mm_setzero_si128();
+		for (; x + 17 <= width; x += 16){
+			BayerVectors vectors;
+			const __m128i centerLeft = load16(center + x - 1), centerRight = load16(center + x + 1);
+			vectors.values[BS_CENTER] = load16(center + x);
+			vectors.values[BS_HORIZONTAL] = _mm_avg_epu8(centerLeft, centerRight);
+			vectors.values[BS_VERTICAL] = _mm_avg_epu8(load16(above + x), load16(below + x));
+			vectors.values[BS_CROSS] = _mm_avg_epu8(vectors.values[BS_HORIZONTAL], vectors.values[BS_VERTICAL]);
+			vectors.values[BS_DIAGONAL] = _mm_avg_epu8(_mm_avg_epu8(load16(above + x - 1), load16(above + x + 1)),
+				_mm_avg_epu8(load16(below + x - 1), load16(below + x + 1)));
+			const __m128i red = pick(vectors, oddColumns, row.odd[0], row.even[0]);
+			const __m128i green = pick(vectors, oddColumns, row.odd[1], row.even[1]);
+			const __m128i blue = pick(vectors, oddColumns, row.odd[2], row.even[2]);
+			//0xffRRGGBB is B,G,R,A in memory
+			const __m128i blueGreenLow = _mm_unpacklo_epi8(blue, green), blueGreenHigh = _mm_unpackhi_epi8(blue, green);
+			const __m128i redAlphaLow = _mm_unpacklo_epi8(red, alpha), redAlphaHigh = _mm_unpackhi_epi8(red, alpha);
+			auto out = reinterpret_cast<__m128i*>(dst + x);
+			_mm_storeu_si128(out, _mm_unpacklo_epi16(blueGreenLow, redAlphaLow));
+			_mm_storeu_si128(out + 1, _mm_unpackhi_epi16(blueGreenLow, redAlphaLow));
+			_mm_storeu_si128(out + 2, _mm_unpacklo_epi16(blueGreenHigh, redAlphaHigh));
+			_mm_storeu_si128(out + 3, _mm_unpackhi_epi16(blueGreenHigh, redAlphaHigh));
+			const __m128i grayLow = luminance8(_mm_unpacklo_epi8(red, zero), _mm_unpacklo_epi8(green, zero), _mm_unpacklo_epi8(blue, zero));
+			const __m128i grayHigh = luminance8(_mm_unpackhi_epi8(red, zero), _mm_unpackhi_epi8(green, zero), _mm_unpackhi_epi8(blue, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(gray + x), _mm_packus_epi16(grayLow, grayHigh));
+		}
+#endif
+		for (; x < width; x++)
+			pixel(x);
+	}
+
+	void windowRow(const unsigned char* src, int width, const unsigned char* table, unsigned char* dst)
+	{
+		for (int x = 0; x < width; x++, src += 2)
+			dst[x] = table[src[0] | (src[1] << 8)];
+	}
+}
+
+PixelFormat pixelFormatFromName(const char* name, int size, int channel)
+{
+	if (!name || size <= 0)
+		return channel == 3 ? PF_RGB8 : channel == 1 ? PF_MONO8 : PF_UNKNOWN;
+	static const struct { const char* name; PixelFormat format; } FORMATS[] = {
+		{ "Mono8", PF_MONO8 },
+		{ "RGB8", PF_RGB8 },
+		{ "BayerRG8", PF_BAYER_RG8 },
+		{ "BayerBG8", PF_BAYER_BG8 },
+		{ "BayerGR8", PF_BAYER_GR8 },
+		{ "BayerGB8", PF_BAYER_GB8 },
+		{ "Mono10", PF_MONO10 },
+		{ "Mono12", PF_MONO12 },
+		{ "Mono16", PF_MONO16 }
+	};
+	for (const auto& entry : FORMATS){
+		if (strlen(entry.name) == size_t(size) && !memcmp(entry.name, name, size_t(size)))
+			return entry.format;
+	}
+	return PF_UNKNOWN;
+}
+
+int pixelFormatBits(PixelFormat format)
+{
+	switch (format){
+	case PF_MONO10:
+		return 10;
+	case PF_MONO12:
+		return 12;
+	case PF_MONO16:
+		return 16;
+	default:
+		return 8;
+	}
+}
+
+int pixelFormatBytes(PixelFormat format)
+{
+	if (format == PF_RGB8)
+		return 3;
+	return pixelFormatBits(format) > 8 ? 2 : 1;
+}
+
+QImage convertFrame(const unsigned char* data, int width, int height, int channel, int rotate)
+{
+	TRACE_SCOPE("convertFrame");
+	QImage image;
+	if (3 == channel)
+	{
+		//RGB32 is blitted by the raster engine without a conversion
+		image = QImage(width, height, QImage::Format_RGB32);
+		for (int y = 0; y < height; y++)
+		{
+			auto dst = reinterpret_cast<QRgb*>(image.scanLine(y));
+			auto src = data + size_t(y) * width * 3;
+			for (int x = 0; x < width; x++, src += 3)
+				dst[x] = qRgb(src[0], src[1], src[2]);
+		}
+	}
+	else
+	{
+		//one byte per pixel up to the paint,the color table paints saturated pixels red
+		image = QImage(width, height, QImage::Format_Indexed8);
+		image.setColorTable(grayColors());
+		if (image.bytesPerLine() == width)
+			memcpy(image.bits(), data, size_t(width) * height);
+		else
+		{
+			for (int y = 0; y < height; y++)
+				memcpy(image.scanLine(y), data + size_t(y) * width, size_t(width));
+		}
+	}
+	return orient(image, width, rotate);
+}
+
+QImage FrameConverter::convert(const unsigned char* data, int width, int height, PixelFormat format, int rotate, int windowLow, int windowHigh)
+{
+	m_analysisData = data;
+	m_analysisChannel = format == PF_RGB8 ? 3 : 1;
+	m_windowed = QImage();
+	if (format == PF_MONO8 || format == PF_RGB8)
+		return convertFrame(data, width, height, m_analysisChannel, rotate);
+	if (format == PF_UNKNOWN || width < 2 || height < 2){
+		m_analysisData = nullptr;
+		return QImage();
+	}
+
+	const auto pool = width * height >= PARALLEL_PIXELS ? m_pool : nullptr;
+	QImage image;
+	if (isBayer(format)){
+		TRACE_SCOPE("demosaic");
+		image = QImage(width, height, QImage::Format_RGB32);
+		//scanLine() detaches,the workers get plain pointers
+		const auto bits = image.bits();
+		const int stride = image.bytesPerLine();
+		m_luminance.resize(size_t(width) * height);
+		const auto luminance = m_luminance.data();
+		forEachBand(height, pool, [&](int first, int last){
+			for (int y = first; y < last; y++){
+				const auto row = data + size_t(y) * width;
+				const auto above = data + size_t(y > 0 ? y - 1 : 1) * width;
+				const auto below = data + size_t(y + 1 < height ? y + 1 : y - 1) * width;
+				demosaicRow(above, row, below, width, bayerRow(format, y), reinterpret_cast<QRgb*>(bits + size_t(y) * stride),
+					luminance + size_t(y) * width);
+			}
+		});
+		m_analysisData = luminance;
+	}
+	else{
+		TRACE_SCOPE("windowLevels");
+		const bool fullRange = windowLow == 0 && windowHigh == 0;
+		const auto table = windowTable(fullRange ? 0 : windowLow, fullRange ? (1 << pixelFormatBits(format)) - 1 : windowHigh);
+		//rows without padding,the analysis reads them as one block
+		auto levels = new unsigned char[size_t(width) * height];
+		image = QImage(levels, width, height, width, QImage::Format_Indexed8,
+			[](void* info){ delete[] static_cast<unsigned char*>(info); }, levels);
+		image.setColorTable(grayColors());
+		forEachBand(height, pool, [&](int first, int last){
+			for (int y = first; y < last; y++)
+				windowRow(data + size_t(y) * width * 2, width, table, levels + size_t(y) * width);
+		});
+		m_windowed = image;
+		m_analysisData = levels;
+	}
+	return orient(image, width, rotate);
+}
+
+const unsigned char* FrameConverter::windowTable(int low, int high)
+{
+	low = qBound(0, low, 65534);
+	high = qBound(low + 1, high, 65535);
+	if (low == m_windowLow && high == m_windowHigh)
+		return m_windowTable.data();
+	//every 16-bit word,levels above the bit depth are white
+	m_windowTable.resize(65536);
+	for (int level = 0; level < 65536; level++){
+		if (level <= low)
+			m_windowTable[level] = 0;
+		else if (level >= high)
+			m_windowTable[level] = 255;
+		else
+			m_windowTable[level] = (unsigned char)(((level - low) * 255 + (high - low) / 2) / (high - low));
+	}
+	m_windowLow = low;
+	m_windowHigh = high;
+	return m_windowTable.data();
+}
@@ -0,0 +1,89 @@
+#ifndef FRAME_CONVERT_H
+#define FRAME_CONVERT_H
+
+#include <QImage>
+#include <vector>
+#include "workerpool.h"
+/*
+Camera frame as sent by the SDK to the image shown in a VideoWidget
+*/
+
+/*
+Pixel layout of a video frame,the pixelFormat of its props
+*/
+enum PixelFormat
+{
+	PF_UNKNOWN,
+	PF_MONO8,
+	PF_RGB8,
+	//8-bit mosaic named after its top left 2x2 cell,e.g. RG:red green/green blue
+	PF_BAYER_RG8,
+	PF_BAYER_BG8,
+	PF_BAYER_GR8,
+	PF_BAYER_GB8,
+	//one level per 16-bit little endian word,not packed
+	PF_MONO10,
+	PF_MONO12,
+	PF_MONO16
+};
+
+/*
+name:pixelFormat of the props,e.g. "BayerRG8" or "Mono12",size bytes
+channel:used when there is no pixelFormat,1 is Mono8 and 3 is RGB8
+Returns PF_UNKNOWN for a format that cannot be shown
+*/
+PixelFormat pixelFormatFromName(const char* name, int size, int channel);
+inline bool isBayer(PixelFormat format) { return format >= PF_BAYER_RG8 && format <= PF_BAYER_GB8; }
+//significant bits of a 16-bit format,8 otherwise
+int pixelFormatBits(PixelFormat format);
+//bytes of one pixel in the frame data
+int pixelFormatBytes(PixelFormat format);
+
+/*
+data:width*height*channel pixels,channel 1(gray) or 3(RGB)
+rotate:The rotation angle of the picture,in degrees
+Returns a Format_RGB32 image for color frames and a Format_Indexed8 image for gray frames,
+whose color table shows saturated gray levels red
+*/
+QImage convertFrame(const unsigned char* data, int width, int height, int channel, int rotate);
+
+/*
+Converts frames of every PixelFormat in one pass over the raw pixels,in row bands on the threads of a pool for large frames.
+Bayer mosaics are demosaiced bilinearly into Format_RGB32,16-bit levels are windowed into Format_Indexed8 through a lookup table.
+*/
+class FrameConverter
+{
+public:
+	/*
+	pool:a band per thread,null converts on the calling thread
+	*/
+	explicit FrameConverter(WorkerPool* pool = nullptr) : m_pool(pool) {}
+	void setPool(WorkerPool* pool) { m_pool = pool; }
+
+	/*
+	data:width*height pixels of format as the SDK wrote them
+	windowLow,windowHigh:levels of a 16-bit format shown black and white,both 0 for the whole range of its bits
+	Returns a null image when the format is unknown or the frame is smaller than 2x2
+	*/
+	QImage convert(const unsigned char* data, int width, int height, PixelFormat format, int rotate, int windowLow = 0, int windowHigh = 0);
+	/*
+	8-bit pixels of the last converted frame before rotation,what exposure,sharpness and the detectors read:
+	the frame itself for Mono8 and RGB8,the luminance (R+2G+B)/4 the demosaic wrote for Bayer,
+	the windowed levels for 16-bit formats.Valid until the next convert
+	*/
+	const unsigned char* analysisData() const { return m_analysisData; }
+	int analysisChannel() const { return m_analysisChannel; }
+private:
+	const unsigned char* windowTable(int low, int high);
+
+	WorkerPool* m_pool = nullptr;
+	const unsigned char* m_analysisData = nullptr;
+	int m_analysisChannel = 1;
+	QImage m_windowed;//keeps the windowed levels alive for the analysis
+	std::vector<unsigned char> m_luminance;//of Bayer frames,reused
+	std::vector<unsigned char> m_windowTable;
+	int m_windowLow = -1;
+	int m_windowHigh = -1;
+};
+
+#endif // FRAME_CONVERT_H
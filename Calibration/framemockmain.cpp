@@ -0,0 +1,98 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QThread>
+#include <QtDebug>
+#include <vector>
+#include <csignal>
+#include "framering.h"
+/*
+Calibration-FrameRingMock:stands in for the scanner SDK on the shm frame path.
+Writes a moving test pattern into <name>.cam0/.cam1,start Calibration-Demo --frame-ring <name> against it.
+*/
+namespace
+{
+	volatile std::sig_atomic_t stopRequested = 0;
+
+	void onSignal(int)
+	{
+		stopRequested = 1;
+	}
+
+	//gradient with a bright bar moving across,the bar crosses the saturation threshold
+	void fillPattern(std::vector<unsigned char>& frame, const FrameInfo& info, uint64_t number, int camera)
+	{
+		const uint32_t bar = uint32_t(number * 8 + camera * info.width / 2) % info.width;
+		for (uint32_t y = 0; y < info.height; y++){
+			auto row = frame.data() + size_t(y) * info.width * info.channel;
+			for (uint32_t x = 0; x < info.width; x++){
+				unsigned char value = x >= bar && x < bar + 32 ? 250 : (unsigned char)((x + y + number) & 0x7f);
+				for (uint32_t c = 0; c < info.channel; c++)
+					row[x * info.channel + c] = value;
+			}
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication a(argc, argv);
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Produce synthetic camera frames into shm frame rings");
+	parser.addHelpOption();
+	QCommandLineOption nameOption("name", "Ring base name,one ring per camera <name>.cam<n>", "name", "/calib");
+	QCommandLineOption widthOption("width", "Frame width", "px", "1280");
+	QCommandLineOption heightOption("height", "Frame height", "px", "1024");
+	QCommandLineOption channelOption("channel", "Bytes per pixel,1 or 3", "n", "1");
+	QCommandLineOption fpsOption("fps", "Frames per second per camera", "n", "30");
+	QCommandLineOption camerasOption("cameras", "Number of cameras,1 or 2", "n", "2");
+	QCommandLineOption slotsOption("slots", "Slots per ring", "n", "4");
+	parser.addOption(nameOption);
+	parser.addOption(widthOption);
+	parser.addOption(heightOption);
+	parser.addOption(channelOption);
+	parser.addOption(fpsOption);
+	parser.addOption(camerasOption);
+	parser.addOption(slotsOption);
+	parser.process(a);
+
+	FrameInfo info;
+	info.width = parser.value(widthOption).toUInt();
+	info.height = parser.value(heightOption).toUInt();
+	info.channel = parser.value(channelOption).toUInt();
+	info.bytes = info.width * info.height * info.channel;
+	const int cameras = qBound(1, parser.value(camerasOption).toInt(), 2);
+	const int fps = qMax(1, parser.value(fpsOption).toInt());
+	if (!info.bytes || (info.channel != 1 && info.channel != 3))
+		parser.showHelp(1);
+
+	FrameRingWriter rings[2];
+	for (int i = 0; i < cameras; i++){
+		const QByteArray name = parser.value(nameOption).toLatin1() + ".cam" + QByteArray::number(i);
+		if (!rings[i].create(name.constData(), qMax(2u, parser.value(slotsOption).toUInt()), info.bytes)){
+			qCritical() << "cannot create frame ring" << name;
+			return 1;
+		}
+		qInfo() << "writing" << name << info.width << "x" << info.height << "x" << info.channel << "at" << fps << "fps";
+	}
+	std::signal(SIGINT, onSignal);
+	std::signal(SIGTERM, onSignal);
+
+	std::vector<unsigned char> frame(info.bytes);
+	const int64_t periodNs = 1000000000LL / fps;
+	int64_t next = frameRingNow();
+	for (uint64_t number = 0; !stopRequested; number++){
+		for (int i = 0; i < cameras; i++){
+			fillPattern(frame, info, number, i);
+			info.frameNumber = number;
+			info.timestampNs = frameRingNow();
+			rings[i].write(info, frame.data());
+		}
+		next += periodNs;
+		const int64_t waitNs = next - frameRingNow();
+		if (waitNs > 0)
+			QThread::usleep(waitNs / 1000);
+	}
+	//rings unlink on destruction so a stale ring is not picked up by the next client
+	return 0;
+}
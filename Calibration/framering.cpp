@@ -0,0 +1,192 @@
+#include "framering.h"
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace FrameRingLayout;
+
+int64_t frameRingNow()
+{
+	//steady_clock is CLOCK_MONOTONIC on Linux,comparable across processes
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+FrameRingWriter::~FrameRingWriter()
+{
+	close();
+}
+
+FrameRingReader::~FrameRingReader()
+{
+	close();
+}
+
+#ifdef __linux__
+
+bool FrameRingWriter::create(const char* name, uint32_t slotCount, uint32_t slotBytes)
+{
+	close();
+	if (slotCount < 2 || !slotBytes || strlen(name) >= sizeof(m_name))
+		return false;
+	//never truncate a ring readers may have mapped,they would fault on its pages
+	shm_unlink(name);
+	int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0){
+		perror("shm_open");
+		return false;
+	}
+	const size_t size = mappingSize(slotCount, slotBytes);
+	if (ftruncate(fd, off_t(size)) != 0){
+		perror("ftruncate");
+		::close(fd);
+		shm_unlink(name);
+		return false;
+	}
+	void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (mapping == MAP_FAILED){
+		perror("mmap");
+		shm_unlink(name);
+		return false;
+	}
+
+	//ftruncate zero filled the mapping,every sequence and the written counter start at 0
+	auto header = static_cast<Header*>(mapping);
+	header->version = VERSION;
+	header->slotCount = slotCount;
+	header->slotBytes = slotBytes;
+	//readers check the magic last
+	std::atomic_thread_fence(std::memory_order_release);
+	memcpy(header->magic, MAGIC, sizeof(MAGIC));
+
+	m_header = header;
+	m_size = size;
+	strcpy(m_name, name);
+	return true;
+}
+
+void FrameRingWriter::close()
+{
+	if (!m_header)
+		return;
+	munmap(m_header, m_size);
+	shm_unlink(m_name);
+	m_header = nullptr;
+	m_size = 0;
+}
+
+bool FrameRingWriter::write(const FrameInfo& info, const void* data)
+{
+	if (!m_header || info.bytes > m_header->slotBytes)
+		return false;
+	const uint64_t written = m_header->written.load(std::memory_order_relaxed);
+	auto base = reinterpret_cast<char*>(m_header) + sizeof(Header);
+	auto header = reinterpret_cast<SlotHeader*>(base + (written % m_header->slotCount) * slotStride(m_header->slotBytes));
+
+	const uint64_t sequence = header->sequence.load(std::memory_order_relaxed);
+	header->sequence.store(sequence + 1, std::memory_order_relaxed);
+	//readers must see the odd sequence before any byte of the new frame
+	std::atomic_thread_fence(std::memory_order_release);
+	header->info = info;
+	memcpy(reinterpret_cast<unsigned char*>(header) + sizeof(SlotHeader), data, info.bytes);
+	header->sequence.store(sequence + 2, std::memory_order_release);
+	m_header->written.store(written + 1, std::memory_order_release);
+	return true;
+}
+
+bool FrameRingReader::open(const char* name)
+{
+	close();
+	int fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(Header)){
+		::close(fd);
+		return false;
+	}
+	void* mapping = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+	if (mapping == MAP_FAILED){
+		::close(fd);
+		return false;
+	}
+
+	auto header = static_cast<Header*>(mapping);
+	bool valid = memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0;
+	std::atomic_thread_fence(std::memory_order_acquire);
+	valid = valid && header->version == VERSION && header->slotCount >= 2
+		&& mappingSize(header->slotCount, header->slotBytes) <= size_t(st.st_size);
+	if (!valid){
+		munmap(mapping, size_t(st.st_size));
+		::close(fd);
+		return false;
+	}
+	m_header = header;
+	m_size = size_t(st.st_size);
+	m_stride = slotStride(header->slotBytes);
+	m_fd = fd;
+	m_skipped = 0;
+	m_progressNs = frameRingNow();
+	//start with the newest frame,frames before we attached are not counted as skipped
+	const uint64_t written = header->written.load(std::memory_order_acquire);
+	m_lastWritten = written ? written - 1 : 0;
+	return true;
+}
+
+void FrameRingReader::close()
+{
+	if (!m_header)
+		return;
+	munmap(m_header, m_size);
+	::close(m_fd);
+	m_fd = -1;
+	m_header = nullptr;
+	m_size = 0;
+}
+
+bool FrameRingReader::replaced() const
+{
+	if (!m_header)
+		return false;
+	//shm_unlink drops the only link,our mapping stays valid but nothing writes it any more
+	struct stat st;
+	return fstat(m_fd, &st) != 0 || st.st_nlink == 0;
+}
+
+#else
+
+bool FrameRingWriter::create(const char*, uint32_t, uint32_t)
+{
+	return false;
+}
+
+void FrameRingWriter::close()
+{
+}
+
+bool FrameRingWriter::write(const FrameInfo&, const void*)
+{
+	return false;
+}
+
+bool FrameRingReader::open(const char*)
+{
+	return false;
+}
+
+void FrameRingReader::close()
+{
+}
+
+bool FrameRingReader::replaced() const
+{
+	return false;
+}
+
+#endif // __linux__
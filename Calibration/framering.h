@@ -0,0 +1,180 @@
+#ifndef FRAME_RING_H
+#define FRAME_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+/*
+Camera frames in POSIX shared memory(Linux),one ring per camera.
+The producer writes N fixed size slots round robin,every slot carries a sequence counter that is odd
+while the slot is written(seqlock).The consumer reads the newest complete slot without locks
+and without a request/reply round trip,frames it was too slow for are skipped.
+*/
+struct FrameInfo
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t channel = 0;
+	int32_t rotate = 0;
+	uint32_t bytes = 0;//payload size,width*height*channel
+	uint32_t reserved = 0;
+	int64_t timestampNs = 0;//CLOCK_MONOTONIC when the producer finished the frame
+	uint64_t frameNumber = 0;
+};
+
+namespace FrameRingLayout
+{
+	const char MAGIC[8] = { 'S', 'N', 'F', 'R', 'A', 'M', 'E', '1' };
+	const uint32_t VERSION = 1;
+	const size_t ALIGN = 64;
+
+	//one cache line at the start of the mapping
+	struct Header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t slotCount;
+		uint32_t slotBytes;
+		uint32_t reserved;
+		std::atomic<uint64_t> written;//frames completed since creation
+		char pad[ALIGN - 8 - 4 * 4 - sizeof(std::atomic<uint64_t>)];
+	};
+
+	//one cache line in front of every slot's payload
+	struct SlotHeader
+	{
+		std::atomic<uint64_t> sequence;//odd while the producer writes the slot
+		FrameInfo info;
+		char pad[ALIGN - sizeof(std::atomic<uint64_t>) - sizeof(FrameInfo)];
+	};
+
+	inline size_t slotStride(uint32_t slotBytes)
+	{
+		return sizeof(SlotHeader) + (slotBytes + ALIGN - 1) / ALIGN * ALIGN;
+	}
+	inline size_t mappingSize(uint32_t slotCount, uint32_t slotBytes)
+	{
+		return sizeof(Header) + size_t(slotCount) * slotStride(slotBytes);
+	}
+}
+
+/*
+Monotonic clock shared by producer and consumer processes
+*/
+int64_t frameRingNow();
+
+class FrameRingWriter
+{
+public:
+	FrameRingWriter() = default;
+	~FrameRingWriter();
+	FrameRingWriter(const FrameRingWriter&) = delete;
+	FrameRingWriter& operator=(const FrameRingWriter&) = delete;
+
+	/*
+	name:shm object name,e.g. /calib.cam0
+	slotBytes:largest frame payload
+	Replaces an existing ring of the same name:it is unlinked and a new object is created,
+	readers still mapping the old one see it unlinked instead of a ring truncated under them
+	*/
+	bool create(const char* name, uint32_t slotCount, uint32_t slotBytes);
+	/*
+	Unmap and unlink the shm object
+	*/
+	void close();
+	bool isOpen() const { return m_header != nullptr; }
+	/*
+	Returns false when the payload does not fit a slot
+	*/
+	bool write(const FrameInfo& info, const void* data);
+private:
+	FrameRingLayout::Header* m_header = nullptr;
+	size_t m_size = 0;
+	char m_name[256] = { 0 };
+};
+
+enum FrameRingResult
+{
+	FR_NONE = 0,//no frame newer than the last one read
+	FR_OK,
+	FR_TORN,//the producer overwrote the slot while it was read,discard what consume produced
+	FR_RESTARTED//the frame counter went back,the ring was created again:close and open it
+};
+
+class FrameRingReader
+{
+public:
+	FrameRingReader() = default;
+	~FrameRingReader();
+	FrameRingReader(const FrameRingReader&) = delete;
+	FrameRingReader& operator=(const FrameRingReader&) = delete;
+
+	/*
+	Fails while the producer has not created the ring yet
+	*/
+	bool open(const char* name);
+	void close();
+	bool isOpen() const { return m_header != nullptr; }
+	/*
+	True when the mapped object was unlinked,a restarted producer writes a new ring of the same name:close and open it
+	*/
+	bool replaced() const;
+	/*
+	Nanoseconds since the open or the last frame the producer completed
+	*/
+	int64_t idleNs() const { return frameRingNow() - m_progressNs; }
+	/*
+	consume(const FrameInfo&, const unsigned char* data) reads the newest complete frame in place.
+	It must not keep the pointer,its result is only valid when FR_OK is returned.
+	*/
+	template <typename Consume>
+	FrameRingResult readLatest(Consume consume);
+	/*
+	Frames the producer completed that were never read
+	*/
+	uint64_t skipped() const { return m_skipped; }
+private:
+	FrameRingLayout::SlotHeader* slot(uint64_t index) const
+	{
+		auto base = reinterpret_cast<char*>(m_header) + sizeof(FrameRingLayout::Header);
+		return reinterpret_cast<FrameRingLayout::SlotHeader*>(base + (index % m_header->slotCount) * m_stride);
+	}
+
+	FrameRingLayout::Header* m_header = nullptr;
+	size_t m_size = 0;
+	size_t m_stride = 0;
+	int m_fd = -1;//kept open for replaced()
+	uint64_t m_lastWritten = 0;
+	uint64_t m_skipped = 0;
+	int64_t m_progressNs = 0;
+};
+
+template <typename Consume>
+FrameRingResult FrameRingReader::readLatest(Consume consume)
+{
+	const uint64_t written = m_header->written.load(std::memory_order_acquire);
+	if (written == m_lastWritten)
+		return FR_NONE;
+	//a producer that started over,slot(written - 1) and the skipped count would wrap
+	if (written < m_lastWritten)
+		return FR_RESTARTED;
+	m_progressNs = frameRingNow();
+	auto header = slot(written - 1);
+	const uint64_t before = header->sequence.load(std::memory_order_acquire);
+	//the producer lapped the ring and is rewriting the newest slot,try again on the next poll
+	if (before & 1)
+		return FR_TORN;
+	const FrameInfo info = header->info;
+	if (info.bytes > m_header->slotBytes)
+		return FR_TORN;
+	consume(info, reinterpret_cast<const unsigned char*>(header + 1));
+	//the payload reads above must complete before the sequence is checked again
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (header->sequence.load(std::memory_order_relaxed) != before)
+		return FR_TORN;
+	m_skipped += written - m_lastWritten - 1;
+	m_lastWritten = written;
+	return FR_OK;
+}
+
+#endif // FRAME_RING_H
@@ -0,0 +1,89 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QScopedPointer>
+#include <QtDebug>
+#include "headlessrunner.h"
+#include "metrics.h"
+#include "startuptimeline.h"
+
+int main(int argc, char *argv[])
+{
+	StartupTimeline::start();
+
+	QCoreApplication a(argc, argv);
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Run one calibration without a display,the exit code reports the result");
+	parser.addHelpOption();
+	QCommandLineOption deviceOption("device", "Scanner SDK endpoint [name@]host[:pubPort:reqPort:dataPort[:dataHost]]", "spec");
+	QCommandLineOption subTypeOption("sub-type", "Device sub type,DST_PRO or DST_PRO_PLUS", "type", "DST_PRO");
+	QCommandLineOption caliTypeOption("cali-type", "CT_STEREO,CT_WHITE_BALANCE,CT_HD or CT_DEFINITION", "type", "CT_STEREO");
+	QCommandLineOption connectTimeoutOption("connect-timeout", "Seconds to wait for the first heartbeat", "seconds", "10");
+	QCommandLineOption timeoutOption("timeout", "Seconds to wait for all calibration distances", "seconds", "600");
+	QCommandLineOption stepTimeoutOption("step-timeout", "Seconds each request step may take before it is retried", "seconds");
+	QCommandLineOption retriesOption("retries", "Resends of a timed out request step", "count");
+	QCommandLineOption recordOption("record", "Record the SDK publish stream to <file> for Calibration-Replay", "file");
+	QCommandLineOption sessionLogOption("session-log", "Append the calibration session to <file>, query it with Calibration-Sessions", "file");
+	QCommandLineOption socketConfigOption("socket-config", "Per channel ZMQ socket options (ini file)", "file");
+	QCommandLineOption metricsOption("metrics-file", "Rewrite Prometheus metrics into <file> every 5 seconds", "file");
+	parser.addOption(deviceOption);
+	parser.addOption(subTypeOption);
+	parser.addOption(caliTypeOption);
+	parser.addOption(connectTimeoutOption);
+	parser.addOption(timeoutOption);
+	parser.addOption(stepTimeoutOption);
+	parser.addOption(retriesOption);
+	parser.addOption(recordOption);
+	parser.addOption(sessionLogOption);
+	parser.addOption(socketConfigOption);
+	parser.addOption(metricsOption);
+	parser.process(a);
+
+	HeadlessRunner::Options options;
+	options.endpoint.name = QStringLiteral("default");
+	if (parser.isSet(deviceOption) && !DeviceEndpoint::parse(parser.value(deviceOption), options.endpoint)){
+		qCritical() << "invalid device endpoint:" << parser.value(deviceOption);
+		return HE_USAGE;
+	}
+	if (parser.isSet(socketConfigOption) && !options.tuning.load(parser.value(socketConfigOption)))
+		return HE_USAGE;
+	options.subType = parser.value(subTypeOption);
+	options.caliType = parser.value(caliTypeOption);
+	bool ok = false;
+	options.connectTimeoutMs = parser.value(connectTimeoutOption).toInt(&ok) * 1000;
+	if (!ok || options.connectTimeoutMs <= 0){
+		qCritical() << "invalid --connect-timeout:" << parser.value(connectTimeoutOption);
+		return HE_USAGE;
+	}
+	options.caliTimeoutMs = parser.value(timeoutOption).toInt(&ok) * 1000;
+	if (!ok || options.caliTimeoutMs <= 0){
+		qCritical() << "invalid --timeout:" << parser.value(timeoutOption);
+		return HE_USAGE;
+	}
+	if (parser.isSet(stepTimeoutOption)){
+		options.stepTimeoutMs = parser.value(stepTimeoutOption).toInt(&ok) * 1000;
+		if (!ok || options.stepTimeoutMs <= 0){
+			qCritical() << "invalid --step-timeout:" << parser.value(stepTimeoutOption);
+			return HE_USAGE;
+		}
+	}
+	if (parser.isSet(retriesOption)){
+		options.retries = parser.value(retriesOption).toInt(&ok);
+		if (!ok || options.retries < 0){
+			qCritical() << "invalid --retries:" << parser.value(retriesOption);
+			return HE_USAGE;
+		}
+	}
+	options.recordFile = parser.value(recordOption);
+	options.sessionLog = parser.value(sessionLogOption);
+
+	QScopedPointer<MetricsExporter> metricsExporter;
+	if (parser.isSet(metricsOption))
+		metricsExporter.reset(new MetricsExporter(parser.value(metricsOption), 5000));
+
+	HeadlessRunner runner(options);
+	QObject::connect(&runner, &HeadlessRunner::finished, &a, &QCoreApplication::exit, Qt::QueuedConnection);
+	runner.start();
+
+	return a.exec();
+}
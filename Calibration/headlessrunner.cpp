@@ -0,0 +1,201 @@
+#include "headlessrunner.h"
+#include <QJsonDocument>
+#include <QtDebug>
+#include <cassert>
+#include "startuptimeline.h"
+
+namespace
+{
+	//same as DeviceManager,the SDK publishes a heartbeat every 200ms
+	const int HEARTBEAT_TIMEOUT_MS = 2100;
+	//the pull runs on the event loop thread,an SDK that stopped answering must not hang it
+	const int PULL_TIMEOUT_MS = 5000;
+}
+
+HeadlessRunner::HeadlessRunner(const Options& options, QObject *parent)
+	: QObject(parent), m_options(options)
+{
+	m_context = zmq_ctx_new();
+	m_options.tuning.report();
+
+	m_subscriber = new Subscriber(nullptr, m_context);
+	m_subscriber->setTuning(m_options.tuning.tuning(SC_PUBLISH));
+	m_subscriber->setDeviceName(m_options.endpoint.name);
+	if (!m_options.recordFile.isEmpty())
+		m_subscriber->setRecordFile(m_options.recordFile);
+	m_subscriber->moveToThread(&m_subscriberThread);
+	connect(&m_subscriberThread, &QThread::finished, m_subscriber, &QObject::deleteLater);
+
+	m_channel = new PublishChannel(1024, this);
+	m_channel->setDeviceName(m_options.endpoint.name);
+	m_channel->setPolicy(QStringLiteral("progress"), OP_LATEST);
+	m_channel->setPolicy(QStringLiteral("cali/time"), OP_LATEST);
+	m_channel->setPolicy(QStringLiteral("cali/currentCaliDist"), OP_LATEST);
+	m_channel->setPolicy(QStringLiteral("cali/caliDistStates"), OP_LATEST);
+	m_channel->setPolicy(QStringLiteral("cali/snapEnabled"), OP_LATEST);
+	m_subscriber->setChannel(m_channel);
+	connect(m_channel, &PublishChannel::heartbeat, this, &HeadlessRunner::onHeartbeat);
+
+	auto pullTimeoutMs = m_options.stepTimeoutMs > 0 ? m_options.stepTimeoutMs : PULL_TIMEOUT_MS;
+	auto rc = m_client.connect(m_context, m_options.endpoint.requestAddr(), false, pullTimeoutMs, m_options.tuning.tuning(SC_REQUEST));
+	assert(rc);
+
+	m_sequencer = new CalibrationSequencer(m_context, m_options.endpoint.requestAddr(), m_options.tuning.tuning(SC_REQUEST), this);
+	m_sequencer->setDeviceName(m_options.endpoint.name);
+	for (int i = 0; i < SS_COUNT; i++){
+		auto policy = m_sequencer->policy(SequenceStep(i));
+		if (i == SS_CAPTURE){
+			policy.timeoutMs = m_options.caliTimeoutMs;
+		}
+		else{
+			if (m_options.stepTimeoutMs > 0)
+				policy.timeoutMs = m_options.stepTimeoutMs;
+			if (m_options.retries >= 0)
+				policy.retries = m_options.retries;
+		}
+		m_sequencer->setPolicy(SequenceStep(i), policy);
+	}
+	connect(m_channel, &PublishChannel::publishReceived, m_sequencer, &CalibrationSequencer::onPublishReceived);
+	connect(m_sequencer, &CalibrationSequencer::stepFinished, this, [this](int step, qint64, bool ok){
+		if (step == SS_DEVICE_CHECK && ok)
+			StartupTimeline::mark("device ready");
+		if (step == SS_ENTER && ok && m_sessionLog.isOpen())
+			m_session = m_sessionLog.beginSession(m_options.endpoint.name, m_options.subType);
+		if (step == SS_TYPE_SET && ok && m_session)
+			m_sessionLog.append(m_session, SK_CALI_TYPE, m_options.caliType.toUtf8());
+	});
+	if (!m_options.sessionLog.isEmpty() && m_sessionLog.open(m_options.sessionLog))
+		connect(m_channel, &PublishChannel::publishReceived, this, &HeadlessRunner::recordPublish);
+	connect(m_sequencer, &CalibrationSequencer::finished, this, &HeadlessRunner::onSequenceFinished);
+
+	m_connectTimer.setSingleShot(true);
+	m_connectTimer.setInterval(m_options.connectTimeoutMs);
+	connect(&m_connectTimer, &QTimer::timeout, this, [this]{
+		qCritical() << "no heartbeat from" << m_options.endpoint.publishAddr() << "after" << m_options.connectTimeoutMs << "ms";
+		finish(HE_NO_DEVICE);
+	});
+	m_heartbeatWatchdog.setSingleShot(true);
+	m_heartbeatWatchdog.setInterval(HEARTBEAT_TIMEOUT_MS);
+	connect(&m_heartbeatWatchdog, &QTimer::timeout, this, [this]{
+		qCritical() << "The platform died!";
+		if (m_sequencer->isRunning())
+			m_sequencer->abort();
+		else
+			finish(HE_PLATFORM_DIED);
+	});
+}
+
+HeadlessRunner::~HeadlessRunner()
+{
+	shutdown();
+}
+
+void HeadlessRunner::start()
+{
+	m_subscriberThread.start();
+	QMetaObject::invokeMethod(m_subscriber, "setup", Qt::QueuedConnection,
+		Q_ARG(QString, m_options.endpoint.publishAddr()));
+	m_connectTimer.start();
+	StartupTimeline::mark("runner started");
+}
+
+void HeadlessRunner::shutdown()
+{
+	if (!m_context)
+		return;
+	//blocked zmq_recv in the subscriber thread returns ETERM
+	zmq_ctx_shutdown(m_context);
+	m_channel->close();
+	m_subscriberThread.quit();
+	m_subscriberThread.wait();
+	//its socket must be closed before the context terminates
+	delete m_sequencer;
+	m_sequencer = nullptr;
+	m_client.close();
+	zmq_ctx_term(m_context);
+	m_context = nullptr;
+}
+
+void HeadlessRunner::finish(int code)
+{
+	if (m_finished)
+		return;
+	m_finished = true;
+	m_connectTimer.stop();
+	m_heartbeatWatchdog.stop();
+	qInfo() << "finished with code" << code << "after" << StartupTimeline::elapsedMs() << "ms";
+	emit finished(code);
+}
+
+void HeadlessRunner::onHeartbeat()
+{
+	if (m_finished)
+		return;
+	m_heartbeatWatchdog.start();
+	if (m_connected)
+		return;
+	m_connected = true;
+	m_connectTimer.stop();
+	StartupTimeline::mark("connected");
+	//the pull blocks up to its timeout,run it after the heartbeat has been handled
+	QTimer::singleShot(0, this, &HeadlessRunner::runProtocol);
+}
+
+void HeadlessRunner::runProtocol()
+{
+	QJsonDocument pullResult;
+	if (!m_client.pull(&pullResult)){
+		if (m_client.timedOut()){
+			qCritical() << "no answer to pull from" << m_options.endpoint.requestAddr();
+			finish(HE_NO_DEVICE);
+		}
+		else
+			finish(HE_REJECTED);
+		return;
+	}
+	qDebug() << "pull results:" << pullResult;
+	m_sequencer->start(m_options.subType, m_options.caliType);
+}
+
+void HeadlessRunner::recordPublish(const QString& majorCmd, const QString& minorCmd, const QByteArray& data)
+{
+	if (!m_session)
+		return;
+	if (majorCmd == QStringLiteral("finishAsyncAction"))
+		m_sessionLog.append(m_session, SK_ASYNC_RESULT, data);
+	else if (majorCmd != QStringLiteral("cali"))
+		return;
+	else if (minorCmd == QStringLiteral("time"))
+		m_sessionLog.append(m_session, SK_TIME, data);
+	else if (minorCmd == QStringLiteral("currentCaliGroup"))
+		m_sessionLog.append(m_session, SK_GROUP, data);
+	else if (minorCmd == QStringLiteral("currentCaliDist"))
+		m_sessionLog.append(m_session, SK_DIST, data);
+	else if (minorCmd == QStringLiteral("caliDistStates"))
+		m_sessionLog.append(m_session, SK_DIST_STATES, data);
+}
+
+void HeadlessRunner::onSequenceFinished(int result, int failedStep)
+{
+	if (m_session){
+		m_sessionLog.endSession(m_session, result == SR_SUCCESS ? SO_COMPLETED : result == SR_ABORTED ? SO_ABORTED : SO_FAILED);
+		m_session = 0;
+	}
+	switch (result){
+	case SR_SUCCESS:
+		finish(HE_SUCCESS);
+		break;
+	case SR_TIMEOUT:
+		qCritical() << "step" << CalibrationSequencer::stepName(SequenceStep(failedStep)) << "timed out";
+		finish(HE_TIMEOUT);
+		break;
+	case SR_ABORTED:
+		//abort() is only called when the heartbeat was lost
+		finish(HE_PLATFORM_DIED);
+		break;
+	default:
+		qCritical() << "step" << CalibrationSequencer::stepName(SequenceStep(failedStep)) << "failed";
+		finish(HE_REJECTED);
+		break;
+	}
+}
@@ -0,0 +1,82 @@
+#ifndef HEADLESS_RUNNER_H
+#define HEADLESS_RUNNER_H
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include "deviceendpoint.h"
+#include "sockettuning.h"
+#include "calibrationclient.h"
+#include "calibrationsequencer.h"
+#include "publishchannel.h"
+#include "subscriber.h"
+#include "sessionlog.h"
+/*
+Exit codes of Calibration-Headless,read by the line controller
+*/
+enum HeadlessExitCode
+{
+	HE_SUCCESS = 0,
+	HE_USAGE = 1,//bad command line or socket config
+	HE_NO_DEVICE = 2,//no heartbeat or no answer to pull from the SDK before the timeout
+	HE_REJECTED = 3,//a request failed or the SDK answered false
+	HE_TIMEOUT = 4,//calibration did not finish in time
+	HE_PLATFORM_DIED = 5//heartbeat lost during calibration
+};
+
+/*
+Runs one calibration without widgets:
+pull,then CalibrationSequencer drives device check -> sub type -> enter -> type set -> capture -> exit.
+A DE_CLICK of the scanner button triggers the snap like the GUI does.
+*/
+class HeadlessRunner : public QObject
+{
+	Q_OBJECT
+public:
+	struct Options
+	{
+		DeviceEndpoint endpoint;
+		SocketTuningConfig tuning;
+		QString subType = QStringLiteral("DST_PRO");
+		QString caliType = QStringLiteral("CT_STEREO");
+		int connectTimeoutMs = 10000;
+		int caliTimeoutMs = 600000;
+		int stepTimeoutMs = -1;//-1 keeps the sequencer's per step defaults
+		int retries = -1;
+		QString recordFile;
+		QString sessionLog;//appended,enter to exit is one session
+	};
+	explicit HeadlessRunner(const Options& options, QObject *parent = nullptr);
+	~HeadlessRunner();
+
+	void start();
+signals:
+	/*
+	code:HeadlessExitCode
+	*/
+	void finished(int code);
+private slots:
+	void onHeartbeat();
+	void onSequenceFinished(int result, int failedStep);
+private:
+	void runProtocol();
+	void finish(int code);
+	void shutdown();
+	void recordPublish(const QString& majorCmd, const QString& minorCmd, const QByteArray& data);
+
+	Options m_options;
+	void* m_context = nullptr;
+	CalibrationClient m_client;
+	CalibrationSequencer* m_sequencer = nullptr;
+	PublishChannel* m_channel = nullptr;
+	Subscriber* m_subscriber = nullptr;
+	QThread m_subscriberThread;
+	QTimer m_connectTimer;
+	QTimer m_heartbeatWatchdog;
+	bool m_connected = false;
+	bool m_finished = false;
+	SessionLogWriter m_sessionLog;
+	quint32 m_session = 0;
+};
+
+#endif // HEADLESS_RUNNER_H
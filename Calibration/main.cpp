@@ -1,10 +1,132 @@
 #include "mainwindow.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QtDebug>
+#include <QScopedPointer>
+#include "metrics.h"
+#include "startuptimeline.h"
+#include <QTimer>
 
 int main(int argc, char *argv[])
 {
+	StartupTimeline::start();
     QApplication a(argc, argv);
-    MainWindow w;
+
+	QCommandLineParser parser;
+	parser.addHelpOption();
+	QCommandLineOption recordOption("record", "Record the SDK publish stream to <file> for Calibration-Replay", "file");
+	QCommandLineOption deviceOption("device", "Scanner SDK endpoint [name@]host[:pubPort:reqPort:dataPort[:dataHost]], repeat for several scanners", "spec");
+	QCommandLineOption socketConfigOption("socket-config", "Per channel ZMQ socket options (ini file)", "file");
+	parser.addOption(recordOption);
+	parser.addOption(deviceOption);
+	QCommandLineOption metricsOption("metrics-file", "Rewrite Prometheus metrics into <file> every 5 seconds", "file");
+	parser.addOption(socketConfigOption);
+	parser.addOption(metricsOption);
+	QCommandLineOption frameRingOption("frame-ring", "Read video frames from the POSIX shm rings <name>.cam0/.cam1 (Linux)", "name");
+	parser.addOption(frameRingOption);
+	QCommandLineOption sessionLogOption("session-log", "Append calibration sessions to <file>, query it with Calibration-Sessions", "file");
+	parser.addOption(sessionLogOption);
+	QCommandLineOption sharpnessRoiOption("sharpness-roi", "Region scored for focus as fractions of the frame x,y,width,height", "roi", "0.25,0.25,0.5,0.5");
+	parser.addOption(sharpnessRoiOption);
+	QCommandLineOption boardOption("board", "Circle grid searched in the camera frames, scanner clicks snap only once both cameras see it", "colsxrows[:dark]");
+	parser.addOption(boardOption);
+	QCommandLineOption markersOption("markers", "Extract marker centroids from gray camera frames, at most <ms> per frame", "ms");
+	parser.addOption(markersOption);
+	QCommandLineOption changeToleranceOption("change-tolerance", "Skip camera frames whose sampled blocks differ by at most <level> on average, off converts every frame", "level", "3");
+	parser.addOption(changeToleranceOption);
+	parser.process(a);
+
+	SocketTuningConfig tuning;
+	if (parser.isSet(socketConfigOption) && !tuning.load(parser.value(socketConfigOption)))
+		return 1;
+
+	SharpnessRoi sharpnessRoi;
+	{
+		auto fields = parser.value(sharpnessRoiOption).split(',');
+		bool ok = fields.size() == 4;
+		double values[4] = {};
+		for (int i = 0; ok && i < 4; i++)
+			values[i] = fields[i].toDouble(&ok);
+		if (!ok || values[0] < 0 || values[1] < 0 || values[2] <= 0 || values[3] <= 0
+			|| values[0] + values[2] > 1 || values[1] + values[3] > 1){
+			qCritical() << "invalid --sharpness-roi:" << parser.value(sharpnessRoiOption);
+			return 1;
+		}
+		sharpnessRoi.x = values[0];
+		sharpnessRoi.y = values[1];
+		sharpnessRoi.width = values[2];
+		sharpnessRoi.height = values[3];
+	}
+
+	BoardSpec board;
+	if (parser.isSet(boardOption)){
+		auto value = parser.value(boardOption);
+		if (value.endsWith(":dark")){
+			board.darkCircles = true;
+			value.chop(5);
+		}
+		auto fields = value.split('x');
+		bool colsOk = false, rowsOk = false;
+		if (fields.size() == 2){
+			board.cols = fields[0].toInt(&colsOk);
+			board.rows = fields[1].toInt(&rowsOk);
+		}
+		if (!colsOk || !rowsOk || !board.isValid()){
+			qCritical() << "invalid --board:" << parser.value(boardOption);
+			return 1;
+		}
+	}
+
+	MarkerParams markers;
+	if (parser.isSet(markersOption)){
+		bool ok = false;
+		const int budgetMs = parser.value(markersOption).toInt(&ok);
+		if (!ok || budgetMs <= 0){
+			qCritical() << "invalid --markers:" << parser.value(markersOption);
+			return 1;
+		}
+		markers.budgetUs = budgetMs * 1000;
+	}
+
+	int changeTolerance = -1;
+	if (parser.value(changeToleranceOption) != QStringLiteral("off")){
+		bool ok = false;
+		changeTolerance = parser.value(changeToleranceOption).toInt(&ok);
+		if (!ok || changeTolerance < 0){
+			qCritical() << "invalid --change-tolerance:" << parser.value(changeToleranceOption);
+			return 1;
+		}
+	}
+
+	QList<DeviceEndpoint> devices;
+	for (const auto& spec : parser.values(deviceOption)){
+		DeviceEndpoint endpoint;
+		if (!DeviceEndpoint::parse(spec, endpoint)){
+			qCritical() << "invalid device endpoint:" << spec;
+			return 1;
+		}
+		devices << endpoint;
+	}
+	if (!DeviceEndpoint::assignDataPorts(devices))
+		return 1;
+
+    MainWindow w(devices, tuning);
+	StartupTimeline::mark("window created");
+	QScopedPointer<MetricsExporter> metricsExporter;
+	if (parser.isSet(metricsOption))
+		metricsExporter.reset(new MetricsExporter(parser.value(metricsOption), 5000));
+	if (parser.isSet(recordOption))
+		w.setRecordFile(parser.value(recordOption));
+	if (parser.isSet(frameRingOption))
+		w.setFrameRing(parser.value(frameRingOption));
+	w.setSharpnessRoi(sharpnessRoi);
+	if (board.isValid())
+		w.setBoard(board);
+	if (parser.isSet(markersOption))
+		w.setMarkers(markers);
+	w.setChangeTolerance(changeTolerance);
+	if (parser.isSet(sessionLogOption))
+		w.setSessionLog(parser.value(sessionLogOption));
 
 	//int x = -1;
 	//char bufx[100] = { 0 };
@@ -15,6 +137,8 @@ int main(int argc, char *argv[])
 	//memcpy(&y, mm.constData(), mm.size());
 
     w.show();
+	//runs once the event loop is up and the first paint is queued
+	QTimer::singleShot(0, []{ StartupTimeline::mark("window shown"); });
 
     return a.exec();
 }
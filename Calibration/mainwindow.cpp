@@ -7,13 +7,44 @@
 #include <QJsonObject>
 #include <QDateTime>
 #include <QSharedMemory>
+#include <QComboBox>
+#include <QFileInfo>
+#include <QDir>
+#include "tracing.h"
+#include "sdkmessage.h"
+#include "startuptimeline.h"
+#include <QPointer>
+#include <QDockWidget>
+#include <QHBoxLayout>
+#include <QStringList>
+#ifdef CALIBRATION_TRACING
+#include <QShortcut>
+#endif
+
+namespace
+{
+	const int PULL_TIMEOUT_MS = 10000;
+	//a request the SDK has not answered by then fails instead of freezing the window
+	const int REQUEST_TIMEOUT_MS = 10000;
+	//a board result older than this no longer describes the frame the scanner would snap
+	const int BOARD_FRESH_MS = 500;
+}
 
-MainWindow::MainWindow(QWidget *parent) :
+MainWindow::MainWindow(const QList<DeviceEndpoint>& devices, const SocketTuningConfig& tuning, QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow)
 {
     ui->setupUi(this);
     m_progressDialog = new ProgressDialog(this);
+	TRACE_THREAD_NAME("GUI");
+#ifdef CALIBRATION_TRACING
+	auto traceShortcut = new QShortcut(QKeySequence(tr("Ctrl+Shift+T")), this);
+	connect(traceShortcut, &QShortcut::activated, this, [this]{
+		auto path = QString("calibration-trace-%1.json").arg(QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss"));
+		if (Tracing::dump(path))
+			ui->statusBar->showMessage("trace written to " + path, 5000);
+	});
+#endif
 
 	lineEdit_Group.resize(5);
 	lineEdit_Group[0] = ui->lineEdit_Group1;
@@ -28,35 +59,92 @@ MainWindow::MainWindow(QWidget *parent) :
 	widget_Step[2] = ui->widget_Step3;
 	widget_Step[3] = ui->widget_Step4;
 
+	//indicator colors,same as the style sheets they replace
+	m_statusModel = new StatusViewModel(this);
+	const QColor initial(158, 158, 156), gray("gray"), green("green"), white("white");
+	m_dist5Group = m_statusModel->addGroup({ ui->label_Cali1, ui->label_Cali2, ui->label_Cali3, ui->label_Cali4, ui->label_Cali5 },
+		QPalette::Window, { initial, gray, green, gray, gray });
+	m_dist7Group = m_statusModel->addGroup({ ui->label_7Cali1, ui->label_7Cali2, ui->label_7Cali3, ui->label_7Cali4,
+		ui->label_7Cali5, ui->label_7Cali6, ui->label_7Cali7 }, QPalette::Window, { initial, gray, green, gray, gray });
+	m_calibrationGroup = m_statusModel->addGroup(lineEdit_Group, QPalette::Base, { white, white, white, white, gray });
+
+	//camera views,the .ui has no video area
+	auto videoDock = new QDockWidget(tr("Cameras"), this);
+	auto videoArea = new QWidget(videoDock);
+	auto videoLayout = new QHBoxLayout(videoArea);
+	for (int i = 0; i < 2; i++){
+		m_videoWidgets[i] = new VideoWidget(QString("cam%1").arg(i), videoArea);
+		videoLayout->addWidget(m_videoWidgets[i]);
+	}
+	videoDock->setWidget(videoArea);
+	addDockWidget(Qt::BottomDockWidgetArea, videoDock);
+
 	ui->widget_Calibration5->hide();
 	ui->widget_Calibration7->hide();
 	ui->pushButton_GetInformation->setEnabled(false);
 
-	m_zmqContext = zmq_ctx_new();
-	auto err = zmq_strerror(zmq_errno());
-
-    m_subscriberThread = new QThread(this);
-    m_subscriber = new Subscriber(this, m_zmqContext);
-    m_subscriber->moveToThread(m_subscriberThread);
-    connect(m_subscriberThread, &QThread::finished, m_subscriber, &QObject::deleteLater);
-    connect(m_subscriber, &Subscriber::heartbeat, this, &MainWindow::onHeartbeat, Qt::QueuedConnection);
-	connect(m_subscriber, &Subscriber::publishReceived, this, &MainWindow::onPublishReceived, Qt::QueuedConnection);
-    m_subscriberThread->start();
-	
-
-	m_dataProcesserThread = new QThread(this);
-	m_dataProcesser = new DataProcesser(this, m_zmqContext);
-	m_dataProcesser->moveToThread(m_dataProcesserThread);
-	connect(m_dataProcesserThread, &QThread::finished, m_dataProcesser, &QObject::deleteLater);
-	connect(m_dataProcesser, &DataProcesser::videoImageReady, this, &MainWindow::onVideoImageReady, Qt::QueuedConnection);
-	m_dataProcesserThread->start();
-
-	QMetaObject::invokeMethod(m_subscriber, "setup", Qt::QueuedConnection, Q_ARG(QString, "tcp://localhost:11398"));
-
-	m_zmqReqSocket = zmq_socket(m_zmqContext, ZMQ_REQ);
-    auto rc = zmq_connect(m_zmqReqSocket, "tcp://localhost:11399");
-	assert(!rc);
-
+	auto endpoints = devices;
+	if (endpoints.isEmpty()){
+		DeviceEndpoint endpoint;
+		endpoint.name = QStringLiteral("default");
+		endpoints << endpoint;
+	}
+	m_deviceManager = new DeviceManager(endpoints, tuning, this);
+	m_zmqContext = m_deviceManager->context();
+	connect(m_deviceManager, &DeviceManager::heartbeat, this, [this](int device){
+		StartupTimeline::mark("connected");
+		if (device == m_currentDevice)
+			onHeartbeat();
+	});
+	connect(m_deviceManager, &DeviceManager::publishReceived, this, [this](int device, QString majorCmd, QString minorCmd, QByteArray data){
+		if (device == m_currentDevice)
+			onPublishReceived(majorCmd, minorCmd, data);
+	});
+	connect(m_deviceManager, &DeviceManager::videoImageReady, this, [this](int device, int camID, VideoFrame frame){
+		StartupTimeline::mark("first frame");
+		if (device == m_currentDevice)
+			onVideoImageReady(camID, frame);
+	});
+	connect(m_deviceManager, &DeviceManager::exposureUpdated, this, [this](int device, int camID, ExposureStats stats){
+		if (device == m_currentDevice && camID >= 0 && camID < 2)
+			m_videoWidgets[camID]->setExposure(stats);
+	});
+	connect(m_deviceManager, &DeviceManager::sharpnessUpdated, this, [this](int device, int camID, double score){
+		if (device != m_currentDevice || camID < 0 || camID >= 2)
+			return;
+		m_sharpness[camID] = score;
+		m_sharpnessPeak[camID] = qMax(m_sharpnessPeak[camID], score);
+		showSharpness();
+	});
+	connect(m_deviceManager, &DeviceManager::boardDetected, this, [this](int device, int camID, BoardDetection detection){
+		if (device != m_currentDevice || camID < 0 || camID >= 2)
+			return;
+		m_boardFound[camID] = detection.found;
+		m_boardSeen[camID].start();
+		m_videoWidgets[camID]->setBoard(detection);
+	});
+	connect(m_deviceManager, &DeviceManager::markersUpdated, this, [this](int device, int camID, MarkerResult result){
+		if (device == m_currentDevice && camID >= 0 && camID < 2)
+			m_videoWidgets[camID]->setMarkers(result);
+	});
+	m_snapsGatedMetric = MetricsRegistry::instance().counter("calib_snaps_gated_total", "Scanner clicks not snapped because the board was not found in both cameras");
+	connect(m_deviceManager, &DeviceManager::dataProcesserRegistered, this, [this](int device, bool ok){
+		if (!ok)
+			qWarning() << "data processer of" << m_deviceManager->endpoint(device).name << "could not register";
+		StartupTimeline::mark("data processer registered");
+	});
+	connect(m_deviceManager, &DeviceManager::statusChanged, this, [this]{
+		ui->statusBar->showMessage(m_deviceManager->statusSummary());
+	});
+	if (m_deviceManager->deviceCount() > 1){
+		auto deviceBox = new QComboBox(this);
+		for (int i = 0; i < m_deviceManager->deviceCount(); i++)
+			deviceBox->addItem(m_deviceManager->endpoint(i).name);
+		connect(deviceBox, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &MainWindow::selectDevice);
+		ui->statusBar->addPermanentWidget(deviceBox);
+	}
+	selectDevice(0);
+	ui->statusBar->showMessage(m_deviceManager->statusSummary());
 
 	m_heartbeatTimer = new QTimer(this);
 	m_heartbeatTimer->setInterval(210 );
@@ -73,21 +161,8 @@ MainWindow::MainWindow(QWidget *parent) :
 	});
 	m_heartbeatTimer->start();
 
-	QTimer::singleShot(0, this, [&]{
-		m_progressDialog->onBeginAsync("Pulling...");
-		QCoreApplication::processEvents();
-		const char *sendData = "v1.0/pull";
-		int nbytes = zmq_send(m_zmqReqSocket, sendData, strlen(sendData), 0);
-
-
-		char buf[MAX_DATA_LENGTH * 2+ 1] = { 0 };
-		nbytes = zmq_recv(m_zmqReqSocket, buf, MAX_DATA_LENGTH * 2, 0);
-		auto jsonDoc = QJsonDocument::fromJson(buf);
-		qDebug() << "pull results:" << jsonDoc;
-		assert(!hasMore(m_zmqReqSocket));
-		m_progressDialog->onFinishAsync();
-		QCoreApplication::processEvents();
-	});
+	//the window shows first,threads,registration and the initial pull follow without blocking it
+	QTimer::singleShot(0, this, &MainWindow::startDevices);
 	//init
 	ui->widget->setEnabled(false);
 	ui->comboBox_CaliType->setCurrentIndex(0);
@@ -96,18 +171,76 @@ MainWindow::MainWindow(QWidget *parent) :
 MainWindow::~MainWindow()
 {
     delete ui;
-	zmq_close(m_zmqReqSocket);
-	zmq_ctx_destroy(m_zmqContext);
+	m_client.close();
+	m_deviceManager->shutdown();
+}
+
+void MainWindow::startDevices()
+{
+	m_deviceManager->start();
+	StartupTimeline::mark("devices started");
+
+	auto pull = m_deviceManager->createRequester(m_currentDevice, this);
+	connect(pull, &AsyncRequester::replied, this, [this, pull](QByteArray reply){
+		qDebug() << "pull results:" << QJsonDocument::fromJson(reply);
+		StartupTimeline::mark("pulled");
+		pull->close();
+		pull->deleteLater();
+	});
+	//with ZMQ_IMMEDIATE the request cannot be sent before the connection is up
+	auto retry = new QTimer(pull);
+	retry->setInterval(200);
+	connect(retry, &QTimer::timeout, pull, [pull, retry]{
+		if (pull->send(QStringLiteral("pull")) == 0)
+			retry->stop();
+	});
+	if (pull->send(QStringLiteral("pull")) != 0)
+		retry->start();
+	QPointer<AsyncRequester> guard(pull);
+	QTimer::singleShot(PULL_TIMEOUT_MS, this, [guard]{
+		if (guard){
+			qWarning() << "initial pull timed out";
+			guard->close();
+			guard->deleteLater();
+		}
+	});
+}
+
+void MainWindow::selectDevice(int device)
+{
+	//a session belongs to one scanner
+	if (device != m_currentDevice)
+		endSession(SO_ABORTED);
+	m_currentDevice = device;
+	//a DEALER of the window's own,so a batch really has all its requests in flight at once
+	m_client.connect(m_zmqContext, m_deviceManager->endpoint(device).requestAddr(), true, REQUEST_TIMEOUT_MS,
+		m_deviceManager->requestTuning());
+	m_subscriber = m_deviceManager->subscriber(device);
+	m_dataProcesser = m_deviceManager->dataProcesser(device);
+	for (auto videoWidget : m_videoWidgets){
+		if (videoWidget)
+			videoWidget->clear();
+	}
+	for (int i = 0; i < 2; i++){
+		m_sharpness[i] = m_sharpnessPeak[i] = 0;
+		m_boardFound[i] = false;
+		m_boardSeen[i].invalidate();
+	}
+	if (m_heartbeatTimer){
+		//restart the countdown for the newly selected scanner
+		ui->lcdNumber->display(10);
+		m_heartbeatTimer->start();
+	}
 }
 
 bool MainWindow::request(const QString& cmd, const QJsonObject& jsonObj)
 {
-	return sendData(m_zmqReqSocket, cmd, jsonStr(jsonObj));
+	return sendData(m_client.socket(), cmd, jsonStr(jsonObj));
 }
 
 bool MainWindow::request(const QString& cmd)
 {
-	return sendData(m_zmqReqSocket, cmd, "");
+	return sendData(m_client.socket(), cmd, "");
 }
 
 bool MainWindow::hasMore(void* socket)
@@ -120,138 +253,203 @@ bool MainWindow::hasMore(void* socket)
 	return more != 0;
 }
 
+void MainWindow::setRecordFile(const QString& path)
+{
+	for (int i = 0; i < m_deviceManager->deviceCount(); i++){
+		auto file = path;
+		if (m_deviceManager->deviceCount() > 1){
+			QFileInfo info(path);
+			file = info.dir().filePath(QString("%1.%2.%3").arg(info.completeBaseName(), m_deviceManager->endpoint(i).name, info.suffix()));
+		}
+		m_deviceManager->subscriber(i)->setRecordFile(file);
+	}
+}
 
-void MainWindow::on_pushButton_DeviceCheck_clicked()
+void MainWindow::setFrameRing(const QString& baseName)
 {
-	const char *sendData = "v1.0/device/check";
-	int nbytes = zmq_send(m_zmqReqSocket, sendData, strlen(sendData), 0);
-	m_progressDialog->setWindowTitle("Check Device");
+	for (int i = 0; i < m_deviceManager->deviceCount(); i++){
+		auto name = baseName;
+		if (m_deviceManager->deviceCount() > 1)
+			name += '.' + m_deviceManager->endpoint(i).name;
+		m_deviceManager->dataProcesser(i)->setFrameRing(name);
+	}
+}
 
-	int result = 0;
-	nbytes = zmq_recv(m_zmqReqSocket, &result, sizeof(int), 0);
-	qDebug() << "recv reply data:" << (result == 0 ? false : true);
-	if (result != 0)
-	{
-		ui->widget->setEnabled(true);
+void MainWindow::setSharpnessRoi(const SharpnessRoi& roi)
+{
+	for (int i = 0; i < m_deviceManager->deviceCount(); i++)
+		m_deviceManager->dataProcesser(i)->setSharpnessRoi(roi);
+}
+
+void MainWindow::setBoard(const BoardSpec& spec)
+{
+	for (int i = 0; i < m_deviceManager->deviceCount(); i++)
+		m_deviceManager->dataProcesser(i)->setBoard(spec);
+	m_boardGate = spec.isValid();
+}
+
+void MainWindow::setMarkers(const MarkerParams& params)
+{
+	for (int i = 0; i < m_deviceManager->deviceCount(); i++)
+		m_deviceManager->dataProcesser(i)->setMarkers(params);
+}
+
+void MainWindow::setChangeTolerance(int tolerance)
+{
+	for (int i = 0; i < m_deviceManager->deviceCount(); i++)
+		m_deviceManager->dataProcesser(i)->setChangeTolerance(tolerance);
+}
+
+bool MainWindow::boardVisible() const
+{
+	for (int i = 0; i < 2; i++){
+		if (!m_boardFound[i] || !m_boardSeen[i].isValid() || m_boardSeen[i].elapsed() > BOARD_FRESH_MS)
+			return false;
 	}
-	assert(!hasMore(m_zmqReqSocket));
+	return true;
 }
 
-void MainWindow::on_pushButton_pro_clicked()
+void MainWindow::showSharpness()
 {
-	const char *sendData = "v1.0/device/devSubType/set";
-	int nbytes = zmq_send(m_zmqReqSocket, sendData, strlen(sendData), ZMQ_SNDMORE);
+	//the share of the best score at this distance tells the operator which way to move the board
+	QStringList cameras;
+	for (int i = 0; i < 2; i++){
+		if (m_sharpnessPeak[i] <= 0)
+			continue;
+		cameras << QString("cam%1 %2 (%3%)").arg(i).arg(m_sharpness[i], 0, 'f', 0).arg(qRound(m_sharpness[i] * 100 / m_sharpnessPeak[i]));
+	}
+	ui->label_Sharpness->setText(cameras.join("  "));
+}
 
-	QByteArray proType("DST_PRO");
-	nbytes = zmq_send(m_zmqReqSocket, proType, proType.size(), 0);
+void MainWindow::setSessionLog(const QString& path)
+{
+	endSession(SO_ABORTED);
+	m_sessionLog.close();
+	if (!path.isEmpty())
+		m_sessionLog.open(path);
+}
 
-	int result = 0;
-	nbytes = zmq_recv(m_zmqReqSocket, &result, sizeof(int), 0);
-	qDebug() << "recv reply data:" << (result == 0 ? false : true);
-	assert(!hasMore(m_zmqReqSocket));
+void MainWindow::recordSession(SessionRecordKind kind, const QByteArray& data)
+{
+	if (m_session)
+		m_sessionLog.append(m_session, kind, data);
 }
 
-void MainWindow::on_pushButton_pro_plus_clicked()
+void MainWindow::endSession(SessionOutcome outcome)
 {
-	const char *sendData = "v1.0/device/devSubType/set";
-	int nbytes = zmq_send(m_zmqReqSocket, sendData, strlen(sendData), ZMQ_SNDMORE);
+	if (!m_session)
+		return;
+	m_sessionLog.endSession(m_session, outcome);
+	m_session = 0;
+}
 
-	QByteArray proType("DST_PRO_PLUS");
-	nbytes = zmq_send(m_zmqReqSocket, proType, proType.size(), 0);
 
-	int result = 0;
-	nbytes = zmq_recv(m_zmqReqSocket, &result, sizeof(int), 0);
-	qDebug() << "recv reply data:" << (result == 0 ? false : true);
-	assert(!hasMore(m_zmqReqSocket));
+void MainWindow::on_pushButton_DeviceCheck_clicked()
+{
+	m_progressDialog->setWindowTitle("Check Device");
+	bool result = false;
+	if (!m_client.deviceCheck(&result))
+		return;
+	qDebug() << "recv reply data:" << result;
+	if (result)
+	{
+		ui->widget->setEnabled(true);
+	}
 }
 
-void MainWindow::CaliGetTime()
+void MainWindow::on_pushButton_pro_clicked()
 {
-	const char *sendData = "v1.0/cali/time";
-	int nbytes = zmq_send(m_zmqReqSocket, sendData, strlen(sendData), 0);
+	bool result = false;
+	if (m_client.setDevSubType(QStringLiteral("DST_PRO"), &result))
+		qDebug() << "recv reply data:" << result;
+	if (result)
+		m_subType = QStringLiteral("DST_PRO");
+}
 
-	//qlonglong result = 0;
-	char buf[MAX_DATA_LENGTH + 1] = { 0 };
-	nbytes = zmq_recv(m_zmqReqSocket, buf, MAX_DATA_LENGTH, 0);
+void MainWindow::on_pushButton_pro_plus_clicked()
+{
+	bool result = false;
+	if (m_client.setDevSubType(QStringLiteral("DST_PRO_PLUS"), &result))
+		qDebug() << "recv reply data:" << result;
+	if (result)
+		m_subType = QStringLiteral("DST_PRO_PLUS");
+}
 
-	QString strDate(buf);
-	//auto dt = QDateTime::fromSecsSinceEpoch(result);
-	ui->label_CaliTime->setText(strDate);
-	assert(!hasMore(m_zmqReqSocket));
+void MainWindow::CaliGetTime()
+{
+	TRACE_SCOPE("CaliGetTime");
+	QString strDate;
+	if (m_client.caliTime(&strDate))
+		ui->label_CaliTime->setText(strDate);
 }
 //
 void MainWindow::CaliCurrentGroup()
 {
-	const char *sendData = "v1.0/cali/currentCaliGroup";
-	int nbytes = zmq_send(m_zmqReqSocket, sendData, strlen(sendData), 0);
-	char buf[MAX_DATA_LENGTH + 1] = { 0 };
-	nbytes = zmq_recv(m_zmqReqSocket, buf, MAX_DATA_LENGTH, 0);
-	int num;
-	memcpy(&num, buf, sizeof(int));
+	TRACE_SCOPE("CaliCurrentGroup");
+	int num = 0;
+	if (!m_client.caliCurrentGroup(&num))
+		return;
 	qDebug() << "cali currentCaliGroup:" << num;
-	//lineEdit_Group[num-1]->setStyleSheet("background-color:gray");
 	ui->label_CaliGroup->setText(QString::number(num));
-	assert(!hasMore(m_zmqReqSocket));
 }
 
 void MainWindow::CaliCurrentDist()
 {
-	const char *sendData = "v1.0/cali/currentCaliDist";
-	int nbytes = zmq_send(m_zmqReqSocket, sendData, strlen(sendData), 0);
-	char buf[MAX_DATA_LENGTH + 1] = { 0 };
-	nbytes = zmq_recv(m_zmqReqSocket, buf, MAX_DATA_LENGTH, 0);
-	int num;
-	memcpy(&num, buf, sizeof(int));
+	TRACE_SCOPE("CaliCurrentDist");
+	int num = 0;
+	if (!m_client.caliCurrentDist(&num))
+		return;
 	qDebug() << "cali currentCaliDist:" << num;
 	ui->label_CaliDistance->setText(QString::number(num));
-	assert(!hasMore(m_zmqReqSocket));
 }
 
 void MainWindow::on_pushButton_GetInformation_clicked()
 {
-	 CaliGetTime();
-	 CaliCurrentGroup();
-	 CaliCurrentDist();
+	//one batch,one round trip on the pipelined request socket
+	std::string time;
+	int group = 0, dist = 0;
+	CalibBatch batch;
+	batch.caliTime(&time);
+	batch.caliCurrentGroup(&group);
+	batch.caliCurrentDist(&dist);
+	if (!m_client.run(batch))
+		return;
+	qDebug() << "cali currentCaliGroup:" << group << "currentCaliDist:" << dist;
+	ui->label_CaliTime->setText(QString::fromStdString(time));
+	ui->label_CaliGroup->setText(QString::number(group));
+	ui->label_CaliDistance->setText(QString::number(dist));
 }
 
 void MainWindow::on_pushButton_enterCali_clicked()
 {
 	m_progressDialog->setWindowTitle("Enter calibration");
-	const char *sendData = "v1.0/cali/enter";
-	int nbytes = zmq_send(m_zmqReqSocket, sendData, strlen(sendData), 0);
-	char buf[MAX_DATA_LENGTH + 1] = { 0 };
-	nbytes = zmq_recv(m_zmqReqSocket, buf, MAX_DATA_LENGTH, 0);
-	int num;
-	memcpy(&num, buf, sizeof(int));
-	auto valBool = num == 0 ? false : true;
+	bool valBool = false;
+	if (!m_client.caliEnter(&valBool))
+		return;
 	qDebug() << "cali enterCali:" << valBool;
 	ui->pushButton_GetInformation->setEnabled(true);
-
-	assert(!hasMore(m_zmqReqSocket));
+	if (valBool && m_sessionLog.isOpen()){
+		endSession(SO_ABORTED);
+		m_session = m_sessionLog.beginSession(m_deviceManager->endpoint(m_currentDevice).name, m_subType);
+		m_sessionComplete = false;
+	}
 }
 
 void MainWindow::on_pushButton_CaliExit_clicked()
 {
 	m_progressDialog->setWindowTitle("Exit calibration");
-	const char *sendData = "v1.0/cali/exit";
-	int nbytes = zmq_send(m_zmqReqSocket, sendData, strlen(sendData), 0);
-	char buf[MAX_DATA_LENGTH + 1] = { 0 };
-	nbytes = zmq_recv(m_zmqReqSocket, buf, MAX_DATA_LENGTH, 0);
-	int num;
-	memcpy(&num, buf, sizeof(int));
-	auto valBool = num == 0 ? false : true;
-	qDebug() << "cali exitCali:" << valBool;
-
-	assert(!hasMore(m_zmqReqSocket));
+	bool valBool = false;
+	if (m_client.caliExit(&valBool))
+		qDebug() << "cali exitCali:" << valBool;
+	endSession(m_sessionComplete ? SO_COMPLETED : SO_ABORTED);
 	resetCaliStatus();
 }
 
 void MainWindow::closeEvent(QCloseEvent *event)
 {
-	
-	m_subscriberThread->quit();
-	m_subscriberThread->exit(0);
-	connect(m_subscriberThread, SIGNAL(finished()), m_subscriberThread, SLOT(deleteLater()));
+	endSession(SO_ABORTED);
+	m_sessionLog.close();
+	m_deviceManager->shutdown();
 	
 	exit(0);
 	MainWindow::closeEvent(event);
@@ -259,27 +457,12 @@ void MainWindow::closeEvent(QCloseEvent *event)
 
 void MainWindow::on_pushButton_SetSnapEnabled_clicked()
 {
-	char set;
-	set = '1';
-	QString  cmd = QStringLiteral("v1.0/cali/snapEnabled/set") ;
-	qDebug() << "cmd:" << cmd.toStdString().c_str() << endl;
-	char buf[MAX_DATA_LENGTH + 1] = { "v1.0/cali/snapEnabled/set"};
-	const char *sendData = buf;
-	int nbytes = zmq_send(m_zmqReqSocket, sendData, strlen(sendData), ZMQ_SNDMORE);
-	char buf2[MAX_DATA_LENGTH + 1] = { 0 };
-	buf2[0] = set;
-	const char* sendData2 = buf2;
-	nbytes = zmq_send(m_zmqReqSocket, sendData2, strlen(sendData2), 0);
-	if (nbytes <=0) {
+	bool setResult = false;
+	if (!m_client.caliSetSnapEnabled(true, &setResult)) {
 		qWarning() << "cannot send SetSnapEnabled!";
 		return;
 	}
-
-	int result = 0;
-	nbytes = zmq_recv(m_zmqReqSocket, &result, sizeof(int), 0);
-	bool setResult = (result == 0 ? false : true);
-	qDebug() << "pushButton_SetSnapEnabled recv reply data:" << (bool)setResult;
-	assert(!hasMore(m_zmqReqSocket));	
+	qDebug() << "pushButton_SetSnapEnabled recv reply data:" << setResult;
 }
 
 //void MainWindow::on_pushButton_CaliSetType_clicked()
@@ -335,11 +518,7 @@ void MainWindow::nextStep(int num)
 	}
 	else if (ui->widget_Step4->isEnabled())
 	{
-		lineEdit_Group[0]->setStyleSheet("background-color:white");
-		lineEdit_Group[1]->setStyleSheet("background-color:white");
-		lineEdit_Group[2]->setStyleSheet("background-color:white");
-		lineEdit_Group[3]->setStyleSheet("background-color:white");
-		lineEdit_Group[4]->setStyleSheet("background-color:white");
+		m_statusModel->setAll(m_calibrationGroup, IS_NORMAL);
 	}
 }
 
@@ -387,27 +566,14 @@ void MainWindow::on_pushButton_Step2Back_clicked()
 void MainWindow::on_pushButton_Step3Next_clicked()
 {
 	QString set = ui->comboBox_CaliType->currentText();
-
-	char buf[MAX_DATA_LENGTH + 1] = { "v1.0/cali/type/set" };
-	const char *sendData = buf;
-	int nbytes = zmq_send(m_zmqReqSocket, sendData, strlen(sendData), ZMQ_SNDMORE);
-	char buf2[MAX_DATA_LENGTH + 1] = { 0 };
-	for (int i = 0; i < set.size(); i++)
-	{
-		buf2[i] = set.at(i).toLatin1();
-	}
-	const char *sendData2 = buf2;
-	nbytes = zmq_send(m_zmqReqSocket, sendData2, strlen(sendData2), 0);
-	if (nbytes <= 0) {
+	bool setResult = false;
+	if (!m_client.caliSetType(set, &setResult)) {
 		qWarning() << "cannot send CaliSetType!";
 		return;
 	}
-
-	int result = 0;
-	nbytes = zmq_recv(m_zmqReqSocket, &result, sizeof(int), 0);
-	bool setResult = (result == 0 ? false : true);
-	qDebug() << "CaliSetType recv reply data:" << (bool)setResult;
-	assert(!hasMore(m_zmqReqSocket));
+	qDebug() << "CaliSetType recv reply data:" << setResult;
+	if (setResult)
+		recordSession(SK_CALI_TYPE, set.toUtf8());
 
 	if (ui->comboBox_CaliType->currentIndex() == 0)
 	{
@@ -453,9 +619,8 @@ void MainWindow::onHeartbeat()
 
 void MainWindow::onPublishReceived(QString majorCmd, QString minorCmd, QByteArray data)
 {
-	CaliCurrentDist();
-	CaliCurrentGroup();
-	CaliGetTime();
+	TRACE_SCOPE("onPublishReceived");
+	//no requests from here,the cali/time,currentCaliGroup and currentCaliDist publishes below keep the labels current
 	if (majorCmd == QStringLiteral("beginAsyncAction")) {
 		auto jsonObj = jsonObject(data);
 		qDebug() << "beginAsyncAction json object:" << jsonObj;
@@ -478,6 +643,7 @@ void MainWindow::onPublishReceived(QString majorCmd, QString minorCmd, QByteArra
 		auto type = jsonObj["type"].toString();
 		auto props = jsonObj["props"].toObject();
 		auto result = jsonObj["result"].toString();
+		recordSession(SK_ASYNC_RESULT, data);
 		//note: finishAsyncActionźŲȥCali-type
 		if (props["type"] != QJsonValue::Undefined) {
 			
@@ -521,7 +687,14 @@ void MainWindow::onPublishReceived(QString majorCmd, QString minorCmd, QByteArra
 			}
 			else if (deviceEvent == "DE_CLICK")
 			{
-				on_pushButton_SetSnapEnabled_clicked();
+				//the snap button stays an operator override,only the scanner button is gated
+				if (m_boardGate && !boardVisible()){
+					m_snapsGatedMetric->inc();
+					ui->statusBar->showMessage("board not found in both cameras, not snapped", 3000);
+				}
+				else{
+					on_pushButton_SetSnapEnabled_clicked();
+				}
 				qDebug() << "DE_CLICK";
 			}
 			else if (deviceEvent == "DE_PLUS")
@@ -543,6 +716,7 @@ void MainWindow::onPublishReceived(QString majorCmd, QString minorCmd, QByteArra
 			// 			ui->label_CaliTime->setText(dt.toString("HH:MM:ss yyyy-MM-dd"));
 
 			ui->label_CaliTime->setText(QString(data));
+			recordSession(SK_TIME, data);
 			qDebug() << "onPublishReceived  cali//time: " << data;
 		}
 		//2019.3.21 cali-type
@@ -559,124 +733,29 @@ void MainWindow::onPublishReceived(QString majorCmd, QString minorCmd, QByteArra
 		if (minorCmd == QStringLiteral("currentCaliGroup")) {
 			int  value = 0;
 			memcpy(&value, data.constData(), data.size());
-			lineEdit_Group[value-1]->setStyleSheet("background-color:gray");
-			if (value>1)
-			{
-				lineEdit_Group[value - 2]->setStyleSheet("background-color:white");
-			}
-			else if (value == 1)
-			{
-				lineEdit_Group[4]->setStyleSheet("background-color:white");
-			}
+			//only the group being calibrated is highlighted
+			m_statusModel->setAll(m_calibrationGroup, IS_NORMAL);
+			m_statusModel->setState(m_calibrationGroup, value - 1, IS_CURRENT);
+			recordSession(SK_GROUP, data);
 			ui->label_CaliGroup->setText(QString::number(value));
 		}
 		if (minorCmd == QStringLiteral("currentCaliDist")) {
 			int  value = 0;
 			memcpy(&value, data.constData(), data.size());
 			ui->label_CaliDistance->setText(QString::number(value));
+			recordSession(SK_DIST, data);
+			//a new distance has its own best focus
+			m_sharpnessPeak[0] = m_sharpness[0];
+			m_sharpnessPeak[1] = m_sharpness[1];
 		}
 		if (minorCmd == QStringLiteral("caliDistStates")) {
-			//QMessageBox::information(NULL, "caliDistStates", data, QMessageBox::Yes);
-		
-			QJsonDocument jsondocument = QJsonDocument::fromJson(data);
-			QJsonObject jsonObject = jsondocument.object();
-			QJsonArray array = jsonObject["states"].toArray();
-			if (array.count() != 5&&array.count() != 7) 
-			{
-				qDebug() << "qjsonarray_Count:" << array.count();
-			}
-			else if (array.count() == 5 )
-			{
-				qDebug() << "qjsonarray_Count:" << array.count();
-				bool cali1 = array[0].toBool();
-				bool cali2 = array[1].toBool();
-				bool cali3 = array[2].toBool();
-				bool cali4 = array[3].toBool();
-				bool cali5 = array[4].toBool();
-				if (cali1 == true) {
-					ui->label_Cali1->setStyleSheet("background-color:green");
-				}
-				else {
-					ui->label_Cali1->setStyleSheet("background-color:gray");
-				}
-				if (cali2 == true) {
-					ui->label_Cali2->setStyleSheet("background-color:green");
-				}
-				else {
-					ui->label_Cali2->setStyleSheet("background-color:gray");
-				}
-				if (cali3 == true) {
-					ui->label_Cali3->setStyleSheet("background-color:green");
-				}
-				else {
-					ui->label_Cali3->setStyleSheet("background-color:gray");
-				}
-				if (cali4 == true) {
-					ui->label_Cali4->setStyleSheet("background-color:green");
-				}
-				else {
-					ui->label_Cali4->setStyleSheet("background-color:gray");
-				}
-
-				if (cali5 == true) {
-					ui->label_Cali5->setStyleSheet("background-color:green");
-				}
-				else {
-					ui->label_Cali5->setStyleSheet("background-color:gray");
-				}
-			}
-			else if (array.count() == 7)
+			const auto done = distanceStates(data);
+			qDebug() << "qjsonarray_Count:" << done.count();
+			recordSession(SK_DIST_STATES, data);
+			if (done.count() == 5 || done.count() == 7)
 			{
-				qDebug() << "qjsonarray_Count:" << array.count();
-				bool cali1 = array[0].toBool();
-				bool cali2 = array[1].toBool();
-				bool cali3 = array[2].toBool();
-				bool cali4 = array[3].toBool();
-				bool cali5 = array[4].toBool();
-				bool cali6 = array[5].toBool();
-				bool cali7 = array[6].toBool();
-				if (cali1 == true) {
-					ui->label_7Cali1->setStyleSheet("background-color:green");
-				}
-				else {
-					ui->label_7Cali1->setStyleSheet("background-color:gray");
-				}
-				if (cali2 == true) {
-					ui->label_7Cali2->setStyleSheet("background-color:green");
-				}
-				else {
-					ui->label_7Cali2->setStyleSheet("background-color:gray");
-				}
-				if (cali3 == true) {
-					ui->label_7Cali3->setStyleSheet("background-color:green");
-				}
-				else {
-					ui->label_7Cali3->setStyleSheet("background-color:gray");
-				}
-				if (cali4 == true) {
-					ui->label_7Cali4->setStyleSheet("background-color:green");
-				}
-				else {
-					ui->label_7Cali4->setStyleSheet("background-color:gray");
-				}
-				if (cali5 == true) {
-					ui->label_7Cali5->setStyleSheet("background-color:green");
-				}
-				else {
-					ui->label_7Cali5->setStyleSheet("background-color:gray");
-				}
-				if (cali6 == true) {
-					ui->label_7Cali6->setStyleSheet("background-color:green");
-				}
-				else {
-					ui->label_7Cali6->setStyleSheet("background-color:gray");
-				}
-				if (cali7 == true) {
-					ui->label_7Cali7->setStyleSheet("background-color:green");
-				}
-				else {
-					ui->label_7Cali7->setStyleSheet("background-color:gray");
-				}
+				m_statusModel->setDone(done.count() == 5 ? m_dist5Group : m_dist7Group, done);
+				m_sessionComplete = !done.contains(false);
 			}
 		}	
 	}
@@ -686,61 +765,26 @@ void MainWindow::resetCaliStatus()
 {
 	if (ui->widget_Calibration5->isVisible())
 	{
-		ui->label_Cali1->setStyleSheet("background-color:gray");
-		ui->label_Cali2->setStyleSheet("background-color:gray");
-		ui->label_Cali3->setStyleSheet("background-color:gray");
-		ui->label_Cali4->setStyleSheet("background-color:gray");
-		ui->label_Cali5->setStyleSheet("background-color:gray");
+		m_statusModel->setAll(m_dist5Group, IS_PENDING);
 	}
 	else if (ui->widget_Calibration7->isVisible())
 	{
-		ui->label_7Cali1->setStyleSheet("background-color:gray");
-		ui->label_7Cali2->setStyleSheet("background-color:gray");
-		ui->label_7Cali3->setStyleSheet("background-color:gray");
-		ui->label_7Cali4->setStyleSheet("background-color:gray");
-		ui->label_7Cali5->setStyleSheet("background-color:gray");
-		ui->label_7Cali6->setStyleSheet("background-color:gray");
-		ui->label_7Cali7->setStyleSheet("background-color:gray");
+		m_statusModel->setAll(m_dist7Group, IS_PENDING);
 	}
 }
 
-void MainWindow::onVideoImageReady(int camID, QPixmap pixmap)
+void MainWindow::onVideoImageReady(int camID, const VideoFrame& frame)
 {
-	
+	if (camID >= 0 && camID < 2)
+		m_videoWidgets[camID]->setFrame(frame);
 }
 
 bool MainWindow::sendData(void* socket, const QString& cmd, const QByteArray& data)
 {
-	int nbytes = 0;
-
-	auto envelop = ("v1.0/" + cmd).toLocal8Bit();
-	if (data != ""){
-		nbytes = zmq_send(socket, envelop.constData(), envelop.size(), ZMQ_SNDMORE);
-		if (nbytes != envelop.size()){
-			qCritical() << "Send envelop error! nbytes:" << nbytes;
-			return false;
-		}
-		nbytes = zmq_send(socket, data.constData(), data.size(), 0);
-		if (nbytes != data.size()){
-			qCritical() << "Send data error!"
-				<< " nbytes:" << nbytes
-				<< " data size:" << data.size()
-				<< " data : " << data;
-
-			return false;
-		}
-	}
-	else{
-		nbytes = zmq_send(socket, envelop.constData(), envelop.size(), 0);
-		if (nbytes != envelop.size()){
-			qCritical() << "Send envelop error! nbytes:" << nbytes;
-			return false;
-		}
-	}
-
-	char buf[MAX_DATA_LENGTH + 1] = { 0 };
-	nbytes = zmq_recv(socket, buf, MAX_DATA_LENGTH, 0);
-	return true;
+	TRACE_SCOPE("sendData");
+	if (socket == m_client.socket())
+		return m_client.request(cmd, data, nullptr);
+	return CalibrationClient(socket).request(cmd, data, nullptr);
 }
 
 
@@ -9,24 +9,32 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QThread>
-#include <QPixmap>
+#include "videowidget.h"
 #include <QVector>
 #include "progressdialog.h"
+#include "protocol.h"
 #include "subscriber.h"
 #include "dataprocesser.h"
+#include "devicemanager.h"
+#include "calibrationclient.h"
+#include "statusviewmodel.h"
+#include "sessionlog.h"
 namespace Ui {
 class MainWindow;
 }
 
-#define MAX_ENVELOPE_LENGTH 255
-#define MAX_DATA_LENGTH 1000
 
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
 
 public:
-    explicit MainWindow(QWidget *parent = nullptr);
+	/*
+	devices:scanners served by this process,the default local SDK if empty
+	tuning:ZMQ socket options per channel
+	*/
+    explicit MainWindow(const QList<DeviceEndpoint>& devices = QList<DeviceEndpoint>(),
+		const SocketTuningConfig& tuning = SocketTuningConfig(), QWidget *parent = nullptr);
     ~MainWindow();
 public:
 	/*
@@ -45,6 +53,37 @@ public:
 	Check if there is any data received
 	*/
 	bool hasMore(void* socket);
+	/*
+	path:tee the SDK publish stream into this log,empty to stop
+	*/
+	void setRecordFile(const QString& path);
+	/*
+	baseName:shm frame ring of the scanner,<baseName>.<device> when several scanners are served
+	Called before the window is shown
+	*/
+	void setFrameRing(const QString& baseName);
+	/*
+	path:append every calibration session(enter to exit) of this client to this log
+	*/
+	void setSessionLog(const QString& path);
+	/*
+	roi:region of every camera frame the focus score is computed over,called before the window is shown
+	*/
+	void setSharpnessRoi(const SharpnessRoi& roi);
+	/*
+	spec:board searched in every camera frame,DE_CLICK only snaps while both cameras see all of it
+	Called before the window is shown
+	*/
+	void setBoard(const BoardSpec& spec);
+	/*
+	params:extract marker centroids from the gray camera frames,called before the window is shown
+	*/
+	void setMarkers(const MarkerParams& params);
+	/*
+	tolerance:camera frames that differ less from the last shown one are not converted,negative shows every frame
+	Called before the window is shown
+	*/
+	void setChangeTolerance(int tolerance);
 private slots:
 //There are some SDK test function ,  refer to SDK Document
 	void on_pushButton_DeviceCheck_clicked();// The button on the interface press to trigger,refer to SDK Doc
@@ -78,7 +117,15 @@ private slots:
 	pixmap:image data
 	This function to show video
 	*/
-	void onVideoImageReady(int camID, QPixmap pixmap);
+	void onVideoImageReady(int camID, const VideoFrame& frame);
+	/*
+	device:index in the device manager,the GUI drives one scanner at a time
+	*/
+	void selectDevice(int device);
+	/*
+	Deferred from the constructor:start the device threads and pull asynchronously
+	*/
+	void startDevices();
 
 	void on_pushButton_Step1Next_clicked();
 	void on_pushButton_Step2Next_clicked();
@@ -89,8 +136,17 @@ private slots:
 
 private:
 	void resetCaliStatus();
+	void recordSession(SessionRecordKind kind, const QByteArray& data);
+	void endSession(SessionOutcome outcome);
+	void showSharpness();
+	bool boardVisible() const;
 	QVector<QWidget*> lineEdit_Group;
 	QVector<QWidget*> widget_Step;
+	StatusViewModel* m_statusModel = nullptr;
+	VideoWidget* m_videoWidgets[2] = { nullptr, nullptr };
+	int m_dist5Group = 0;
+	int m_dist7Group = 0;
+	int m_calibrationGroup = 0;
 
 	void nextStep(int num);
 	void backStep(int num);
@@ -108,16 +164,26 @@ public:
 private:
     Ui::MainWindow *ui;
 	void* m_zmqContext = nullptr;
-    void* m_zmqReqSocket = nullptr;
+	CalibrationClient m_client;
 	void* m_zmqDataProcesserSocket = nullptr;
 
 	QTimer* m_heartbeatTimer = nullptr;
 
-    QThread* m_subscriberThread = nullptr;
+	DeviceManager* m_deviceManager = nullptr;
+	int m_currentDevice = 0;
     Subscriber* m_subscriber = nullptr;
     ProgressDialog* m_progressDialog = nullptr;
-	QThread* m_dataProcesserThread = nullptr;
 	DataProcesser* m_dataProcesser = nullptr;
+	SessionLogWriter m_sessionLog;
+	quint32 m_session = 0;
+	bool m_sessionComplete = false;//all distances snapped
+	QString m_subType;
+	double m_sharpness[2] = { 0, 0 };
+	double m_sharpnessPeak[2] = { 0, 0 };//best score since the distance changed
+	bool m_boardGate = false;
+	bool m_boardFound[2] = { false, false };
+	QElapsedTimer m_boardSeen[2];//newest detection result per camera
+	MetricCounter* m_snapsGatedMetric = nullptr;
 
 	
 
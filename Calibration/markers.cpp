@@ -0,0 +1,127 @@
+#include "markers.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+	//pixels the refinement window extends past the bounding box,the blurred rim of the marker
+	const int WINDOW_MARGIN = 2;
+	//candidates a worker claims at a time,the budget is checked between chunks
+	const int REFINE_CHUNK = 16;
+}
+
+bool refineMarker(const unsigned char* data, int width, int height, const Blob& blob, const MarkerParams& params, Marker& marker)
+{
+	const int left = std::max(0, blob.left - WINDOW_MARGIN);
+	const int top = std::max(0, blob.top - WINDOW_MARGIN);
+	const int right = std::min(width - 1, blob.right + WINDOW_MARGIN);
+	const int bottom = std::min(height - 1, blob.bottom + WINDOW_MARGIN);
+
+	//mean of the window border
+	int64_t borderSum = 0;
+	int borderPixels = 0;
+	for (int x = left; x <= right; x++){
+		borderSum += data[size_t(top) * width + x] + data[size_t(bottom) * width + x];
+		borderPixels += 2;
+	}
+	for (int y = top + 1; y < bottom; y++){
+		borderSum += data[size_t(y) * width + left] + data[size_t(y) * width + right];
+		borderPixels += 2;
+	}
+	const int background = borderPixels ? int(borderSum / borderPixels) : 0;
+
+	//moments around the window origin keep the sums small
+	double m0 = 0, mx = 0, my = 0, mxx = 0, myy = 0, mxy = 0;
+	int peak = 0;
+	for (int y = top; y <= bottom; y++){
+		auto row = data + size_t(y) * width;
+		const double dy = y - top;
+		for (int x = left; x <= right; x++){
+			const int weight = row[x] - background;
+			if (weight <= 0)
+				continue;
+			const double dx = x - left;
+			m0 += weight;
+			mx += weight * dx;
+			my += weight * dy;
+			mxx += weight * dx * dx;
+			myy += weight * dy * dy;
+			mxy += weight * dx * dy;
+			peak = std::max(peak, weight);
+		}
+	}
+	if (m0 <= 0)
+		return false;
+	const double cx = mx / m0, cy = my / m0;
+	const double varX = mxx / m0 - cx * cx;
+	const double varY = myy / m0 - cy * cy;
+	const double covXY = mxy / m0 - cx * cy;
+	//eigenvalues of the covariance,a filled ellipse has variance a*a/4 along a semi axis a
+	const double mean = (varX + varY) / 2;
+	const double spread = std::sqrt((varX - varY) * (varX - varY) / 4 + covXY * covXY);
+	const double major = 2 * std::sqrt(std::max(0.0, mean + spread));
+	const double minor = 2 * std::sqrt(std::max(0.0, mean - spread));
+	if (major <= 0 || minor / major < params.minAxisRatio)
+		return false;
+
+	marker.x = left + cx;
+	marker.y = top + cy;
+	marker.major = major;
+	marker.minor = minor;
+	marker.angle = 0.5 * std::atan2(2 * covXY, varX - varY);
+	marker.area = blob.area;
+	marker.peak = peak;
+	return true;
+}
+
+MarkerResult findMarkers(const unsigned char* data, int width, int height, const MarkerParams& params, WorkerPool* pool)
+{
+	MarkerResult result;
+	if (!data || width <= 0 || height <= 0)
+		return result;
+	const auto start = std::chrono::steady_clock::now();
+	const auto deadline = start + std::chrono::microseconds(params.budgetUs);
+
+	BlobParams blobParams;
+	blobParams.tileSize = params.tileSize;
+	blobParams.minContrast = params.minContrast;
+	blobParams.flatBackground = true;
+	blobParams.minArea = params.minArea;
+	blobParams.maxArea = params.maxArea;
+	const auto blobs = findBlobs(data, width, height, 1, blobParams, pool);
+	result.candidates = int(blobs.size());
+
+	std::vector<Marker> markers(blobs.size());
+	std::vector<char> valid(blobs.size(), 0);
+	std::atomic<int> next(0);
+	std::atomic<int> refined(0);
+	auto worker = [&]{
+		for (;;){
+			if (params.budgetUs > 0 && std::chrono::steady_clock::now() >= deadline)
+				return;
+			const int first = next.fetch_add(REFINE_CHUNK);
+			if (first >= int(blobs.size()))
+				return;
+			const int last = std::min(int(blobs.size()), first + REFINE_CHUNK);
+			for (int i = first; i < last; i++)
+				valid[i] = refineMarker(data, width, height, blobs[i], params, markers[i]);
+			refined += last - first;
+		}
+	};
+	const int threads = std::max(1, std::min(pool ? pool->threads() : 1, int(blobs.size() + REFINE_CHUNK - 1) / REFINE_CHUNK));
+	if (threads > 1)
+		pool->run(threads, [&](int){ worker(); });
+	else
+		worker();
+
+	result.refined = refined;
+	result.complete = result.refined == result.candidates;
+	result.markers.reserve(blobs.size());
+	for (size_t i = 0; i < blobs.size(); i++){
+		if (valid[i])
+			result.markers.push_back(markers[i]);
+	}
+	return result;
+}
@@ -0,0 +1,52 @@
+#ifndef MARKERS_H
+#define MARKERS_H
+
+#include <vector>
+#include "blobs.h"
+/*
+Sub-pixel centroids of the bright round markers in a gray camera frame.
+Candidates come from findBlobs with flat tiles as background,each candidate is refined in a window
+around its bounding box:the window border gives the local background,the background subtracted gray values
+weight the centroid and the second moments,and the moments give the fitted ellipse.
+Refinement is spread over threads and stops once the frame used up its time budget.
+*/
+struct Marker
+{
+	double x = 0;//intensity weighted centroid
+	double y = 0;
+	double major = 0;//ellipse semi axes in pixels
+	double minor = 0;
+	double angle = 0;//of the major axis,radians from the x axis
+	int area = 0;//thresholded pixels
+	int peak = 0;//brightest gray value above the background
+};
+
+struct MarkerParams
+{
+	int tileSize = 32;
+	int minContrast = 40;//tiles with less range hold no marker
+	int minArea = 4;
+	int maxArea = 4096;
+	double minAxisRatio = 0.25;//minor/major,flatter ellipses are edges and reflections
+	int budgetUs = 8000;//labelling and refinement of one frame,0 is unbounded
+};
+
+struct MarkerResult
+{
+	std::vector<Marker> markers;
+	int candidates = 0;//blobs found by the labelling
+	int refined = 0;//candidates refined before the budget ran out
+	bool complete = true;//false when the budget cut the refinement short
+};
+
+/*
+data:width*height gray pixels
+pool:runs the labelling bands and the refinement,null works on the calling thread
+*/
+MarkerResult findMarkers(const unsigned char* data, int width, int height, const MarkerParams& params, WorkerPool* pool = nullptr);
+/*
+Refine one labelled blob,false when it is not a marker
+*/
+bool refineMarker(const unsigned char* data, int width, int height, const Blob& blob, const MarkerParams& params, Marker& marker);
+
+#endif // MARKERS_H
@@ -0,0 +1,223 @@
+#include "metrics.h"
+#include <QSaveFile>
+#include <QMutexLocker>
+#include <QtDebug>
+#include <algorithm>
+#include <new>
+
+int metricShard()
+{
+	static std::atomic<int> nextShard{ 0 };
+	static thread_local int shard = nextShard.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARDS;
+	return shard;
+}
+
+quint64 MetricCounter::value() const
+{
+	quint64 total = 0;
+	for (int i = 0; i < METRIC_SHARDS; i++)
+		total += m_shards[i].value.load(std::memory_order_relaxed);
+	return total;
+}
+
+MetricHistogram::MetricHistogram(const QVector<qint64>& boundsNs)
+	: m_bounds(boundsNs)
+{
+	std::sort(m_bounds.begin(), m_bounds.end());
+	//the buckets of every shard start on a cache line of their own
+	const int perLine = METRIC_CACHE_LINE / int(sizeof(std::atomic<quint64>));
+	m_bucketStride = (m_bounds.size() + 1 + perLine - 1) / perLine * perLine;
+	const int buckets = m_bucketStride * METRIC_SHARDS;
+	m_buckets = static_cast<std::atomic<quint64>*>(qMallocAligned(size_t(buckets) * sizeof(std::atomic<quint64>), METRIC_CACHE_LINE));
+	for (int b = 0; b < buckets; b++)
+		new (m_buckets + b) std::atomic<quint64>(0);
+	for (int i = 0; i < METRIC_SHARDS; i++)
+		m_shards[i].buckets = m_buckets + size_t(i) * m_bucketStride;
+}
+
+MetricHistogram::~MetricHistogram()
+{
+	//std::atomic<quint64> is trivially destructible
+	qFreeAligned(m_buckets);
+}
+
+void MetricHistogram::observe(qint64 ns)
+{
+	auto bucket = std::lower_bound(m_bounds.constBegin(), m_bounds.constEnd(), ns) - m_bounds.constBegin();
+	auto& shard = m_shards[metricShard()];
+	shard.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+	shard.sum.fetch_add(ns, std::memory_order_relaxed);
+}
+
+MetricHistogram::Snapshot MetricHistogram::snapshot() const
+{
+	Snapshot snap;
+	snap.bounds = m_bounds;
+	snap.cumulative.fill(0, m_bounds.size() + 1);
+	for (int i = 0; i < METRIC_SHARDS; i++){
+		for (int b = 0; b <= m_bounds.size(); b++)
+			snap.cumulative[b] += m_shards[i].buckets[b].load(std::memory_order_relaxed);
+		snap.sum += m_shards[i].sum.load(std::memory_order_relaxed);
+	}
+	for (int b = 1; b <= m_bounds.size(); b++)
+		snap.cumulative[b] += snap.cumulative[b - 1];
+	snap.count = snap.cumulative.last();
+	return snap;
+}
+
+qint64 MetricHistogram::Snapshot::quantile(double q) const
+{
+	if (count == 0)
+		return 0;
+	const double rank = q * count;
+	for (int b = 0; b < cumulative.size(); b++){
+		if (cumulative[b] < rank)
+			continue;
+		//values above the last bound are reported as the last bound
+		if (b == bounds.size())
+			return bounds.isEmpty() ? 0 : bounds.last();
+		const qint64 lower = b == 0 ? 0 : bounds[b - 1];
+		const quint64 below = b == 0 ? 0 : cumulative[b - 1];
+		const quint64 inBucket = cumulative[b] - below;
+		const double fraction = inBucket ? (rank - below) / inBucket : 0.0;
+		return lower + qint64((bounds[b] - lower) * fraction);
+	}
+	return bounds.isEmpty() ? 0 : bounds.last();
+}
+
+QVector<qint64> MetricHistogram::latencyBounds()
+{
+	QVector<qint64> bounds;
+	const qint64 us = 1000;
+	for (qint64 decade = 10 * us; decade <= qint64(10) * 1000 * 1000 * 1000; decade *= 10){
+		bounds << decade;
+		if (decade < qint64(10) * 1000 * 1000 * 1000){
+			bounds << decade * 2;
+			bounds << decade * 5;
+		}
+	}
+	return bounds;
+}
+
+MetricsRegistry& MetricsRegistry::instance()
+{
+	static MetricsRegistry registry;
+	return registry;
+}
+
+MetricsRegistry::Entry* MetricsRegistry::find(const QString& name, const QString& labels)
+{
+	for (auto& entry : m_entries){
+		if (entry->name == name && entry->labels == labels)
+			return entry.get();
+	}
+	return nullptr;
+}
+
+MetricCounter* MetricsRegistry::counter(const QString& name, const QString& help, const QString& labels)
+{
+	QMutexLocker locker(&m_mutex);
+	if (auto entry = find(name, labels)){
+		Q_ASSERT(entry->type == COUNTER);
+		return static_cast<MetricCounter*>(entry->metric);
+	}
+	m_counters.emplace_back(new MetricCounter);
+	m_entries.emplace_back(new Entry{ name, help, labels, COUNTER, m_counters.back().get() });
+	return m_counters.back().get();
+}
+
+MetricGauge* MetricsRegistry::gauge(const QString& name, const QString& help, const QString& labels)
+{
+	QMutexLocker locker(&m_mutex);
+	if (auto entry = find(name, labels)){
+		Q_ASSERT(entry->type == GAUGE);
+		return static_cast<MetricGauge*>(entry->metric);
+	}
+	m_gauges.emplace_back(new MetricGauge);
+	m_entries.emplace_back(new Entry{ name, help, labels, GAUGE, m_gauges.back().get() });
+	return m_gauges.back().get();
+}
+
+MetricHistogram* MetricsRegistry::histogram(const QString& name, const QString& help, const QString& labels,
+	const QVector<qint64>& boundsNs)
+{
+	QMutexLocker locker(&m_mutex);
+	if (auto entry = find(name, labels)){
+		Q_ASSERT(entry->type == HISTOGRAM);
+		return static_cast<MetricHistogram*>(entry->metric);
+	}
+	m_histograms.emplace_back(new MetricHistogram(boundsNs));
+	m_entries.emplace_back(new Entry{ name, help, labels, HISTOGRAM, m_histograms.back().get() });
+	return m_histograms.back().get();
+}
+
+QByteArray MetricsRegistry::exposition() const
+{
+	QMutexLocker locker(&m_mutex);
+	//group series of the same name so HELP/TYPE appear once
+	std::vector<const Entry*> entries;
+	for (auto& entry : m_entries)
+		entries.push_back(entry.get());
+	std::stable_sort(entries.begin(), entries.end(), [](const Entry* a, const Entry* b){ return a->name < b->name; });
+
+	auto braced = [](const QString& labels, const QString& extra) -> QString {
+		QString all = labels;
+		if (!extra.isEmpty())
+			all = all.isEmpty() ? extra : all + ',' + extra;
+		return all.isEmpty() ? QString() : '{' + all + '}';
+	};
+
+	QString out;
+	QString lastName;
+	for (auto entry : entries){
+		if (entry->name != lastName){
+			static const char* typeNames[] = { "counter", "gauge", "histogram" };
+			out += QString("# HELP %1 %2\n# TYPE %1 %3\n").arg(entry->name, entry->help, typeNames[entry->type]);
+			lastName = entry->name;
+		}
+		switch (entry->type){
+		case COUNTER:
+			out += QString("%1%2 %3\n").arg(entry->name, braced(entry->labels, QString()))
+				.arg(static_cast<MetricCounter*>(entry->metric)->value());
+			break;
+		case GAUGE:
+			out += QString("%1%2 %3\n").arg(entry->name, braced(entry->labels, QString()))
+				.arg(static_cast<MetricGauge*>(entry->metric)->value());
+			break;
+		case HISTOGRAM:{
+			auto snap = static_cast<MetricHistogram*>(entry->metric)->snapshot();
+			for (int b = 0; b < snap.cumulative.size(); b++){
+				auto le = b < snap.bounds.size() ? QString::number(snap.bounds[b] / 1e9, 'g', 6) : QStringLiteral("+Inf");
+				out += QString("%1_bucket%2 %3\n").arg(entry->name, braced(entry->labels, QString("le=\"%1\"").arg(le)))
+					.arg(snap.cumulative[b]);
+			}
+			out += QString("%1_sum%2 %3\n").arg(entry->name, braced(entry->labels, QString()))
+				.arg(snap.sum / 1e9, 0, 'g', 9);
+			out += QString("%1_count%2 %3\n").arg(entry->name, braced(entry->labels, QString())).arg(snap.count);
+			break;
+		}
+		}
+	}
+	return out.toUtf8();
+}
+
+MetricsExporter::MetricsExporter(const QString& path, int intervalMs, QObject *parent)
+	: QObject(parent), m_path(path)
+{
+	m_timer = new QTimer(this);
+	m_timer->setInterval(intervalMs);
+	connect(m_timer, &QTimer::timeout, this, &MetricsExporter::write);
+	m_timer->start();
+}
+
+void MetricsExporter::write()
+{
+	//readers never see a half written file
+	QSaveFile file(m_path);
+	if (!file.open(QIODevice::WriteOnly)){
+		qWarning() << "cannot write metrics file:" << m_path << file.errorString();
+		return;
+	}
+	file.write(MetricsRegistry::instance().exposition());
+	file.commit();
+}
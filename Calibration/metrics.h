@@ -0,0 +1,152 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QMutex>
+#include <QTimer>
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+#include <vector>
+/*
+Lock-free metrics with Prometheus text exposition.
+Registration takes a lock,updates are relaxed atomics on a per-thread shard so
+threads never contend on the same cache line.
+*/
+const int METRIC_SHARDS = 16;
+/*
+Shard of the calling thread,assigned round-robin on first use
+*/
+int metricShard();
+const int METRIC_CACHE_LINE = 64;
+
+/*
+Metrics with shards on their own cache lines,new before C++17 only aligns to 16 bytes
+*/
+struct MetricAligned
+{
+	static void* operator new(size_t size) { return qMallocAligned(size, METRIC_CACHE_LINE); }
+	static void operator delete(void* p) { qFreeAligned(p); }
+};
+
+class MetricCounter : public MetricAligned
+{
+public:
+	void inc(quint64 n = 1)
+	{ m_shards[metricShard()].value.fetch_add(n, std::memory_order_relaxed); }
+	quint64 value() const;
+private:
+	//a cache line each so shards of different threads never share one
+	struct alignas(METRIC_CACHE_LINE) Shard
+	{
+		std::atomic<quint64> value{ 0 };
+	};
+	Shard m_shards[METRIC_SHARDS];
+};
+
+class MetricGauge
+{
+public:
+	void set(qint64 v) { m_value.store(v, std::memory_order_relaxed); }
+	void add(qint64 n) { m_value.fetch_add(n, std::memory_order_relaxed); }
+	qint64 value() const { return m_value.load(std::memory_order_relaxed); }
+private:
+	std::atomic<qint64> m_value{ 0 };
+};
+
+/*
+Latency histogram,observations and bucket bounds are in nanoseconds,exported in seconds
+*/
+class MetricHistogram : public MetricAligned
+{
+public:
+	explicit MetricHistogram(const QVector<qint64>& boundsNs);
+	~MetricHistogram();
+	MetricHistogram(const MetricHistogram&) = delete;
+	MetricHistogram& operator=(const MetricHistogram&) = delete;
+	void observe(qint64 ns);
+
+	struct Snapshot
+	{
+		QVector<qint64> bounds;
+		QVector<quint64> cumulative;//one per bound plus +Inf
+		quint64 count = 0;
+		qint64 sum = 0;
+		/*
+		q:quantile in [0,1],interpolated inside the bucket
+		*/
+		qint64 quantile(double q) const;
+	};
+	Snapshot snapshot() const;
+
+	/*
+	Default latency bounds,10us..10s
+	*/
+	static QVector<qint64> latencyBounds();
+private:
+	struct alignas(METRIC_CACHE_LINE) Shard
+	{
+		std::atomic<quint64>* buckets = nullptr;//whole cache lines of m_buckets
+		std::atomic<qint64> sum{ 0 };
+	};
+	QVector<qint64> m_bounds;
+	Shard m_shards[METRIC_SHARDS];
+	std::atomic<quint64>* m_buckets = nullptr;
+	int m_bucketStride = 0;
+};
+
+class MetricsRegistry
+{
+public:
+	static MetricsRegistry& instance();
+	/*
+	name:Prometheus metric name
+	labels:label set without braces,e.g. device="left"
+	The same name+labels always returns the same metric
+	*/
+	MetricCounter* counter(const QString& name, const QString& help, const QString& labels = QString());
+	MetricGauge* gauge(const QString& name, const QString& help, const QString& labels = QString());
+	MetricHistogram* histogram(const QString& name, const QString& help, const QString& labels = QString(),
+		const QVector<qint64>& boundsNs = MetricHistogram::latencyBounds());
+	/*
+	Prometheus text format 0.0.4
+	*/
+	QByteArray exposition() const;
+private:
+	enum Type { COUNTER, GAUGE, HISTOGRAM };
+	struct Entry
+	{
+		QString name;
+		QString help;
+		QString labels;
+		Type type;
+		void* metric;
+	};
+	Entry* find(const QString& name, const QString& labels);
+
+	mutable QMutex m_mutex;
+	std::vector<std::unique_ptr<Entry> > m_entries;
+	std::vector<std::unique_ptr<MetricCounter> > m_counters;
+	std::vector<std::unique_ptr<MetricGauge> > m_gauges;
+	std::vector<std::unique_ptr<MetricHistogram> > m_histograms;
+};
+
+/*
+Periodically rewrite the exposition into a file(node_exporter textfile collector)
+*/
+class MetricsExporter : public QObject
+{
+	Q_OBJECT
+public:
+	MetricsExporter(const QString& path, int intervalMs, QObject *parent = nullptr);
+public slots:
+	void write();
+private:
+	QString m_path;
+	QTimer* m_timer = nullptr;
+};
+
+#endif // METRICS_H
@@ -0,0 +1,487 @@
+#include "notification.h"
+#include <cmath>
+#include <new>
+
+namespace
+{
+	//deeper nesting is rejected instead of recursing on
+	const int MAX_DEPTH = 64;
+
+	class Reader
+	{
+	public:
+		Reader(const char* text, int size, JsonArena& arena) : m_p(text), m_end(text + size), m_arena(arena) {}
+
+		bool atEnd()
+		{
+			skipSpace();
+			return m_p == m_end;
+		}
+
+		bool object(JsonObjectView* object)
+		{
+			skipSpace();
+			if (!consume('{'))
+				return false;
+			object->members = nullptr;
+			object->count = 0;
+			skipSpace();
+			if (consume('}'))
+				return true;
+			while (true){
+				auto member = m_arena.allocateMember();
+				if (!member)
+					return false;
+				if (!object->members)
+					object->members = member;
+				object->count++;
+				skipSpace();
+				if (!string(&member->key))
+					return false;
+				skipSpace();
+				if (!consume(':'))
+					return false;
+				skipSpace();
+				if (!value(member, 0))
+					return false;
+				skipSpace();
+				if (consume('}'))
+					return true;
+				if (!consume(','))
+					return false;
+			}
+		}
+	private:
+		void skipSpace()
+		{
+			while (m_p < m_end && (*m_p == ' ' || *m_p == '\t' || *m_p == '\n' || *m_p == '\r'))
+				m_p++;
+		}
+
+		bool consume(char c)
+		{
+			if (m_p == m_end || *m_p != c)
+				return false;
+			m_p++;
+			return true;
+		}
+
+		bool literal(const char* word)
+		{
+			const int length = int(strlen(word));
+			if (m_end - m_p < length || memcmp(m_p, word, length))
+				return false;
+			m_p += length;
+			return true;
+		}
+
+		static int hexDigit(char c)
+		{
+			if (c >= '0' && c <= '9')
+				return c - '0';
+			if (c >= 'a' && c <= 'f')
+				return c - 'a' + 10;
+			if (c >= 'A' && c <= 'F')
+				return c - 'A' + 10;
+			return -1;
+		}
+
+		bool hex4(unsigned* code)
+		{
+			if (m_end - m_p < 4)
+				return false;
+			*code = 0;
+			for (int i = 0; i < 4; i++){
+				const int digit = hexDigit(m_p[i]);
+				if (digit < 0)
+					return false;
+				*code = *code * 16 + unsigned(digit);
+			}
+			m_p += 4;
+			return true;
+		}
+
+		static char* utf8(unsigned code, char* out)
+		{
+			if (code < 0x80){
+				*out++ = char(code);
+			}
+			else if (code < 0x800){
+				*out++ = char(0xC0 | (code >> 6));
+				*out++ = char(0x80 | (code & 0x3F));
+			}
+			else if (code < 0x10000){
+				*out++ = char(0xE0 | (code >> 12));
+				*out++ = char(0x80 | ((code >> 6) & 0x3F));
+				*out++ = char(0x80 | (code & 0x3F));
+			}
+			else{
+				*out++ = char(0xF0 | (code >> 18));
+				*out++ = char(0x80 | ((code >> 12) & 0x3F));
+				*out++ = char(0x80 | ((code >> 6) & 0x3F));
+				*out++ = char(0x80 | (code & 0x3F));
+			}
+			return out;
+		}
+
+		//a view into the text,decoded into the arena only when it has escapes
+		bool string(JsonText* text)
+		{
+			if (!consume('"'))
+				return false;
+			const char* begin = m_p;
+			bool escaped = false;
+			while (true){
+				if (m_p == m_end || (unsigned char)(*m_p) < 0x20)
+					return false;
+				if (*m_p == '"')
+					break;
+				if (*m_p == '\\'){
+					escaped = true;
+					if (++m_p == m_end)
+						return false;
+				}
+				m_p++;
+			}
+			const char* end = m_p++;
+			if (!escaped){
+				text->data = begin;
+				text->size = int(end - begin);
+				return true;
+			}
+			//decoded is never longer than escaped
+			char* out = m_arena.allocateText(int(end - begin));
+			if (!out)
+				return false;
+			text->data = out;
+			const char* cursor = m_p;
+			m_p = begin;
+			while (m_p < end){
+				if (*m_p != '\\'){
+					*out++ = *m_p++;
+					continue;
+				}
+				m_p++;
+				switch (*m_p++){
+				case '"': *out++ = '"'; break;
+				case '\\': *out++ = '\\'; break;
+				case '/': *out++ = '/'; break;
+				case 'b': *out++ = '\b'; break;
+				case 'f': *out++ = '\f'; break;
+				case 'n': *out++ = '\n'; break;
+				case 'r': *out++ = '\r'; break;
+				case 't': *out++ = '\t'; break;
+				case 'u':{
+					unsigned code = 0;
+					if (end - m_p < 4 || !hex4(&code))
+						return false;
+					//surrogate pair,a lone half becomes U+FFFD
+					if (code >= 0xD800 && code < 0xDC00){
+						const char* pair = m_p;
+						unsigned low = 0;
+						bool paired = false;
+						if (end - m_p >= 6 && m_p[0] == '\\' && m_p[1] == 'u'){
+							m_p += 2;
+							paired = hex4(&low) && low >= 0xDC00 && low < 0xE000;
+						}
+						if (paired){
+							code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+						}
+						else{
+							m_p = pair;
+							code = 0xFFFD;
+						}
+					}
+					else if (code >= 0xDC00 && code < 0xE000){
+						code = 0xFFFD;
+					}
+					out = utf8(code, out);
+					break;
+				}
+				default:
+					return false;
+				}
+			}
+			text->size = int(out - text->data);
+			m_p = cursor;
+			return true;
+		}
+
+		bool digits()
+		{
+			const char* begin = m_p;
+			while (m_p < m_end && *m_p >= '0' && *m_p <= '9')
+				m_p++;
+			return m_p > begin;
+		}
+
+		bool number()
+		{
+			consume('-');
+			if (m_p == m_end)
+				return false;
+			if (*m_p == '0')
+				m_p++;
+			else if (!digits())
+				return false;
+			if (consume('.') && !digits())
+				return false;
+			if (m_p < m_end && (*m_p == 'e' || *m_p == 'E')){
+				m_p++;
+				if (!consume('+'))
+					consume('-');
+				if (!digits())
+					return false;
+			}
+			return true;
+		}
+
+		//validates a nested value without storing its members
+		bool skip(int depth)
+		{
+			if (depth > MAX_DEPTH || m_p == m_end)
+				return false;
+			switch (*m_p){
+			case '"':
+				return skipString();
+			case '{':
+				m_p++;
+				skipSpace();
+				if (consume('}'))
+					return true;
+				while (true){
+					skipSpace();
+					if (!skipString())
+						return false;
+					skipSpace();
+					if (!consume(':'))
+						return false;
+					skipSpace();
+					if (!skip(depth + 1))
+						return false;
+					skipSpace();
+					if (consume('}'))
+						return true;
+					if (!consume(','))
+						return false;
+				}
+			case '[':
+				m_p++;
+				skipSpace();
+				if (consume(']'))
+					return true;
+				while (true){
+					skipSpace();
+					if (!skip(depth + 1))
+						return false;
+					skipSpace();
+					if (consume(']'))
+						return true;
+					if (!consume(','))
+						return false;
+				}
+			case 't':
+				return literal("true");
+			case 'f':
+				return literal("false");
+			case 'n':
+				return literal("null");
+			default:
+				return number();
+			}
+		}
+
+		//escapes are checked,not decoded
+		bool skipString()
+		{
+			if (!consume('"'))
+				return false;
+			while (m_p < m_end && *m_p != '"'){
+				if ((unsigned char)(*m_p) < 0x20)
+					return false;
+				if (*m_p++ != '\\')
+					continue;
+				if (m_p == m_end)
+					return false;
+				const char c = *m_p++;
+				if (c == 'u'){
+					unsigned code = 0;
+					if (!hex4(&code))
+						return false;
+				}
+				else if (!c || !strchr("\"\\/bfnrt", c)){
+					return false;
+				}
+			}
+			return consume('"');
+		}
+
+		bool value(JsonMember* member, int depth)
+		{
+			if (m_p == m_end)
+				return false;
+			const char* begin = m_p;
+			switch (*m_p){
+			case '"':
+				member->kind = JK_STRING;
+				return string(&member->value);
+			case '{':
+				member->kind = JK_OBJECT;
+				break;
+			case '[':
+				member->kind = JK_ARRAY;
+				break;
+			case 't':
+			case 'f':
+				member->kind = JK_BOOL;
+				break;
+			case 'n':
+				member->kind = JK_NULL;
+				break;
+			default:
+				member->kind = JK_NUMBER;
+				break;
+			}
+			if (!skip(depth + 1))
+				return false;
+			member->value.data = begin;
+			member->value.size = int(m_p - begin);
+			return true;
+		}
+
+		const char* m_p;
+		const char* m_end;
+		JsonArena& m_arena;
+	};
+}
+
+int64_t JsonMember::toInt(int64_t fallback) const
+{
+	if (kind != JK_NUMBER)
+		return fallback;
+	const char* p = value.data;
+	const char* end = p + value.size;
+	const bool negative = *p == '-';
+	if (negative)
+		p++;
+	//the common case,a plain integer that fits
+	double mantissa = 0;
+	int64_t integer = 0;
+	bool exact = true;
+	for (; p < end && *p >= '0' && *p <= '9'; p++){
+		if (integer > (INT64_MAX - (*p - '0')) / 10)
+			exact = false;
+		else
+			integer = integer * 10 + (*p - '0');
+		mantissa = mantissa * 10 + (*p - '0');
+	}
+	if (p == end && exact)
+		return negative ? -integer : integer;
+	//fraction and exponent,parsed by hand because strtod follows the C locale
+	int exponent = 0;
+	if (p < end && *p == '.'){
+		for (p++; p < end && *p >= '0' && *p <= '9'; p++){
+			mantissa = mantissa * 10 + (*p - '0');
+			exponent--;
+		}
+	}
+	if (p < end && (*p == 'e' || *p == 'E')){
+		p++;
+		const bool negativeExponent = *p == '-';
+		if (*p == '-' || *p == '+')
+			p++;
+		int e = 0;
+		for (; p < end && *p >= '0' && *p <= '9'; p++)
+			e = e < 10000 ? e * 10 + (*p - '0') : e;
+		exponent += negativeExponent ? -e : e;
+	}
+	const double number = (negative ? -mantissa : mantissa) * std::pow(10.0, exponent);
+	//like QJsonValue::toInt,only whole numbers convert
+	if (number != std::floor(number) || number < -9.2e18 || number > 9.2e18)
+		return fallback;
+	return int64_t(number);
+}
+
+bool JsonMember::toBool(bool fallback) const
+{
+	if (kind != JK_BOOL)
+		return fallback;
+	return value.data[0] == 't';
+}
+
+JsonMember* JsonArena::allocateMember()
+{
+	if (m_back - m_front < int(sizeof(JsonMember)))
+		return nullptr;
+	auto member = new (m_storage + m_front) JsonMember;
+	m_front += int(sizeof(JsonMember));
+	return member;
+}
+
+char* JsonArena::allocateText(int size)
+{
+	if (size < 0 || m_back - m_front < size)
+		return nullptr;
+	m_back -= size;
+	return m_storage + m_back;
+}
+
+const JsonMember* JsonObjectView::find(const char* key) const
+{
+	for (int i = 0; i < count; i++){
+		if (members[i].key.equals(key))
+			return &members[i];
+	}
+	return nullptr;
+}
+
+int64_t JsonObjectView::toInt(const char* key, int64_t fallback) const
+{
+	auto member = find(key);
+	return member ? member->toInt(fallback) : fallback;
+}
+
+JsonText JsonObjectView::text(const char* key) const
+{
+	auto member = find(key);
+	if (!member || member->kind != JK_STRING)
+		return JsonText();
+	return member->value;
+}
+
+bool parseJsonObject(const char* text, int size, JsonArena& arena, JsonObjectView* object)
+{
+	if (!text || size <= 0)
+		return false;
+	Reader reader(text, size, arena);
+	return reader.object(object) && reader.atEnd();
+}
+
+bool parseNotification(const char* text, int size, JsonArena& arena, Notification* notification)
+{
+	JsonObjectView object;
+	if (!parseJsonObject(text, size, arena, &object))
+		return false;
+	*notification = Notification();
+	notification->type = object.text("type");
+	notification->key = object.text("key");
+	notification->name = object.text("name");
+	notification->offset = object.toInt("offset");
+	auto props = object.find("props");
+	if (!props || props->kind != JK_OBJECT)
+		return true;
+	notification->props = props->value;
+	if (!notification->type.equals("MT_VIDEO_DATA"))
+		return true;
+	JsonObjectView video;
+	if (!parseJsonObject(props->value.data, props->value.size, arena, &video))
+		return false;
+	notification->rotate = int(video.toInt("rotate"));
+	notification->width = int(video.toInt("width"));
+	notification->height = int(video.toInt("height"));
+	notification->channel = int(video.toInt("channel"));
+	notification->pixelFormat = video.text("pixelFormat");
+	notification->windowLow = int(video.toInt("windowLow"));
+	notification->windowHigh = int(video.toInt("windowHigh"));
+	return true;
+}
@@ -0,0 +1,114 @@
+#ifndef NOTIFICATION_H
+#define NOTIFICATION_H
+
+#include <cstdint>
+#include <cstring>
+/*
+In-situ reader of the data processing notifications of the SDK,e.g.
+{"type":"MT_VIDEO_DATA","key":"...","name":"cam0","offset":0,"props":{"rotate":0,"width":1280,"height":1024,"channel":1}}
+Newer heads add "pixelFormat":"BayerRG8"/"Mono12"/... and optionally "windowLow","windowHigh" to the props.
+Fields are read straight from the receive buffer:a string without escapes is a view into it,
+one with escapes is decoded into the arena,a nested object or array is kept as its raw text.
+The arena has a fixed capacity and is reset per message,so reading a notification costs no heap allocation.
+*/
+struct JsonText
+{
+	const char* data = nullptr;
+	int size = 0;
+
+	bool isEmpty() const { return size == 0; }
+	bool equals(const char* text) const
+	{
+		const size_t length = strlen(text);
+		return length == size_t(size) && !memcmp(data, text, length);
+	}
+};
+
+enum JsonKind
+{
+	JK_NULL,
+	JK_BOOL,
+	JK_NUMBER,
+	JK_STRING,
+	JK_OBJECT,
+	JK_ARRAY
+};
+
+struct JsonMember
+{
+	JsonText key;
+	//string:decoded,number,true,false,null:the literal,object and array:raw text with the brackets
+	JsonText value;
+	JsonKind kind = JK_NULL;
+
+	/*
+	Integral part of a number,fallback for any other kind
+	*/
+	int64_t toInt(int64_t fallback = 0) const;
+	bool toBool(bool fallback = false) const;
+};
+
+/*
+Fixed storage of one message,members grow from the front and decoded strings from the back
+*/
+class JsonArena
+{
+public:
+	static const int CAPACITY = 16 * 1024;//a MAX_DATA_LENGTH message of one byte members fits
+
+	void reset() { m_front = 0; m_back = CAPACITY; }
+	//nullptr when full
+	JsonMember* allocateMember();
+	char* allocateText(int size);
+	int used() const { return m_front + CAPACITY - m_back; }
+private:
+	alignas(JsonMember) char m_storage[CAPACITY];
+	int m_front = 0;
+	int m_back = CAPACITY;
+};
+
+/*
+Members of one object in document order,they live in the arena and the parsed text
+*/
+struct JsonObjectView
+{
+	const JsonMember* members = nullptr;
+	int count = 0;
+
+	//first member named key,nullptr when there is none
+	const JsonMember* find(const char* key) const;
+	int64_t toInt(const char* key, int64_t fallback = 0) const;
+	//string member,empty when missing or of another kind
+	JsonText text(const char* key) const;
+};
+
+/*
+text:one json object and optional white space,not modified
+Nested objects and arrays are validated but not parsed,pass their raw text to parseJsonObject again.
+Returns false when text is not valid json,not an object,or the arena is full
+*/
+bool parseJsonObject(const char* text, int size, JsonArena& arena, JsonObjectView* object);
+
+struct Notification
+{
+	JsonText type;
+	JsonText key;//native key of the shared memory
+	JsonText name;//cam0 or cam1 for video
+	int64_t offset = 0;
+	JsonText props;//raw object text,as emitted with sharedMemoryMsg
+	//props of MT_VIDEO_DATA
+	int rotate = 0;
+	int width = 0;
+	int height = 0;
+	int channel = 0;
+	JsonText pixelFormat;//empty for the 8-bit frames described by channel
+	int windowLow = 0;//16-bit levels shown black and white,0 for the whole range
+	int windowHigh = 0;
+};
+
+/*
+Reads the fields DataProcesser::processData uses,props are only parsed for MT_VIDEO_DATA
+*/
+bool parseNotification(const char* text, int size, JsonArena& arena, Notification* notification);
+
+#endif // NOTIFICATION_H
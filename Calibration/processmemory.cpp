@@ -0,0 +1,41 @@
+#include "processmemory.h"
+#if defined(Q_OS_LINUX)
+#include <malloc.h>
+#include <unistd.h>
+#include <cstdio>
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+ProcessMemory sampleProcessMemory()
+{
+	ProcessMemory memory;
+#if defined(Q_OS_LINUX)
+	//second field of statm is the resident page count
+	if (FILE* statm = fopen("/proc/self/statm", "r")){
+		long size = 0, resident = 0;
+		if (fscanf(statm, "%ld %ld", &size, &resident) == 2)
+			memory.rssBytes = qint64(resident) * sysconf(_SC_PAGESIZE);
+		fclose(statm);
+	}
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+	const struct mallinfo2 info = mallinfo2();
+#elif defined(__GLIBC__)
+	//int fields,wrap above 2 GB
+	const struct mallinfo info = mallinfo();
+#endif
+#if defined(__GLIBC__)
+	memory.heapInUseBytes = qint64(info.uordblks) + qint64(info.hblkhd);
+	memory.heapTotalBytes = qint64(info.arena) + qint64(info.hblkhd);
+#endif
+#elif defined(Q_OS_WIN)
+	PROCESS_MEMORY_COUNTERS_EX counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters), sizeof(counters))){
+		memory.rssBytes = qint64(counters.WorkingSetSize);
+		memory.heapInUseBytes = qint64(counters.PrivateUsage);
+		memory.heapTotalBytes = qint64(counters.PagefileUsage);
+	}
+#endif
+	return memory;
+}
@@ -0,0 +1,17 @@
+#ifndef PROCESS_MEMORY_H
+#define PROCESS_MEMORY_H
+
+#include <QtGlobal>
+/*
+Memory of this process as the operating system and the C heap see it,-1 where the platform does not tell
+*/
+struct ProcessMemory
+{
+	qint64 rssBytes = -1;//resident set,working set on Windows
+	qint64 heapInUseBytes = -1;//allocated by malloc/new and not freed,private bytes on Windows
+	qint64 heapTotalBytes = -1;//obtained from the system by the allocator,free blocks included
+};
+
+ProcessMemory sampleProcessMemory();
+
+#endif // PROCESS_MEMORY_H
@@ -0,0 +1,9 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+/*
+Limits of the SDK ZMQ protocol shared by the GUI,the worker threads and the headless runner
+*/
+#define MAX_ENVELOPE_LENGTH 255
+#define MAX_DATA_LENGTH 1000
+
+#endif // PROTOCOL_H
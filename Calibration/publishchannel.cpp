@@ -0,0 +1,140 @@
+#include "publishchannel.h"
+#include <QThread>
+
+namespace
+{
+	//deliver at most this many per wake-up so input events are not starved
+	const int MAX_BATCH = 256;
+}
+
+PublishChannel::PublishChannel(size_t capacity, QObject *parent)
+	: QObject(parent), m_queue(capacity)
+{
+	setDeviceName(QString());
+}
+
+PublishChannel::~PublishChannel()
+{
+	PublishMessage message;
+	while (m_queue.pop(message))
+		;
+	for (auto box : m_latest){
+		delete box->exchange(nullptr);
+		delete box;
+	}
+}
+
+void PublishChannel::setPolicy(const QString& topic, OverflowPolicy policy)
+{
+	m_policies.insert(topic, policy);
+	if (policy == OP_LATEST && !m_latest.contains(topic))
+		m_latest.insert(topic, new std::atomic<PublishMessage*>(nullptr));
+}
+
+void PublishChannel::setDeviceName(const QString& name)
+{
+	auto& registry = MetricsRegistry::instance();
+	const auto labels = QString("device=\"%1\"").arg(name);
+	m_depthMetric = registry.gauge("calib_publish_queue_depth", "Publishes waiting for the GUI thread", labels);
+	m_droppedMetric = registry.counter("calib_publish_dropped_total", "Publishes dropped because the GUI fell behind", labels);
+	m_coalescedMetric = registry.counter("calib_publish_coalesced_total", "Publishes replaced by a newer one of the same topic", labels);
+	m_batchesMetric = registry.counter("calib_publish_batches_total", "GUI wake-ups draining the publish queue", labels);
+}
+
+OverflowPolicy PublishChannel::policy(const PublishMessage& message) const
+{
+	auto it = m_policies.constFind(message.majorCmd + '/' + message.minorCmd);
+	if (it == m_policies.constEnd())
+		it = m_policies.constFind(message.majorCmd);
+	return it == m_policies.constEnd() ? m_defaultPolicy : it.value();
+}
+
+std::atomic<PublishMessage*>* PublishChannel::latestBox(const PublishMessage& message) const
+{
+	if (m_latest.isEmpty())
+		return nullptr;
+	auto box = m_latest.value(message.majorCmd + '/' + message.minorCmd);
+	return box ? box : m_latest.value(message.majorCmd);
+}
+
+void PublishChannel::push(PublishMessage& message)
+{
+	auto box = latestBox(message);
+	if (m_queue.push(message)){
+		//a coalesced message still waiting is now older than the queued one
+		if (box)
+			delete box->exchange(nullptr, std::memory_order_acq_rel);
+		wake();
+		return;
+	}
+
+	switch (policy(message)){
+	case OP_BLOCK:
+		while (!m_queue.push(message)){
+			if (m_closed.load(std::memory_order_acquire))
+				return;
+			wake();
+			QThread::usleep(100);
+		}
+		break;
+	case OP_LATEST:
+		if (!box){
+			m_droppedMetric->inc();
+			break;
+		}
+		delete box->exchange(new PublishMessage(std::move(message)), std::memory_order_acq_rel);
+		m_coalescedMetric->inc();
+		break;
+	case OP_DROP:
+		m_droppedMetric->inc();
+		break;
+	}
+	wake();
+}
+
+void PublishChannel::pushHeartbeat()
+{
+	m_heartbeatPending.store(true, std::memory_order_release);
+	wake();
+}
+
+void PublishChannel::wake()
+{
+	if (!m_wakePending.exchange(true, std::memory_order_acq_rel))
+		QMetaObject::invokeMethod(this, "drain", Qt::QueuedConnection);
+}
+
+void PublishChannel::deliver(const PublishMessage& message)
+{
+	emit publishReceived(message.majorCmd, message.minorCmd, message.data);
+}
+
+void PublishChannel::drain()
+{
+	//clear before popping,a push racing with us posts a new wake-up
+	m_wakePending.exchange(false, std::memory_order_acq_rel);
+	m_batchesMetric->inc();
+	m_depthMetric->set(qint64(m_queue.size()));
+
+	if (m_heartbeatPending.exchange(false, std::memory_order_acq_rel))
+		emit heartbeat();
+
+	PublishMessage message;
+	int delivered = 0;
+	while (delivered < MAX_BATCH && m_queue.pop(message)){
+		deliver(message);
+		delivered++;
+	}
+	if (delivered == MAX_BATCH){
+		wake();
+		return;
+	}
+	//coalesced messages are newer than anything of their topic that was queued
+	const auto& boxes = m_latest;
+	for (auto box : boxes){
+		if (auto latest = box->exchange(nullptr, std::memory_order_acq_rel)){
+			deliver(*latest);
+			delete latest;
+		}
+	}
+}
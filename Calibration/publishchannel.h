@@ -0,0 +1,91 @@
+#ifndef PUBLISH_CHANNEL_H
+#define PUBLISH_CHANNEL_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <atomic>
+#include "spscqueue.h"
+#include "metrics.h"
+/*
+One SDK publish,parsed by the Subscriber thread
+*/
+struct PublishMessage
+{
+	QString majorCmd;
+	QString minorCmd;
+	QByteArray data;
+};
+
+/*
+What the producer does when the queue is full
+*/
+enum OverflowPolicy
+{
+	OP_BLOCK,//wait for the GUI,used for messages that drive the calibration flow
+	OP_LATEST,//keep only the newest message of the topic until the queue has room
+	OP_DROP//discard the message
+};
+
+/*
+Subscriber -> GUI thread handoff through a lock-free SPSC ring.
+The producer posts one wake-up per batch instead of one queued metacall per message,
+the GUI drains everything pending and emits the signals directly.
+*/
+class PublishChannel : public QObject
+{
+	Q_OBJECT
+public:
+	explicit PublishChannel(size_t capacity = 1024, QObject *parent = nullptr);
+	~PublishChannel();
+
+	/*
+	topic:majorCmd or majorCmd/minorCmd,the more specific one wins
+	Set up before the producer starts
+	*/
+	void setPolicy(const QString& topic, OverflowPolicy policy);
+	void setDefaultPolicy(OverflowPolicy policy) { m_defaultPolicy = policy; }
+	void setDeviceName(const QString& name);
+	/*
+	Producer side(Subscriber thread)
+	*/
+	void push(PublishMessage& message);
+	void pushHeartbeat();
+	/*
+	Release a producer blocked on a full queue,called before joining the Subscriber thread
+	*/
+	void close() { m_closed.store(true, std::memory_order_release); }
+
+	size_t depth() const { return m_queue.size(); }
+	size_t capacity() const { return m_queue.capacity(); }
+signals:
+	void heartbeat();
+	void publishReceived(QString majorCmd, QString minorCmd, QByteArray data);
+public slots:
+	/*
+	Consumer side(GUI thread),called by the wake-up
+	*/
+	void drain();
+private:
+	OverflowPolicy policy(const PublishMessage& message) const;
+	std::atomic<PublishMessage*>* latestBox(const PublishMessage& message) const;
+	void wake();
+	void deliver(const PublishMessage& message);
+
+	SpscQueue<PublishMessage> m_queue;
+	QHash<QString, OverflowPolicy> m_policies;
+	OverflowPolicy m_defaultPolicy = OP_BLOCK;
+	//newest message per OP_LATEST topic that did not fit,exchanged lock-free
+	QHash<QString, std::atomic<PublishMessage*>*> m_latest;
+	std::atomic<bool> m_heartbeatPending{ false };
+	std::atomic<bool> m_wakePending{ false };
+	std::atomic<bool> m_closed{ false };
+
+	MetricGauge* m_depthMetric = nullptr;
+	MetricCounter* m_droppedMetric = nullptr;
+	MetricCounter* m_coalescedMetric = nullptr;
+	MetricCounter* m_batchesMetric = nullptr;
+};
+
+#endif // PUBLISH_CHANNEL_H
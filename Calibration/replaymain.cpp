@@ -0,0 +1,58 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QThread>
+#include <QtDebug>
+#include <zmq.h>
+#include "streamreplayer.h"
+/*
+Calibration-Replay:re-publish a recorded SDK stream to the client.
+Record with Calibration-Demo --record <file>,stop the SDK and replay the file in its place.
+*/
+int main(int argc, char *argv[])
+{
+	QCoreApplication a(argc, argv);
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Replay a recorded SDK publish stream");
+	parser.addHelpOption();
+	parser.addPositionalArgument("log", "Stream log recorded by the client");
+	QCommandLineOption bindOption("bind", "PUB bind address", "addr", "tcp://*:11398");
+	QCommandLineOption maxRateOption("max-rate", "Ignore recorded timing and publish as fast as possible");
+	QCommandLineOption loopOption("loop", "Replay the log <n> times", "n", "1");
+	QCommandLineOption warmupOption("warmup", "Wait <ms> for subscribers to connect", "ms", "1000");
+	parser.addOption(bindOption);
+	parser.addOption(maxRateOption);
+	parser.addOption(loopOption);
+	parser.addOption(warmupOption);
+	parser.process(a);
+
+	if (parser.positionalArguments().size() != 1)
+		parser.showHelp(1);
+
+	void* context = zmq_ctx_new();
+	int result = 0;
+	{
+		StreamReplayer replayer(context);
+		if (!replayer.bind(parser.value(bindOption))){
+			result = 1;
+		}
+		else{
+			QThread::msleep(parser.value(warmupOption).toULong());
+			const int loops = qMax(1, parser.value(loopOption).toInt());
+			for (int i = 0; i < loops && result == 0; i++){
+				StreamReplayer::Stats stats;
+				if (!replayer.replay(parser.positionalArguments().front(), parser.isSet(maxRateOption), stats)){
+					result = 1;
+					break;
+				}
+				const double seconds = stats.elapsedNs / 1e9;
+				qInfo().noquote() << QString("pass %1: %2 messages, %3 bytes in %4 s (%5 msg/s), max late %6 us")
+					.arg(i + 1).arg(stats.messages).arg(stats.bytes).arg(seconds, 0, 'f', 3)
+					.arg(seconds > 0 ? stats.messages / seconds : 0.0, 0, 'f', 0)
+					.arg(stats.maxLateNs / 1000);
+			}
+		}
+	}
+	zmq_ctx_destroy(context);
+	return result;
+}
@@ -0,0 +1,42 @@
+#include "sdkmessage.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <cstring>
+
+bool splitEnvelope(const char* envelop, int size, const char* version, QString* majorCmd, QString* minorCmd)
+{
+	//a zero ends the envelop like it ended the QString it was read into
+	auto terminator = static_cast<const char*>(memchr(envelop, 0, size));
+	if (terminator)
+		size = int(terminator - envelop);
+	const int versionSize = int(strlen(version));
+	if (size <= versionSize || memcmp(envelop, version, versionSize) || envelop[versionSize] != '/')
+		return false;
+	auto major = envelop + versionSize + 1;
+	auto end = envelop + size;
+	auto slash = static_cast<const char*>(memchr(major, '/', end - major));
+	auto majorEnd = slash ? slash : end;
+	if (majorEnd == major)
+		return false;
+	*majorCmd = QString::fromUtf8(major, int(majorEnd - major));
+	if (!slash){
+		minorCmd->clear();
+		return true;
+	}
+	//further levels are not part of the minor command
+	auto minor = slash + 1;
+	auto minorEnd = static_cast<const char*>(memchr(minor, '/', end - minor));
+	*minorCmd = QString::fromUtf8(minor, int((minorEnd ? minorEnd : end) - minor));
+	return true;
+}
+
+QVector<bool> distanceStates(const QByteArray& data)
+{
+	QVector<bool> done;
+	const auto states = QJsonDocument::fromJson(data).object()["states"].toArray();
+	done.reserve(states.count());
+	for (const auto& state : states)
+		done.append(state.toBool());
+	return done;
+}
@@ -0,0 +1,24 @@
+#ifndef SDK_MESSAGE_H
+#define SDK_MESSAGE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+/*
+Parsing of the SDK publish messages shared by the GUI,the headless sequencer and the benchmark
+*/
+
+/*
+envelop:version/majorCmd[/minorCmd] as received,size bytes,need not be zero terminated
+version:the only version accepted,e.g. v1.0
+Returns false when the version differs or there is no major command
+*/
+bool splitEnvelope(const char* envelop, int size, const char* version, QString* majorCmd, QString* minorCmd);
+
+/*
+data:cali/caliDistStates payload,{"states":[true,false,...]}
+Returns one flag per calibration distance,empty when the payload is not understood
+*/
+QVector<bool> distanceStates(const QByteArray& data);
+
+#endif // SDK_MESSAGE_H
@@ -0,0 +1,382 @@
+#include "sessionlog.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QSet>
+#include <QtEndian>
+#include <QtDebug>
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	const char LOG_MAGIC[8] = { 'S', 'N', 'C', 'A', 'L', 'L', 'O', 'G' };
+	const quint32 LOG_VERSION = 1;
+	const int HEADER_SIZE = sizeof(LOG_MAGIC) + 4;
+	const int RECORD_HEADER_SIZE = 1 + 4 + 8 + 4;
+	const char TRAILER_MAGIC[4] = { 'S', 'N', 'I', 'X' };
+	const int TRAILER_PAYLOAD_SIZE = 8 + sizeof(TRAILER_MAGIC);
+	const int TRAILER_SIZE = RECORD_HEADER_SIZE + TRAILER_PAYLOAD_SIZE;
+	//a record larger than this is garbage from a torn write
+	const quint32 MAX_PAYLOAD = 16 * 1024 * 1024;
+
+	void applyRecord(SessionIndexEntry& entry, const SessionRecord& record)
+	{
+		entry.events++;
+		entry.end = record.time;
+		switch (record.kind){
+		case SK_SUB_TYPE: entry.subType = QString::fromUtf8(record.payload); break;
+		case SK_CALI_TYPE: entry.caliType = QString::fromUtf8(record.payload); break;
+		case SK_TIME: entry.caliTime = QString::fromUtf8(record.payload); break;
+		case SK_END: entry.outcome = record.payload.isEmpty() ? SO_OPEN : SessionOutcome(quint8(record.payload[0])); break;
+		default: break;
+		}
+	}
+
+	QByteArray encodeEntries(quint64 previous, bool full, const QVector<SessionIndexEntry>& entries)
+	{
+		QByteArray payload;
+		QDataStream stream(&payload, QIODevice::WriteOnly);
+		stream.setByteOrder(QDataStream::LittleEndian);
+		stream << previous << quint8(full ? 1 : 0) << quint32(entries.size());
+		for (const auto& entry : entries){
+			stream << entry.session << entry.offset << entry.begin << entry.end << quint8(entry.outcome) << entry.events
+				<< entry.device.toUtf8() << entry.subType.toUtf8() << entry.caliType.toUtf8() << entry.caliTime.toUtf8();
+		}
+		return payload;
+	}
+
+	bool decodeEntries(const QByteArray& payload, quint64& previous, bool& full, QVector<SessionIndexEntry>& entries)
+	{
+		QDataStream stream(payload);
+		stream.setByteOrder(QDataStream::LittleEndian);
+		quint8 fullFlag = 0;
+		quint32 count = 0;
+		stream >> previous >> fullFlag >> count;
+		full = fullFlag != 0;
+		for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++){
+			SessionIndexEntry entry;
+			quint8 outcome = 0;
+			QByteArray device, subType, caliType, caliTime;
+			stream >> entry.session >> entry.offset >> entry.begin >> entry.end >> outcome >> entry.events
+				>> device >> subType >> caliType >> caliTime;
+			entry.outcome = SessionOutcome(outcome);
+			entry.device = QString::fromUtf8(device);
+			entry.subType = QString::fromUtf8(subType);
+			entry.caliType = QString::fromUtf8(caliType);
+			entry.caliTime = QString::fromUtf8(caliTime);
+			entries << entry;
+		}
+		return stream.status() == QDataStream::Ok;
+	}
+
+	void sortByOffset(QVector<SessionIndexEntry>& entries)
+	{
+		std::sort(entries.begin(), entries.end(), [](const SessionIndexEntry& a, const SessionIndexEntry& b){
+			return a.offset < b.offset;
+		});
+	}
+}
+
+SessionLogWriter::~SessionLogWriter()
+{
+	close();
+}
+
+bool SessionLogWriter::open(const QString& path)
+{
+	close();
+	m_entries.clear();
+	m_active.clear();
+	m_indexed = 0;
+	m_lastIndex = 0;
+	m_nextSession = 1;
+
+	bool rebuilt = false;
+	quint64 validEnd = HEADER_SIZE;
+	if (QFileInfo(path).size() > 0){
+		SessionLogReader reader;
+		if (!reader.open(path))
+			return false;
+		//new index records chain to the one the file ends with
+		if (reader.readIndex(m_entries, &m_lastIndex)){
+			m_indexed = m_entries.size();
+		}
+		else{
+			qWarning() << "session log has no index,recovering:" << path;
+			if (!reader.scan(m_entries, &validEnd))
+				return false;
+			rebuilt = true;
+		}
+		reader.close();
+	}
+
+	m_file.setFileName(path);
+	if (!m_file.open(QIODevice::ReadWrite)){
+		qWarning() << "cannot open session log:" << path << m_file.errorString();
+		return false;
+	}
+	if (m_file.size() == 0){
+		uchar version[4];
+		qToLittleEndian(LOG_VERSION, version);
+		m_file.write(LOG_MAGIC, sizeof(LOG_MAGIC));
+		m_file.write(reinterpret_cast<const char*>(version), sizeof(version));
+	}
+	else if (rebuilt){
+		//drop a record torn by the crash,appending behind it would hide everything after
+		m_file.resize(qint64(validEnd));
+	}
+	m_file.seek(m_file.size());
+	for (const auto& entry : m_entries)
+		m_nextSession = qMax(m_nextSession, entry.session + 1);
+	if (rebuilt)
+		writeIndex(true);
+	return true;
+}
+
+void SessionLogWriter::close()
+{
+	if (!m_file.isOpen())
+		return;
+	const qint64 now = QDateTime::currentMSecsSinceEpoch();
+	for (auto it = m_active.begin(); it != m_active.end(); ++it){
+		SessionRecord record;
+		record.kind = SK_END;
+		record.session = it.key();
+		record.time = now;
+		record.payload = QByteArray(1, char(SO_ABORTED));
+		writeRecord(record.kind, record.session, record.time, record.payload);
+		applyRecord(it.value(), record);
+		m_entries << it.value();
+	}
+	m_active.clear();
+	if (m_entries.size() != m_indexed)
+		writeIndex(true);
+	m_file.close();
+}
+
+quint32 SessionLogWriter::beginSession(const QString& device, const QString& subType)
+{
+	if (!m_file.isOpen())
+		return 0;
+	SessionIndexEntry entry;
+	entry.session = m_nextSession++;
+	entry.offset = quint64(m_file.pos());
+	entry.begin = QDateTime::currentMSecsSinceEpoch();
+	entry.end = entry.begin;
+	entry.device = device;
+	entry.events = 1;
+	if (!writeRecord(SK_BEGIN, entry.session, entry.begin, device.toUtf8()))
+		return 0;
+	m_active.insert(entry.session, entry);
+	if (!subType.isEmpty())
+		append(entry.session, SK_SUB_TYPE, subType.toUtf8());
+	return entry.session;
+}
+
+void SessionLogWriter::append(quint32 session, SessionRecordKind kind, const QByteArray& payload)
+{
+	auto it = m_active.find(session);
+	if (it == m_active.end() || kind == SK_BEGIN || kind >= SK_END)
+		return;
+	SessionRecord record;
+	record.kind = kind;
+	record.session = session;
+	record.time = QDateTime::currentMSecsSinceEpoch();
+	record.payload = payload;
+	if (writeRecord(kind, session, record.time, payload))
+		applyRecord(it.value(), record);
+}
+
+void SessionLogWriter::endSession(quint32 session, SessionOutcome outcome)
+{
+	auto it = m_active.find(session);
+	if (it == m_active.end())
+		return;
+	SessionRecord record;
+	record.kind = SK_END;
+	record.session = session;
+	record.time = QDateTime::currentMSecsSinceEpoch();
+	record.payload = QByteArray(1, char(outcome));
+	writeRecord(SK_END, session, record.time, record.payload);
+	applyRecord(it.value(), record);
+	m_entries << it.value();
+	m_active.erase(it);
+	writeIndex(false);
+}
+
+bool SessionLogWriter::writeRecord(SessionRecordKind kind, quint32 session, qint64 time, const QByteArray& payload)
+{
+	uchar header[RECORD_HEADER_SIZE];
+	header[0] = uchar(kind);
+	qToLittleEndian<quint32>(session, header + 1);
+	qToLittleEndian<qint64>(time, header + 5);
+	qToLittleEndian<quint32>(quint32(payload.size()), header + 13);
+	QByteArray bytes(reinterpret_cast<const char*>(header), RECORD_HEADER_SIZE);
+	bytes.append(payload);
+	//sessions are short and rare,every record goes to disk so a crash loses nothing
+	if (m_file.write(bytes) != bytes.size() || !m_file.flush()){
+		qWarning() << "session log write error:" << m_file.errorString();
+		return false;
+	}
+	return true;
+}
+
+void SessionLogWriter::writeIndex(bool full)
+{
+	//open sessions are listed too so a reader still finds them if we die,a newer index overrides them
+	QVector<SessionIndexEntry> entries = full ? m_entries : m_entries.mid(m_indexed);
+	for (const auto& entry : m_active)
+		entries << entry;
+	const quint64 offset = quint64(m_file.pos());
+	if (!writeRecord(SK_INDEX, 0, QDateTime::currentMSecsSinceEpoch(), encodeEntries(full ? 0 : m_lastIndex, full, entries)))
+		return;
+	QByteArray trailer(TRAILER_PAYLOAD_SIZE, 0);
+	qToLittleEndian<quint64>(offset, reinterpret_cast<uchar*>(trailer.data()));
+	memcpy(trailer.data() + 8, TRAILER_MAGIC, sizeof(TRAILER_MAGIC));
+	if (!writeRecord(SK_TRAILER, 0, QDateTime::currentMSecsSinceEpoch(), trailer))
+		return;
+	m_lastIndex = offset;
+	m_indexed = m_entries.size();
+}
+
+bool SessionLogReader::open(const QString& path)
+{
+	m_file.setFileName(path);
+	if (!m_file.open(QIODevice::ReadOnly)){
+		qWarning() << "cannot open session log:" << path << m_file.errorString();
+		return false;
+	}
+	char magic[sizeof(LOG_MAGIC)];
+	uchar version[4];
+	if (m_file.read(magic, sizeof(magic)) != sizeof(magic)
+		|| memcmp(magic, LOG_MAGIC, sizeof(magic)) != 0
+		|| m_file.read(reinterpret_cast<char*>(version), sizeof(version)) != sizeof(version)
+		|| qFromLittleEndian<quint32>(version) != LOG_VERSION){
+		qWarning() << "not a session log:" << path;
+		m_file.close();
+		return false;
+	}
+	return true;
+}
+
+bool SessionLogReader::next(SessionRecord& record)
+{
+	uchar header[RECORD_HEADER_SIZE];
+	if (m_file.read(reinterpret_cast<char*>(header), RECORD_HEADER_SIZE) != RECORD_HEADER_SIZE)
+		return false;
+	if (header[0] < SK_BEGIN || header[0] > SK_TRAILER)
+		return false;
+	record.kind = SessionRecordKind(header[0]);
+	record.session = qFromLittleEndian<quint32>(header + 1);
+	record.time = qFromLittleEndian<qint64>(header + 5);
+	const quint32 size = qFromLittleEndian<quint32>(header + 13);
+	if (size > MAX_PAYLOAD)
+		return false;
+	record.payload = m_file.read(size);
+	return record.payload.size() == int(size);
+}
+
+bool SessionLogReader::readIndex(QVector<SessionIndexEntry>& entries, quint64* indexOffset)
+{
+	entries.clear();
+	if (m_file.size() < HEADER_SIZE + TRAILER_SIZE)
+		return false;
+	SessionRecord record;
+	if (!m_file.seek(m_file.size() - TRAILER_SIZE) || !next(record) || record.kind != SK_TRAILER
+		|| record.payload.size() != TRAILER_PAYLOAD_SIZE
+		|| memcmp(record.payload.constData() + 8, TRAILER_MAGIC, sizeof(TRAILER_MAGIC)) != 0)
+		return false;
+
+	QSet<quint32> seen;
+	quint64 offset = qFromLittleEndian<quint64>(reinterpret_cast<const uchar*>(record.payload.constData()));
+	if (indexOffset)
+		*indexOffset = offset;
+	//newest index first,an entry seen there overrides the same session in older ones
+	while (offset){
+		if (offset < quint64(HEADER_SIZE) || offset >= quint64(m_file.size()) || !m_file.seek(qint64(offset))
+			|| !next(record) || record.kind != SK_INDEX)
+			return false;
+		quint64 previous = 0;
+		bool full = false;
+		QVector<SessionIndexEntry> block;
+		if (!decodeEntries(record.payload, previous, full, block))
+			return false;
+		for (const auto& entry : block){
+			if (!seen.contains(entry.session)){
+				seen.insert(entry.session);
+				entries << entry;
+			}
+		}
+		if (full)
+			break;
+		offset = previous;
+	}
+	sortByOffset(entries);
+	return true;
+}
+
+bool SessionLogReader::scan(QVector<SessionIndexEntry>& entries, quint64* validEnd)
+{
+	entries.clear();
+	if (!m_file.seek(HEADER_SIZE))
+		return false;
+	QHash<quint32, SessionIndexEntry> active;
+	SessionRecord record;
+	qint64 offset = m_file.pos();
+	while (next(record)){
+		if (record.kind == SK_BEGIN){
+			SessionIndexEntry entry;
+			entry.session = record.session;
+			entry.offset = quint64(offset);
+			entry.begin = record.time;
+			entry.device = QString::fromUtf8(record.payload);
+			applyRecord(entry, record);
+			active.insert(record.session, entry);
+		}
+		else if (record.kind != SK_INDEX && record.kind != SK_TRAILER){
+			auto it = active.find(record.session);
+			if (it != active.end()){
+				applyRecord(it.value(), record);
+				if (record.kind == SK_END){
+					entries << it.value();
+					active.erase(it);
+				}
+			}
+		}
+		offset = m_file.pos();
+	}
+	for (const auto& entry : active)
+		entries << entry;
+	sortByOffset(entries);
+	if (validEnd)
+		*validEnd = quint64(offset);
+	return true;
+}
+
+bool SessionLogReader::readSession(const SessionIndexEntry& entry, QVector<SessionRecord>& records)
+{
+	records.clear();
+	if (!m_file.seek(qint64(entry.offset)))
+		return false;
+	SessionRecord record;
+	while (next(record)){
+		if (record.session != entry.session || record.kind == SK_INDEX || record.kind == SK_TRAILER)
+			continue;
+		records << record;
+		if (record.kind == SK_END)
+			break;
+	}
+	return !records.isEmpty() && records.front().kind == SK_BEGIN;
+}
+
+const char* SessionLogReader::outcomeName(SessionOutcome outcome)
+{
+	switch (outcome){
+	case SO_OPEN: return "open";
+	case SO_COMPLETED: return "completed";
+	case SO_ABORTED: return "aborted";
+	case SO_FAILED: return "failed";
+	default: return "unknown";
+	}
+}
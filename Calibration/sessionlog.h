@@ -0,0 +1,127 @@
+#ifndef SESSION_LOG_H
+#define SESSION_LOG_H
+
+#include <QFile>
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+/*
+Append-only binary log of calibration sessions,one file can hold the sessions of many runs.
+Layout(little-endian):
+	header: "SNCALLOG" + quint32 version
+	record: quint8 kind, quint32 session, qint64 time(ms since epoch,UTC), quint32 size, payload
+Sessions may interleave.An SK_INDEX record lists the sessions written so far and is followed by an
+SK_TRAILER record pointing at it,so the trailer is always the last 29 bytes of a cleanly written file.
+A writer appends an index after every finished session(only the new entries,chained to the previous index)
+and a full index on close.A file cut short by a crash is recovered by scanning the records.
+*/
+enum SessionRecordKind
+{
+	SK_BEGIN = 1,//payload:device name
+	SK_SUB_TYPE,//DST_PRO or DST_PRO_PLUS
+	SK_CALI_TYPE,//CT_STEREO...
+	SK_TIME,//cali/time
+	SK_GROUP,//cali/currentCaliGroup,raw int
+	SK_DIST,//cali/currentCaliDist,raw int
+	SK_DIST_STATES,//cali/caliDistStates json
+	SK_ASYNC_RESULT,//finishAsyncAction json
+	SK_END,//payload:one SessionOutcome byte
+	SK_INDEX,
+	SK_TRAILER
+};
+
+enum SessionOutcome
+{
+	SO_OPEN = 0,//no SK_END,the client died during the session
+	SO_COMPLETED,//every distance was snapped
+	SO_ABORTED,//left before all distances were done
+	SO_FAILED//the SDK rejected a step or it timed out
+};
+
+struct SessionRecord
+{
+	SessionRecordKind kind = SK_BEGIN;
+	quint32 session = 0;
+	qint64 time = 0;
+	QByteArray payload;
+};
+
+/*
+One session in the footer index,enough to filter and aggregate without reading the records
+*/
+struct SessionIndexEntry
+{
+	quint32 session = 0;
+	quint64 offset = 0;//SK_BEGIN record
+	qint64 begin = 0;
+	qint64 end = 0;
+	SessionOutcome outcome = SO_OPEN;
+	quint32 events = 0;
+	QString device;
+	QString subType;
+	QString caliType;
+	QString caliTime;//last cali/time the SDK published
+};
+
+class SessionLogWriter
+{
+public:
+	~SessionLogWriter();
+	/*
+	path:log file,created if missing,new sessions are appended to an existing log
+	*/
+	bool open(const QString& path);
+	/*
+	Ends open sessions as SO_ABORTED and writes the full index
+	*/
+	void close();
+	bool isOpen() const { return m_file.isOpen(); }
+	/*
+	Returns the session id,0 if the log is not open
+	*/
+	quint32 beginSession(const QString& device, const QString& subType = QString());
+	/*
+	kind:SK_SUB_TYPE..SK_ASYNC_RESULT,types and cali/time also update the index entry
+	*/
+	void append(quint32 session, SessionRecordKind kind, const QByteArray& payload);
+	void endSession(quint32 session, SessionOutcome outcome);
+	bool isActive(quint32 session) const { return m_active.contains(session); }
+private:
+	bool writeRecord(SessionRecordKind kind, quint32 session, qint64 time, const QByteArray& payload);
+	void writeIndex(bool full);
+
+	QFile m_file;
+	QVector<SessionIndexEntry> m_entries;//finished sessions
+	QHash<quint32, SessionIndexEntry> m_active;
+	int m_indexed = 0;//entries already in an index record
+	quint64 m_lastIndex = 0;
+	quint32 m_nextSession = 1;
+};
+
+class SessionLogReader
+{
+public:
+	bool open(const QString& path);
+	void close() { m_file.close(); }
+	/*
+	Sessions from the footer index,false when the log has no trailer(use scan)
+	indexOffset:newest SK_INDEX record
+	*/
+	bool readIndex(QVector<SessionIndexEntry>& entries, quint64* indexOffset = nullptr);
+	/*
+	Rebuild the index from every record,validEnd:end of the last complete record
+	*/
+	bool scan(QVector<SessionIndexEntry>& entries, quint64* validEnd = nullptr);
+	/*
+	Records of one session in file order
+	*/
+	bool readSession(const SessionIndexEntry& entry, QVector<SessionRecord>& records);
+	static const char* outcomeName(SessionOutcome outcome);
+private:
+	bool next(SessionRecord& record);
+
+	QFile m_file;
+};
+
+#endif // SESSION_LOG_H
@@ -0,0 +1,246 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMap>
+#include <QStringList>
+#include <QThread>
+#include <QtDebug>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "sessionlog.h"
+/*
+Calibration-Sessions:query calibration session logs written with --session-log.
+Every log is read by its footer index on a pool of threads,only --events reads the records.
+*/
+namespace
+{
+	struct Filter
+	{
+		QStringList devices;
+		QString caliType;
+		QString outcome;
+		qint64 since = 0;
+		qint64 until = 0;
+	};
+
+	struct Aggregate
+	{
+		int sessions = 0;
+		int outcomes[SO_FAILED + 1] = {};
+		qint64 totalMs = 0;
+		qint64 maxMs = 0;
+		qint64 last = 0;
+		QString lastCaliTime;
+	};
+
+	//one per log,merged in file order so the output does not depend on the thread count
+	struct FileResult
+	{
+		bool ok = false;
+		bool recovered = false;
+		int sessions = 0;
+		QMap<QString, Aggregate> aggregates;//"device caliType"
+		QStringList lines;
+	};
+
+	bool matches(const Filter& filter, const SessionIndexEntry& entry)
+	{
+		if (!filter.devices.isEmpty() && !filter.devices.contains(entry.device))
+			return false;
+		if (!filter.caliType.isEmpty() && entry.caliType != filter.caliType)
+			return false;
+		if (!filter.outcome.isEmpty() && filter.outcome != SessionLogReader::outcomeName(entry.outcome))
+			return false;
+		if (filter.since && entry.begin < filter.since)
+			return false;
+		if (filter.until && entry.begin >= filter.until)
+			return false;
+		return true;
+	}
+
+	QString formatTime(qint64 msecs)
+	{
+		return QDateTime::fromMSecsSinceEpoch(msecs).toString(Qt::ISODate);
+	}
+
+	void processFile(const QString& path, const Filter& filter, bool rescan, bool list, bool events, FileResult& result)
+	{
+		SessionLogReader reader;
+		if (!reader.open(path))
+			return;
+		QVector<SessionIndexEntry> entries;
+		if (rescan || !reader.readIndex(entries)){
+			result.recovered = !rescan;
+			if (!reader.scan(entries))
+				return;
+		}
+		result.ok = true;
+		QVector<SessionRecord> records;
+		for (const auto& entry : entries){
+			if (!matches(filter, entry))
+				continue;
+			result.sessions++;
+			auto& aggregate = result.aggregates[entry.device + ' ' + (entry.caliType.isEmpty() ? QStringLiteral("-") : entry.caliType)];
+			const qint64 durationMs = entry.end - entry.begin;
+			aggregate.sessions++;
+			if (entry.outcome <= SO_FAILED)
+				aggregate.outcomes[entry.outcome]++;
+			aggregate.totalMs += durationMs;
+			aggregate.maxMs = qMax(aggregate.maxMs, durationMs);
+			if (entry.begin >= aggregate.last){
+				aggregate.last = entry.begin;
+				aggregate.lastCaliTime = entry.caliTime;
+			}
+			if (list || events){
+				result.lines << QString("%1 #%2 %3 %4 %5 %6 %7 s %8 events")
+					.arg(QFileInfo(path).fileName()).arg(entry.session).arg(formatTime(entry.begin), entry.device,
+						entry.subType.isEmpty() ? QStringLiteral("-") : entry.subType,
+						entry.caliType.isEmpty() ? QStringLiteral("-") : entry.caliType)
+					.arg(durationMs / 1000.0, 0, 'f', 1).arg(entry.events)
+					+ ' ' + SessionLogReader::outcomeName(entry.outcome);
+			}
+			if (events && reader.readSession(entry, records)){
+				for (const auto& record : records){
+					result.lines << QString("    +%1 ms kind=%2 %3").arg(record.time - entry.begin, 8).arg(int(record.kind), 2)
+						.arg(record.kind == SK_GROUP || record.kind == SK_DIST || record.kind == SK_END
+							? QString(record.payload.toHex()) : QString::fromUtf8(record.payload).simplified());
+				}
+			}
+		}
+	}
+
+	QStringList collectLogs(const QStringList& paths, const QString& pattern)
+	{
+		QStringList logs;
+		for (const auto& path : paths){
+			if (!QFileInfo(path).isDir()){
+				logs << path;
+				continue;
+			}
+			QDirIterator it(path, QStringList() << pattern, QDir::Files, QDirIterator::Subdirectories);
+			while (it.hasNext())
+				logs << it.next();
+		}
+		logs.sort();
+		return logs;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication a(argc, argv);
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Scan and aggregate calibration session logs");
+	parser.addHelpOption();
+	parser.addPositionalArgument("logs", "Session log files or directories holding them", "logs...");
+	QCommandLineOption patternOption("pattern", "File name pattern inside directories", "glob", "*.sessions");
+	QCommandLineOption deviceOption("device", "Only sessions of this scanner,repeat for several", "name");
+	QCommandLineOption caliTypeOption("cali-type", "Only sessions of this calibration type", "type");
+	QCommandLineOption outcomeOption("outcome", "Only open,completed,aborted or failed sessions", "outcome");
+	QCommandLineOption sinceOption("since", "Only sessions started at or after this ISO date/time", "date");
+	QCommandLineOption untilOption("until", "Only sessions started before this ISO date/time", "date");
+	QCommandLineOption listOption("list", "Print one line per session");
+	QCommandLineOption eventsOption("events", "Print the records of every session");
+	QCommandLineOption rescanOption("rescan", "Ignore the footer index and scan every record");
+	QCommandLineOption jobsOption("jobs", "Logs read in parallel", "n", QString::number(QThread::idealThreadCount()));
+	parser.addOption(patternOption);
+	parser.addOption(deviceOption);
+	parser.addOption(caliTypeOption);
+	parser.addOption(outcomeOption);
+	parser.addOption(sinceOption);
+	parser.addOption(untilOption);
+	parser.addOption(listOption);
+	parser.addOption(eventsOption);
+	parser.addOption(rescanOption);
+	parser.addOption(jobsOption);
+	parser.process(a);
+
+	if (parser.positionalArguments().isEmpty())
+		parser.showHelp(1);
+
+	Filter filter;
+	filter.devices = parser.values(deviceOption);
+	filter.caliType = parser.value(caliTypeOption);
+	filter.outcome = parser.value(outcomeOption);
+	if (parser.isSet(sinceOption)){
+		auto since = QDateTime::fromString(parser.value(sinceOption), Qt::ISODate);
+		if (!since.isValid()){
+			qCritical() << "invalid --since:" << parser.value(sinceOption);
+			return 1;
+		}
+		filter.since = since.toMSecsSinceEpoch();
+	}
+	if (parser.isSet(untilOption)){
+		auto until = QDateTime::fromString(parser.value(untilOption), Qt::ISODate);
+		if (!until.isValid()){
+			qCritical() << "invalid --until:" << parser.value(untilOption);
+			return 1;
+		}
+		filter.until = until.toMSecsSinceEpoch();
+	}
+
+	QElapsedTimer clock;
+	clock.start();
+	const QStringList logs = collectLogs(parser.positionalArguments(), parser.value(patternOption));
+	std::vector<FileResult> results(logs.size());
+	std::atomic<int> nextLog(0);
+	const bool rescan = parser.isSet(rescanOption);
+	const bool list = parser.isSet(listOption);
+	const bool events = parser.isSet(eventsOption);
+	auto worker = [&]{
+		for (int i = nextLog++; i < logs.size(); i = nextLog++)
+			processFile(logs[i], filter, rescan, list, events, results[i]);
+	};
+	const int jobs = qBound(1, parser.value(jobsOption).toInt(), qMax(1, logs.size()));
+	std::vector<std::thread> threads;
+	for (int i = 1; i < jobs; i++)
+		threads.emplace_back(worker);
+	worker();
+	for (auto& thread : threads)
+		thread.join();
+
+	QMap<QString, Aggregate> total;
+	int sessions = 0, failedLogs = 0, recovered = 0;
+	for (const auto& result : results){
+		if (!result.ok){
+			failedLogs++;
+			continue;
+		}
+		if (result.recovered)
+			recovered++;
+		sessions += result.sessions;
+		for (const auto& line : result.lines)
+			printf("%s\n", line.toLocal8Bit().constData());
+		for (auto it = result.aggregates.begin(); it != result.aggregates.end(); ++it){
+			auto& aggregate = total[it.key()];
+			aggregate.sessions += it->sessions;
+			for (int i = 0; i <= SO_FAILED; i++)
+				aggregate.outcomes[i] += it->outcomes[i];
+			aggregate.totalMs += it->totalMs;
+			aggregate.maxMs = qMax(aggregate.maxMs, it->maxMs);
+			if (it->last >= aggregate.last){
+				aggregate.last = it->last;
+				aggregate.lastCaliTime = it->lastCaliTime;
+			}
+		}
+	}
+	const qint64 elapsedMs = clock.elapsed();
+
+	printf("%-28s %8s %9s %7s %6s %4s %9s %9s  %s\n", "device/type", "sessions", "completed", "aborted", "failed", "open",
+		"mean s", "max s", "last session");
+	for (auto it = total.begin(); it != total.end(); ++it){
+		printf("%-28s %8d %9d %7d %6d %4d %9.1f %9.1f  %s %s\n", it.key().toLocal8Bit().constData(), it->sessions,
+			it->outcomes[SO_COMPLETED], it->outcomes[SO_ABORTED], it->outcomes[SO_FAILED], it->outcomes[SO_OPEN],
+			it->totalMs / 1000.0 / it->sessions, it->maxMs / 1000.0,
+			formatTime(it->last).toLocal8Bit().constData(), it->lastCaliTime.toLocal8Bit().constData());
+	}
+	printf("%d sessions from %d logs in %lld ms,%d recovered without index,%d unreadable\n",
+		sessions, logs.size() - failedLogs, (long long)elapsedMs, recovered, failedLogs);
+	return failedLogs ? 1 : 0;
+}
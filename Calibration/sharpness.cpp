@@ -0,0 +1,131 @@
+#include "sharpness.h"
+#include <algorithm>
+#include <vector>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SHARPNESS_SSE2
+#endif
+
+namespace
+{
+	inline int laplacian(const unsigned char* p, int stride, int step)
+	{
+		return 4 * p[0] - p[-step] - p[step] - p[-stride] - p[stride];
+	}
+
+#ifdef SHARPNESS_SSE2
+	inline __m128i load8(const unsigned char* p, __m128i zero)
+	{
+		return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), zero);
+	}
+
+	inline int64_t horizontalSum(__m128i v)
+	{
+		int32_t lanes[4];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), v);
+		return int64_t(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+	}
+#endif
+}
+
+double SharpnessPartial::variance() const
+{
+	if (!pixels)
+		return 0;
+	const double mean = double(sum) / pixels;
+	return double(sumSquares) / pixels - mean * mean;
+}
+
+SharpnessPartial laplacianRowsScalar(const unsigned char* data, int width, int channel, int firstRow, int lastRow, int firstColumn, int lastColumn)
+{
+	SharpnessPartial partial;
+	const int stride = width * channel;
+	//green of an RGB frame
+	const int offset = channel == 3 ? 1 : 0;
+	for (int y = firstRow; y < lastRow; y++){
+		auto row = data + size_t(y) * stride + offset;
+		for (int x = firstColumn; x < lastColumn; x++){
+			const int value = laplacian(row + x * channel, stride, channel);
+			partial.sum += value;
+			partial.sumSquares += uint64_t(value * value);
+		}
+	}
+	partial.pixels = uint64_t(std::max(0, lastRow - firstRow)) * uint64_t(std::max(0, lastColumn - firstColumn));
+	return partial;
+}
+
+SharpnessPartial laplacianRows(const unsigned char* data, int width, int firstRow, int lastRow, int firstColumn, int lastColumn)
+{
+#ifdef SHARPNESS_SSE2
+	SharpnessPartial partial;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i ones = _mm_set1_epi16(1);
+	for (int y = firstRow; y < lastRow; y++){
+		auto row = data + size_t(y) * width;
+		//8 pixels per step in 16 bit lanes,|L| <= 1020 so L*L pairs fit the 32 bit madd lanes
+		__m128i sum = zero, squares = zero;
+		int x = firstColumn;
+		int steps = 0;
+		for (; x + 8 <= lastColumn; x += 8){
+			auto p = row + x;
+			const __m128i center = load8(p, zero);
+			const __m128i neighbours = _mm_add_epi16(_mm_add_epi16(load8(p - 1, zero), load8(p + 1, zero)),
+				_mm_add_epi16(load8(p - width, zero), load8(p + width, zero)));
+			const __m128i value = _mm_sub_epi16(_mm_slli_epi16(center, 2), neighbours);
+			sum = _mm_add_epi32(sum, _mm_madd_epi16(value, ones));
+			squares = _mm_add_epi32(squares, _mm_madd_epi16(value, value));
+			//a lane gains at most 2*1020^2 per step,flush long before it overflows
+			if (++steps == 512){
+				partial.sum += horizontalSum(sum);
+				partial.sumSquares += uint64_t(horizontalSum(squares));
+				sum = squares = zero;
+				steps = 0;
+			}
+		}
+		partial.sum += horizontalSum(sum);
+		partial.sumSquares += uint64_t(horizontalSum(squares));
+		for (; x < lastColumn; x++){
+			const int value = laplacian(row + x, width, 1);
+			partial.sum += value;
+			partial.sumSquares += uint64_t(value * value);
+		}
+	}
+	partial.pixels = uint64_t(std::max(0, lastRow - firstRow)) * uint64_t(std::max(0, lastColumn - firstColumn));
+	return partial;
+#else
+	return laplacianRowsScalar(data, width, 1, firstRow, lastRow, firstColumn, lastColumn);
+#endif
+}
+
+double laplacianVariance(const unsigned char* data, int width, int height, int channel, const SharpnessRoi& roi, WorkerPool* pool)
+{
+	if (!data || width < 3 || height < 3 || (channel != 1 && channel != 3))
+		return 0;
+	//the Laplacian needs a neighbour on every side
+	const int firstColumn = std::max(1, int(roi.x * width));
+	const int lastColumn = std::min(width - 1, int((roi.x + roi.width) * width));
+	const int firstRow = std::max(1, int(roi.y * height));
+	const int lastRow = std::min(height - 1, int((roi.y + roi.height) * height));
+	if (firstColumn >= lastColumn || firstRow >= lastRow)
+		return 0;
+
+	auto tile = [&](int first, int last){
+		return channel == 1 ? laplacianRows(data, width, first, last, firstColumn, lastColumn)
+			: laplacianRowsScalar(data, width, channel, first, last, firstColumn, lastColumn);
+	};
+	const int threads = std::max(1, std::min(pool ? pool->threads() : 1, lastRow - firstRow));
+	if (threads == 1)
+		return tile(firstRow, lastRow).variance();
+
+	std::vector<SharpnessPartial> partials(threads);
+	const int band = (lastRow - firstRow + threads - 1) / threads;
+	pool->run(threads, [&](int t){
+		const int first = firstRow + t * band;
+		const int last = std::min(lastRow, first + band);
+		if (first < last)
+			partials[t] = tile(first, last);
+	});
+	for (int t = 1; t < threads; t++)
+		partials[0].merge(partials[t]);
+	return partials[0].variance();
+}
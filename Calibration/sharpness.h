@@ -0,0 +1,49 @@
+#ifndef SHARPNESS_H
+#define SHARPNESS_H
+
+#include <cstdint>
+#include "workerpool.h"
+/*
+Focus score of a camera frame:variance of the 4-neighbour Laplacian over a region of interest.
+A board inside the depth of field has strong edges and a high variance,a blurred one a low variance.
+Scores are only comparable between frames of the same scene and camera.
+*/
+struct SharpnessRoi
+{
+	//fractions of the frame,the centered half by default
+	double x = 0.25;
+	double y = 0.25;
+	double width = 0.5;
+	double height = 0.5;
+};
+
+struct SharpnessPartial
+{
+	int64_t sum = 0;
+	uint64_t sumSquares = 0;
+	uint64_t pixels = 0;
+
+	void merge(const SharpnessPartial& other)
+	{
+		sum += other.sum;
+		sumSquares += other.sumSquares;
+		pixels += other.pixels;
+	}
+	double variance() const;
+};
+
+/*
+data:width*height*channel pixels,channel 3 is scored on green
+pool:the ROI rows are split into a tile per thread,each summed into its own partial,null scores on the calling thread
+*/
+double laplacianVariance(const unsigned char* data, int width, int height, int channel, const SharpnessRoi& roi, WorkerPool* pool = nullptr);
+/*
+Rows [firstRow,lastRow) and columns [firstColumn,lastColumn) of a gray frame,borders excluded by the caller
+*/
+SharpnessPartial laplacianRows(const unsigned char* data, int width, int firstRow, int lastRow, int firstColumn, int lastColumn);
+/*
+One pixel at a time,reference for the benchmark
+*/
+SharpnessPartial laplacianRowsScalar(const unsigned char* data, int width, int channel, int firstRow, int lastRow, int firstColumn, int lastColumn);
+
+#endif // SHARPNESS_H
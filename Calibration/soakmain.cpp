@@ -0,0 +1,120 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QScopedPointer>
+#include <QStringList>
+#include <QtDebug>
+#include "metrics.h"
+#include "soakrunner.h"
+
+namespace
+{
+	//integer option of at least minimum,false after reporting it
+	bool intOption(const QCommandLineParser& parser, const QCommandLineOption& option, int* value, int minimum = 1)
+	{
+		if (!parser.isSet(option))
+			return true;
+		bool ok = false;
+		const int v = parser.value(option).toInt(&ok);
+		if (!ok || v < minimum){
+			qCritical().noquote() << QString("invalid --%1:").arg(option.names().first()) << parser.value(option);
+			return false;
+		}
+		*value = v;
+		return true;
+	}
+
+	bool doubleOption(const QCommandLineParser& parser, const QCommandLineOption& option, double* value)
+	{
+		if (!parser.isSet(option))
+			return true;
+		bool ok = false;
+		const double v = parser.value(option).toDouble(&ok);
+		if (!ok || v < 0){
+			qCritical().noquote() << QString("invalid --%1:").arg(option.names().first()) << parser.value(option);
+			return false;
+		}
+		*value = v;
+		return true;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication a(argc, argv);
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Run the client against a local mock SDK for hours,fail on memory growth or latency drift");
+	parser.addHelpOption();
+	QCommandLineOption minutesOption("minutes", "Length of the run", "minutes", "240");
+	QCommandLineOption sampleOption("sample-seconds", "Time between two samples", "seconds", "60");
+	QCommandLineOption warmupOption("warmup-samples", "Samples before the memory and latency baseline", "count", "5");
+	QCommandLineOption windowOption("window-samples", "Samples merged into one p99 window", "count", "5");
+	QCommandLineOption fpsOption("fps", "Frames per second of each of the two cameras", "fps", "30");
+	QCommandLineOption widthOption("width", "Frame width", "pixels", "1280");
+	QCommandLineOption heightOption("height", "Frame height", "pixels", "1024");
+	QCommandLineOption publishRateOption("publish-rate", "Calibration publishes per second", "count", "50");
+	QCommandLineOption heartbeatOption("heartbeat-ms", "Heartbeat interval", "ms", "200");
+	QCommandLineOption requestRateOption("request-rate", "Request rounds per second,each asks distance,group and time", "count", "10");
+	QCommandLineOption portsOption("ports", "Local ports of the mock SDK and the data processer", "pub:req:data", "21398:21399:22000");
+	QCommandLineOption rssOption("max-rss-growth-mb", "RSS growth allowed since the baseline", "MB", "64");
+	QCommandLineOption heapOption("max-heap-growth-mb", "Heap growth allowed since the baseline", "MB", "32");
+	QCommandLineOption driftOption("max-p99-drift", "p99 growth allowed per path,as a fraction of the baseline", "fraction", "0.5");
+	QCommandLineOption slackOption("p99-slack-ms", "p99 growth always allowed per path", "ms", "1");
+	QCommandLineOption stallOption("stall-gui-ms", "Block the GUI thread this long every second,use with a publish flood", "ms", "0");
+	QCommandLineOption publishHwmOption("publish-hwm", "High-water mark of the mock's PUB socket", "messages", "1000");
+	QCommandLineOption reportOption("report", "Write one csv row per sample to <file>", "file");
+	QCommandLineOption metricsOption("metrics-file", "Rewrite Prometheus metrics into <file> every 5 seconds", "file");
+	for (const auto& option : { minutesOption, sampleOption, warmupOption, windowOption, fpsOption, widthOption, heightOption,
+		publishRateOption, heartbeatOption, requestRateOption, portsOption, rssOption, heapOption, driftOption, slackOption,
+		stallOption, publishHwmOption, reportOption, metricsOption })
+		parser.addOption(option);
+	parser.process(a);
+
+	SoakRunner::Options options;
+	if (!intOption(parser, minutesOption, &options.minutes)
+		|| !intOption(parser, sampleOption, &options.sampleSeconds)
+		|| !intOption(parser, warmupOption, &options.warmupSamples)
+		|| !intOption(parser, windowOption, &options.windowSamples)
+		|| !intOption(parser, fpsOption, &options.sdk.fps)
+		|| !intOption(parser, widthOption, &options.sdk.width)
+		|| !intOption(parser, heightOption, &options.sdk.height)
+		|| !intOption(parser, publishRateOption, &options.sdk.publishesPerSecond)
+		|| !intOption(parser, heartbeatOption, &options.sdk.heartbeatMs)
+		|| !intOption(parser, requestRateOption, &options.requestsPerSecond)
+		|| !intOption(parser, stallOption, &options.stallGuiMs, 0)
+		|| !intOption(parser, publishHwmOption, &options.sdk.publishHwm)
+		|| !doubleOption(parser, rssOption, &options.maxRssGrowthMb)
+		|| !doubleOption(parser, heapOption, &options.maxHeapGrowthMb)
+		|| !doubleOption(parser, driftOption, &options.maxP99Drift)
+		|| !doubleOption(parser, slackOption, &options.p99SlackMs))
+		return SE_USAGE;
+	if (options.stallGuiMs >= 1000){
+		qCritical() << "--stall-gui-ms must leave the GUI part of every second";
+		return SE_USAGE;
+	}
+	if (parser.isSet(portsOption)){
+		const auto ports = parser.value(portsOption).split(':');
+		bool ok = ports.size() == 3;
+		int values[3] = { 0 };
+		for (int i = 0; ok && i < 3; i++)
+			values[i] = ports[i].toInt(&ok);
+		if (!ok){
+			qCritical() << "invalid --ports:" << parser.value(portsOption);
+			return SE_USAGE;
+		}
+		options.sdk.publishPort = values[0];
+		options.sdk.requestPort = values[1];
+		options.dataPort = values[2];
+	}
+	options.reportFile = parser.value(reportOption);
+
+	QScopedPointer<MetricsExporter> metricsExporter;
+	if (parser.isSet(metricsOption))
+		metricsExporter.reset(new MetricsExporter(parser.value(metricsOption), 5000));
+
+	SoakRunner runner(options);
+	QObject::connect(&runner, &SoakRunner::finished, &a, &QCoreApplication::exit, Qt::QueuedConnection);
+	runner.start();
+
+	return a.exec();
+}
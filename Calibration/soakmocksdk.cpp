@@ -0,0 +1,240 @@
+#include "soakmocksdk.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QtDebug>
+#include <zmq.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include "protocol.h"
+
+namespace
+{
+	const char REGISTER_ENVELOPE[] = "v1.0/scan/register";
+	//upper bound of the timer error,the poll also wakes on every request
+	const int MAX_POLL_MS = 5;
+
+	qint64 nowNs()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	QString segmentKey(int camera)
+	{
+		const auto name = QString("calib_soak_%1_cam%2").arg(QCoreApplication::applicationPid()).arg(camera);
+#ifdef Q_OS_WIN
+		return name;
+#else
+		return QDir::temp().filePath(name);
+#endif
+	}
+
+	//sndHwm:set before the bind,pipes created later keep the value they started with
+	void* bindSocket(void* context, int type, int port, int sndHwm = -1)
+	{
+		auto socket = zmq_socket(context, type);
+		const int linger = 0;
+		zmq_setsockopt(socket, ZMQ_LINGER, &linger, sizeof(linger));
+		if (sndHwm >= 0)
+			zmq_setsockopt(socket, ZMQ_SNDHWM, &sndHwm, sizeof(sndHwm));
+		if (zmq_bind(socket, QString("tcp://*:%1").arg(port).toLocal8Bit().constData()) != 0){
+			qCritical() << "mock SDK cannot bind port" << port << zmq_strerror(zmq_errno());
+			zmq_close(socket);
+			return nullptr;
+		}
+		return socket;
+	}
+}
+
+SoakMockSdk::SoakMockSdk(const Options& options)
+	: m_options(options)
+{
+	m_notificationMetric = MetricsRegistry::instance().histogram("calib_soak_notification_seconds",
+		"Data processing notification round trip as the mock SDK sees it");
+}
+
+SoakMockSdk::~SoakMockSdk()
+{
+	stop();
+}
+
+bool SoakMockSdk::start()
+{
+	m_context = zmq_ctx_new();
+	m_publishSocket = bindSocket(m_context, ZMQ_PUB, m_options.publishPort, m_options.publishHwm);
+	m_replySocket = bindSocket(m_context, ZMQ_REP, m_options.requestPort);
+	if (!m_publishSocket || !m_replySocket)
+		return false;
+	const int frameBytes = m_options.width * m_options.height;
+	for (int camera = 0; camera < 2; camera++){
+		auto& segment = m_frames[camera];
+		segment.setNativeKey(segmentKey(camera));
+		if (!segment.create(frameBytes)){
+			qCritical() << "mock SDK cannot create the frame segment" << segment.nativeKey() << segment.errorString();
+			return false;
+		}
+		//gradient,every frame then brightens one moving row so no two frames are equal
+		auto data = static_cast<unsigned char*>(segment.data());
+		for (int i = 0; i < frameBytes; i++)
+			data[i] = (unsigned char)((i % m_options.width + i / m_options.width) & 0x7f);
+	}
+	m_thread = std::thread([this]{ serve(); });
+	return true;
+}
+
+void SoakMockSdk::stop()
+{
+	if (!m_context)
+		return;
+	m_stopped = true;
+	if (m_thread.joinable())
+		m_thread.join();
+	for (auto socket : { m_publishSocket, m_replySocket, m_notifySocket }){
+		if (socket)
+			zmq_close(socket);
+	}
+	m_publishSocket = m_replySocket = m_notifySocket = nullptr;
+	zmq_ctx_term(m_context);
+	m_context = nullptr;
+	for (auto& segment : m_frames)
+		segment.detach();
+}
+
+void SoakMockSdk::serve()
+{
+	typedef std::chrono::steady_clock Clock;
+	const auto heartbeatInterval = std::chrono::milliseconds(m_options.heartbeatMs);
+	const auto publishInterval = std::chrono::nanoseconds(1000000000LL / std::max(1, m_options.publishesPerSecond));
+	//the cameras take turns
+	const auto frameInterval = std::chrono::nanoseconds(1000000000LL / std::max(1, m_options.fps * 2));
+	auto heartbeatDue = Clock::now(), publishDue = Clock::now(), frameDue = Clock::now();
+
+	while (!m_stopped){
+		zmq_pollitem_t items[] = {
+			{ m_replySocket, 0, ZMQ_POLLIN, 0 },
+			{ m_notifySocket, 0, ZMQ_POLLIN, 0 }
+		};
+		const int count = m_notificationPending ? 2 : 1;
+		const auto due = std::min(heartbeatDue, std::min(publishDue, frameDue));
+		const auto waitMs = std::chrono::duration_cast<std::chrono::milliseconds>(due - Clock::now()).count();
+		if (zmq_poll(items, count, int(std::max<qint64>(0, std::min<qint64>(waitMs, MAX_POLL_MS)))) == -1)
+			break;
+		if (items[0].revents & ZMQ_POLLIN)
+			answerRequest();
+		if (count > 1 && (items[1].revents & ZMQ_POLLIN))
+			readNotificationReply();
+
+		//a late timer runs once and is rescheduled from now,missed ticks are not replayed
+		const auto now = Clock::now();
+		if (now >= heartbeatDue){
+			publish("v1.0/hb", QByteArray());
+			heartbeatDue = std::max(heartbeatDue + heartbeatInterval, now);
+		}
+		if (now >= publishDue){
+			publishNext();
+			publishDue = std::max(publishDue + publishInterval, now);
+		}
+		if (now >= frameDue){
+			if (m_registered)
+				sendFrame(int(m_frameNumber & 1));
+			m_frameNumber++;
+			frameDue = std::max(frameDue + frameInterval, now);
+		}
+	}
+}
+
+void SoakMockSdk::answerRequest()
+{
+	char envelope[MAX_ENVELOPE_LENGTH + 1] = { 0 };
+	const int size = zmq_recv(m_replySocket, envelope, MAX_ENVELOPE_LENGTH, 0);
+	QByteArray data;
+	int more = 0;
+	size_t moreSize = sizeof(more);
+	while (zmq_getsockopt(m_replySocket, ZMQ_RCVMORE, &more, &moreSize) == 0 && more){
+		char part[MAX_DATA_LENGTH];
+		const int partSize = zmq_recv(m_replySocket, part, sizeof(part), 0);
+		if (partSize > 0)
+			data = QByteArray(part, qMin(partSize, int(sizeof(part))));
+	}
+	if (size == int(strlen(REGISTER_ENVELOPE)) && !memcmp(envelope, REGISTER_ENVELOPE, size) && !m_notifySocket){
+		//the data processer bound its REP socket before registering
+		m_notifySocket = zmq_socket(m_context, ZMQ_REQ);
+		const int linger = 0;
+		zmq_setsockopt(m_notifySocket, ZMQ_LINGER, &linger, sizeof(linger));
+		if (zmq_connect(m_notifySocket, data.constData()) == 0)
+			m_registered = true;
+		else
+			qCritical() << "mock SDK cannot connect to the data processer at" << data;
+	}
+	//device,set and enter/exit replies are a native int used as bool
+	const int result = 1;
+	zmq_send(m_replySocket, &result, sizeof(result), 0);
+}
+
+void SoakMockSdk::readNotificationReply()
+{
+	char reply[64];
+	if (zmq_recv(m_notifySocket, reply, sizeof(reply), 0) == -1)
+		return;
+	m_notificationPending = false;
+	m_framesHandled.fetch_add(1, std::memory_order_relaxed);
+	m_notificationMetric->observe(nowNs() - m_notificationSentNs);
+}
+
+void SoakMockSdk::publish(const char* envelope, const QByteArray& data)
+{
+	//the heartbeat is the only single part publish
+	const bool single = !strcmp(envelope, "v1.0/hb");
+	zmq_send(m_publishSocket, envelope, strlen(envelope), single ? 0 : ZMQ_SNDMORE);
+	if (!single)
+		zmq_send(m_publishSocket, data.constData(), size_t(data.size()), 0);
+}
+
+void SoakMockSdk::publishNext()
+{
+	//the mix of a capture:state topics the GUI coalesces and the probe that measures the path
+	const quint64 number = m_publishNumber++;
+	switch (number % 4){
+	case 0:
+		publish("v1.0/soak/probe", QByteArray::number(nowNs()));
+		break;
+	case 1:{
+		const int dist = int(number / 4 % 5) + 1;
+		publish("v1.0/cali/currentCaliDist", QByteArray(reinterpret_cast<const char*>(&dist), sizeof(dist)));
+		break;
+	}
+	case 2:{
+		QByteArray states = "{\"states\":[";
+		for (int i = 0; i < 5; i++)
+			states += QByteArray(i ? "," : "") + (quint64(i) < number / 4 % 6 ? "true" : "false");
+		publish("v1.0/cali/caliDistStates", states + "]}");
+		break;
+	}
+	default:{
+		const int enabled = int(number / 4 % 2);
+		publish("v1.0/cali/snapEnabled", QByteArray(reinterpret_cast<const char*>(&enabled), sizeof(enabled)));
+		break;
+	}
+	}
+}
+
+bool SoakMockSdk::sendFrame(int camera)
+{
+	if (m_notificationPending){
+		m_framesSkipped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	auto& segment = m_frames[camera];
+	auto data = static_cast<unsigned char*>(segment.data());
+	const int row = int(m_frameNumber / 2 % quint64(m_options.height));
+	memset(data + size_t(row) * m_options.width, int(m_frameNumber & 0xff), size_t(m_options.width));
+
+	const auto notification = QString("{\"type\":\"MT_VIDEO_DATA\",\"key\":\"%1\",\"name\":\"cam%2\",\"offset\":0,"
+		"\"props\":{\"rotate\":0,\"width\":%3,\"height\":%4,\"channel\":1}}")
+		.arg(segment.nativeKey()).arg(camera).arg(m_options.width).arg(m_options.height).toUtf8();
+	m_notificationSentNs = nowNs();
+	if (zmq_send(m_notifySocket, notification.constData(), size_t(notification.size()), 0) == -1)
+		return false;
+	m_notificationPending = true;
+	return true;
+}
@@ -0,0 +1,75 @@
+#ifndef SOAK_MOCK_SDK_H
+#define SOAK_MOCK_SDK_H
+
+#include <QSharedMemory>
+#include <QString>
+#include <atomic>
+#include <thread>
+#include "metrics.h"
+/*
+Scanner SDK stand-in for Calibration-Soak,on its own thread and ZMQ context.
+Binds the publish and request ports of one device on localhost,answers every request,
+publishes heartbeats and a mix of calibration publishes,and once the client's DataProcesser
+registered,writes frames of two gray cameras into shared memory and sends their notifications.
+*/
+class SoakMockSdk
+{
+public:
+	struct Options
+	{
+		int publishPort = 21398;
+		int requestPort = 21399;
+		int heartbeatMs = 200;
+		int publishesPerSecond = 50;
+		int publishHwm = 1000;//messages the PUB socket queues per subscriber,the libzmq default
+		int fps = 30;//per camera
+		int width = 1280;
+		int height = 1024;
+	};
+	explicit SoakMockSdk(const Options& options);
+	~SoakMockSdk();
+	SoakMockSdk(const SoakMockSdk&) = delete;
+	SoakMockSdk& operator=(const SoakMockSdk&) = delete;
+
+	/*
+	Bind the sockets and create the frame segments,false when a port or segment is taken
+	*/
+	bool start();
+	void stop();
+
+	//payload of the soak/probe publish,steady clock ns when it was sent
+	static const char* probeTopic() { return "soak/probe"; }
+	/*
+	Notifications answered by the client,compared with the frames it received to get the backlog
+	*/
+	quint64 framesHandled() const { return m_framesHandled.load(std::memory_order_relaxed); }
+	//frames not sent because the client had not answered the previous notification yet
+	quint64 framesSkipped() const { return m_framesSkipped.load(std::memory_order_relaxed); }
+	bool isRegistered() const { return m_registered.load(std::memory_order_relaxed); }
+private:
+	void serve();
+	void answerRequest();
+	void readNotificationReply();
+	void publish(const char* envelope, const QByteArray& data);
+	void publishNext();
+	bool sendFrame(int camera);
+
+	Options m_options;
+	void* m_context = nullptr;
+	void* m_publishSocket = nullptr;
+	void* m_replySocket = nullptr;
+	void* m_notifySocket = nullptr;//REQ to the client's DataProcesser
+	QSharedMemory m_frames[2];
+	quint64 m_frameNumber = 0;
+	quint64 m_publishNumber = 0;
+	bool m_notificationPending = false;
+	qint64 m_notificationSentNs = 0;
+	std::atomic<bool> m_stopped{ false };
+	std::atomic<bool> m_registered{ false };
+	std::atomic<quint64> m_framesHandled{ 0 };
+	std::atomic<quint64> m_framesSkipped{ 0 };
+	MetricHistogram* m_notificationMetric = nullptr;
+	std::thread m_thread;
+};
+
+#endif // SOAK_MOCK_SDK_H
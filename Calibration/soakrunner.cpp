@@ -0,0 +1,312 @@
+#include "soakrunner.h"
+#include <QThread>
+#include <QtDebug>
+#include <chrono>
+#include "sdkmessage.h"
+
+namespace
+{
+	//first heartbeat and data processer registration
+	const int CONNECT_TIMEOUT_MS = 10000;
+	const double MB = 1024.0 * 1024.0;
+	//one queued publish:envelope,payload,the QStrings and QByteArray of a PublishMessage and allocator overhead
+	const int PUBLISH_ENTRY_BYTES = 512;
+
+	qint64 nowNs()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	//observations between two cumulative snapshots of one histogram
+	MetricHistogram::Snapshot between(const MetricHistogram::Snapshot& earlier, const MetricHistogram::Snapshot& later)
+	{
+		MetricHistogram::Snapshot window;
+		window.bounds = later.bounds;
+		window.cumulative = later.cumulative;
+		for (int b = 0; b < window.cumulative.size() && b < earlier.cumulative.size(); b++)
+			window.cumulative[b] -= earlier.cumulative[b];
+		window.count = later.count - earlier.count;
+		window.sum = later.sum - earlier.sum;
+		return window;
+	}
+
+	double ms(qint64 ns)
+	{
+		return ns / 1e6;
+	}
+}
+
+SoakRunner::SoakRunner(const Options& options, QObject *parent)
+	: QObject(parent), m_options(options), m_sdk(options.sdk)
+{
+	auto& registry = MetricsRegistry::instance();
+	m_publishMetric = registry.histogram("calib_soak_publish_latency_seconds", "Publish sent by the mock SDK to handled on the GUI thread");
+	m_frameMetric = registry.histogram("calib_soak_frame_latency_seconds", "Video frame converted to received on the GUI thread");
+	m_rssMetric = registry.gauge("calib_soak_rss_bytes", "Resident memory of the soak process");
+	m_heapMetric = registry.gauge("calib_soak_heap_bytes", "Heap in use by the soak process");
+}
+
+SoakRunner::~SoakRunner()
+{
+	//the client sockets go before the SDK they are connected to
+	delete m_devices;
+	m_devices = nullptr;
+	m_sdk.stop();
+}
+
+void SoakRunner::start()
+{
+	if (!m_sdk.start()){
+		QMetaObject::invokeMethod(this, "finished", Qt::QueuedConnection, Q_ARG(int, SE_SETUP));
+		return;
+	}
+
+	DeviceEndpoint endpoint;
+	endpoint.name = QStringLiteral("soak");
+	endpoint.publishPort = m_options.sdk.publishPort;
+	endpoint.requestPort = m_options.sdk.requestPort;
+	endpoint.dataPort = m_options.dataPort;
+	m_start = sampleProcessMemory();
+	m_devices = new DeviceManager(QList<DeviceEndpoint>() << endpoint, m_tuning);
+	m_client.setSocket(m_devices->requestSocket(0));
+	//the mock changes one row per frame,most frames would be skipped as unchanged;every frame is converted,the worst case
+	m_devices->dataProcesser(0)->setChangeTolerance(-1);
+
+	connect(m_devices, &DeviceManager::heartbeat, this, [this](int){ m_connected = true; });
+	connect(m_devices, &DeviceManager::dataProcesserRegistered, this, [this](int, bool ok){
+		if (!ok){
+			qCritical() << "data processer could not register with the mock SDK";
+			finish(SE_SETUP);
+		}
+	});
+	connect(m_devices, &DeviceManager::publishReceived, this, [this](int, QString majorCmd, QString minorCmd, QByteArray data){
+		if (majorCmd + '/' + minorCmd == SoakMockSdk::probeTopic())
+			m_publishMetric->observe(nowNs() - data.toLongLong());
+		else if (minorCmd == QStringLiteral("caliDistStates"))
+			distanceStates(data);//what the GUI does with it
+	});
+	connect(m_devices, &DeviceManager::videoImageReady, this, [this](int, int, VideoFrame frame){
+		m_framesReceived++;
+		m_frameMetric->observe(nowNs() - frame.timestampNs);
+	});
+
+	auto& registry = MetricsRegistry::instance();
+	addPath(QStringLiteral("publish"), m_publishMetric);
+	addPath(QStringLiteral("notification"), registry.histogram("calib_soak_notification_seconds",
+		"Data processing notification round trip as the mock SDK sees it"));
+	addPath(QStringLiteral("frame"), m_frameMetric);
+	addPath(QStringLiteral("request"), registry.histogram("calib_request_seconds", "SDK request round trip time"));
+
+	if (m_options.reportFile.size()){
+		m_report.setFileName(m_options.reportFile);
+		if (m_report.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)){
+			QByteArray header = "seconds,rss_mb,heap_mb,heap_total_mb,publish_queue,frame_backlog,frames_skipped";
+			for (const auto& path : m_paths)
+				header += QString(",%1_count,%1_p50_ms,%1_p99_ms").arg(path.name).toUtf8();
+			m_report.write(header + '\n');
+		}
+		else{
+			qWarning() << "cannot write soak report" << m_options.reportFile;
+		}
+	}
+
+	m_sampleTimer.setInterval(m_options.sampleSeconds * 1000);
+	connect(&m_sampleTimer, &QTimer::timeout, this, &SoakRunner::sample);
+	m_requestTimer.setInterval(qMax(1, 1000 / qMax(1, m_options.requestsPerSecond)));
+	connect(&m_requestTimer, &QTimer::timeout, this, &SoakRunner::sendRequests);
+	m_endTimer.setSingleShot(true);
+	m_endTimer.setInterval(m_options.minutes * 60 * 1000);
+	connect(&m_endTimer, &QTimer::timeout, this, [this]{
+		sample();
+		finish(SE_PASS);
+	});
+	m_connectTimer.setSingleShot(true);
+	m_connectTimer.setInterval(CONNECT_TIMEOUT_MS);
+	m_stallTimer.setInterval(1000);
+	connect(&m_stallTimer, &QTimer::timeout, this, &SoakRunner::stallGui);
+	connect(&m_connectTimer, &QTimer::timeout, this, [this]{
+		if (m_connected && m_sdk.isRegistered())
+			return;
+		qCritical() << "no heartbeat or no data processer registration within" << CONNECT_TIMEOUT_MS << "ms";
+		finish(SE_SETUP);
+	});
+
+	qInfo() << "soak:" << m_options.minutes << "minutes," << m_options.sdk.fps << "fps per camera,"
+		<< m_options.sdk.publishesPerSecond << "publishes/s," << m_options.requestsPerSecond << "requests/s";
+	if (m_options.stallGuiMs > 0)
+		qInfo() << "soak: GUI thread stalled" << m_options.stallGuiMs << "ms of every second,queues may hold" << queueBoundMb() << "MB";
+	m_devices->start();
+	m_clock.start();
+	m_sampleTimer.start();
+	m_requestTimer.start();
+	m_endTimer.start();
+	m_connectTimer.start();
+	if (m_options.stallGuiMs > 0)
+		m_stallTimer.start();
+}
+
+void SoakRunner::addPath(const QString& name, MetricHistogram* histogram)
+{
+	Path path;
+	path.name = name;
+	path.histogram = histogram;
+	path.samples.append(histogram->snapshot());
+	m_paths.append(path);
+}
+
+void SoakRunner::sendRequests()
+{
+	if (!m_connected)
+		return;
+	//what the GUI asks on every publish
+	int dist = 0, group = 0;
+	QString time;
+	m_client.caliCurrentDist(&dist);
+	m_client.caliCurrentGroup(&group);
+	m_client.caliTime(&time);
+}
+
+void SoakRunner::stallGui()
+{
+	//the deepest the queues get is right before the GUI runs again
+	m_maxPublishQueue = qMax(m_maxPublishQueue, m_devices->publishChannel(0)->depth());
+	QThread::msleep(ulong(m_options.stallGuiMs));
+	m_maxPublishQueue = qMax(m_maxPublishQueue, m_devices->publishChannel(0)->depth());
+	m_maxFrameBacklog = qMax(m_maxFrameBacklog, qint64(m_sdk.framesHandled()) - qint64(m_framesReceived));
+}
+
+qint64 SoakRunner::stallFrames() const
+{
+	//frames the data processer converts while the GUI sleeps,the previous stall's may still be draining
+	return qint64(m_options.sdk.fps) * 2 * m_options.stallGuiMs / 1000 + 1;
+}
+
+double SoakRunner::queueBoundMb() const
+{
+	//the mock's PUB queue,the client's SUB queue and the channel between Subscriber and GUI
+	const qint64 publishes = qint64(qMax(0, m_options.sdk.publishHwm)) + qMax(0, m_tuning.tuning(SC_PUBLISH).rcvHwm)
+		+ qint64(m_devices ? m_devices->publishChannel(0)->capacity() : 0);
+	//frames the data processer converted while the GUI slept,queued as signals
+	return (publishes * PUBLISH_ENTRY_BYTES + stallFrames() * m_options.sdk.width * m_options.sdk.height) / MB;
+}
+
+int SoakRunner::checkStall(const ProcessMemory& memory)
+{
+	//frame signals are queued without a bound,a GUI that falls behind lets them pile up stall after stall
+	if (m_maxFrameBacklog > stallFrames()){
+		qCritical() << "frame backlog reached" << m_maxFrameBacklog << "frames with the GUI stalled,one stall converts at most" << stallFrames();
+		return SE_UNBOUNDED_QUEUE;
+	}
+	//from before the client started,the queues are full long before the baseline
+	const double rssGrowth = (memory.rssBytes - m_start.rssBytes) / MB;
+	const double limit = queueBoundMb() + m_options.maxRssGrowthMb;
+	if (m_start.rssBytes >= 0 && memory.rssBytes >= 0 && rssGrowth > limit){
+		qCritical() << "RSS grew" << rssGrowth << "MB with the GUI stalled,the queues can hold" << queueBoundMb() << "MB,limit" << limit;
+		return SE_UNBOUNDED_QUEUE;
+	}
+	return SE_PASS;
+}
+
+void SoakRunner::sample()
+{
+	if (m_finished)
+		return;
+	m_samples++;
+	const auto memory = sampleProcessMemory();
+	m_rssMetric->set(memory.rssBytes);
+	m_heapMetric->set(memory.heapInUseBytes);
+	if (m_samples == m_options.warmupSamples)
+		m_baseline = memory;
+
+	const qint64 publishQueue = qint64(m_devices->publishChannel(0)->depth());
+	//frames answered by the data processer whose queued signal the GUI thread has not run yet
+	const qint64 frameBacklog = qint64(m_sdk.framesHandled()) - qint64(m_framesReceived);
+	const quint64 skipped = m_sdk.framesSkipped() - m_framesSkipped;
+	m_framesSkipped = m_sdk.framesSkipped();
+
+	QString line = QString("soak %1 s: rss %2 MB heap %3 MB,publish queue %4,frame backlog %5,skipped %6")
+		.arg(m_clock.elapsed() / 1000).arg(memory.rssBytes / MB, 0, 'f', 1).arg(memory.heapInUseBytes / MB, 0, 'f', 1)
+		.arg(publishQueue).arg(frameBacklog).arg(skipped);
+	QByteArray row = QString("%1,%2,%3,%4,%5,%6,%7").arg(m_clock.elapsed() / 1000)
+		.arg(memory.rssBytes / MB, 0, 'f', 2).arg(memory.heapInUseBytes / MB, 0, 'f', 2).arg(memory.heapTotalBytes / MB, 0, 'f', 2)
+		.arg(publishQueue).arg(frameBacklog).arg(skipped).toUtf8();
+	for (auto& path : m_paths){
+		path.samples.append(path.histogram->snapshot());
+		const auto window = between(path.samples[path.samples.size() - 2], path.samples.last());
+		line += QString(",%1 p99 %2 ms").arg(path.name).arg(ms(window.quantile(0.99)), 0, 'f', 2);
+		row += QString(",%1,%2,%3").arg(window.count).arg(ms(window.quantile(0.5)), 0, 'f', 3).arg(ms(window.quantile(0.99)), 0, 'f', 3).toUtf8();
+	}
+	qInfo().noquote() << line;
+	if (m_report.isOpen()){
+		m_report.write(row + '\n');
+		m_report.flush();
+	}
+
+	int code = m_options.stallGuiMs > 0 ? checkStall(memory) : SE_PASS;
+	if (code == SE_PASS)
+		code = check(memory);
+	if (code != SE_PASS)
+		finish(code);
+}
+
+int SoakRunner::check(const ProcessMemory& memory)
+{
+	if (m_samples <= m_options.warmupSamples)
+		return SE_PASS;
+	const double rssGrowth = (memory.rssBytes - m_baseline.rssBytes) / MB;
+	if (m_baseline.rssBytes >= 0 && rssGrowth > m_options.maxRssGrowthMb){
+		qCritical() << "RSS grew" << rssGrowth << "MB since the baseline,limit" << m_options.maxRssGrowthMb;
+		return SE_MEMORY_GROWTH;
+	}
+	const double heapGrowth = (memory.heapInUseBytes - m_baseline.heapInUseBytes) / MB;
+	if (m_baseline.heapInUseBytes >= 0 && heapGrowth > m_options.maxHeapGrowthMb){
+		qCritical() << "heap grew" << heapGrowth << "MB since the baseline,limit" << m_options.maxHeapGrowthMb;
+		return SE_MEMORY_GROWTH;
+	}
+
+	for (const auto& path : m_paths){
+		if (path.samples.last().count == path.samples[path.samples.size() - 2].count){
+			qCritical() << "the" << path.name << "path delivered nothing for" << m_options.sampleSeconds << "s";
+			return SE_STALLED;
+		}
+	}
+
+	//samples[0] is the start,samples[k] the k-th sample
+	const int window = qMax(1, m_options.windowSamples);
+	const int baselineEnd = m_options.warmupSamples + window;
+	if (m_samples < baselineEnd + window)
+		return SE_PASS;
+	for (const auto& path : m_paths){
+		const auto baseline = between(path.samples[m_options.warmupSamples], path.samples[baselineEnd]);
+		const auto current = between(path.samples[m_samples - window], path.samples[m_samples]);
+		const double baselineMs = ms(baseline.quantile(0.99)), currentMs = ms(current.quantile(0.99));
+		if (currentMs > baselineMs * (1 + m_options.maxP99Drift) + m_options.p99SlackMs){
+			qCritical() << "p99 of the" << path.name << "path drifted from" << baselineMs << "ms to" << currentMs << "ms";
+			return SE_LATENCY_DRIFT;
+		}
+	}
+	return SE_PASS;
+}
+
+void SoakRunner::finish(int code)
+{
+	if (m_finished)
+		return;
+	m_finished = true;
+	m_sampleTimer.stop();
+	m_requestTimer.stop();
+	m_endTimer.stop();
+	m_connectTimer.stop();
+	m_stallTimer.stop();
+	if (m_devices)
+		m_devices->shutdown();
+	m_sdk.stop();
+	m_report.close();
+	if (code == SE_PASS && m_options.stallGuiMs > 0)
+		qInfo() << "soak passed after" << m_samples << "samples,publish queue at most" << m_maxPublishQueue << ",frame backlog at most" << m_maxFrameBacklog;
+	else if (code == SE_PASS)
+		qInfo() << "soak passed after" << m_samples << "samples";
+	else
+		qCritical() << "soak failed with code" << code << "after" << m_samples << "samples";
+	emit finished(code);
+}
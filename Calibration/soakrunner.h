@@ -0,0 +1,113 @@
+#ifndef SOAK_RUNNER_H
+#define SOAK_RUNNER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTimer>
+#include <QVector>
+#include "calibrationclient.h"
+#include "devicemanager.h"
+#include "metrics.h"
+#include "processmemory.h"
+#include "soakmocksdk.h"
+/*
+Exit codes of Calibration-Soak
+*/
+enum SoakExitCode
+{
+	SE_PASS = 0,
+	SE_USAGE = 1,
+	SE_SETUP = 2,//the mock SDK could not start or the client never connected to it
+	SE_MEMORY_GROWTH = 3,//RSS or heap grew more than allowed since the baseline
+	SE_LATENCY_DRIFT = 4,//a path's p99 drifted more than allowed since the baseline
+	SE_STALLED = 5,//a path delivered nothing for a whole window
+	SE_UNBOUNDED_QUEUE = 6//with the GUI stalled,the frame backlog outgrew one stall or RSS went past what the high-water marks allow
+};
+
+/*
+Runs the client's Subscriber,DataProcesser and request path together against SoakMockSdk for hours,
+the way DeviceManager wires them for the GUI.Every sample interval it records RSS,heap,queue depths
+and the p50/p99 of every path since the last sample;after the warm-up samples the first window is
+the baseline,and every later window is checked against it.
+With stallGuiMs the GUI thread sleeps that long every second while the mock floods publishes:
+the frame signals queued for the GUI must stay within the frames of one stall and RSS within
+what the ZMQ high-water marks,the publish queue and those frames can hold.
+*/
+class SoakRunner : public QObject
+{
+	Q_OBJECT
+public:
+	struct Options
+	{
+		SoakMockSdk::Options sdk;
+		int dataPort = 22000;
+		int minutes = 240;
+		int sampleSeconds = 60;
+		int warmupSamples = 5;//caches and pools fill up before the baseline is taken
+		int windowSamples = 5;//p99 is compared over this many samples merged
+		int requestsPerSecond = 10;
+		double maxRssGrowthMb = 64;
+		double maxHeapGrowthMb = 32;
+		double maxP99Drift = 0.5;//fraction of the baseline p99
+		double p99SlackMs = 1;//absolute drift always allowed,keeps microsecond paths from failing on noise
+		QString reportFile;//one csv row per sample
+		int stallGuiMs = 0;//of every second,0 never stalls
+	};
+	explicit SoakRunner(const Options& options, QObject *parent = nullptr);
+	~SoakRunner();
+
+	void start();
+signals:
+	/*
+	code:SoakExitCode
+	*/
+	void finished(int code);
+private slots:
+	void sample();
+	void sendRequests();
+	void stallGui();
+private:
+	struct Path
+	{
+		QString name;
+		MetricHistogram* histogram = nullptr;
+		QVector<MetricHistogram::Snapshot> samples;//cumulative,one per sample
+	};
+	void addPath(const QString& name, MetricHistogram* histogram);
+	int check(const ProcessMemory& memory);
+	int checkStall(const ProcessMemory& memory);
+	//RSS the queues between the mock and the GUI can hold while it is stalled
+	double queueBoundMb() const;
+	qint64 stallFrames() const;
+	void finish(int code);
+
+	Options m_options;
+	SoakMockSdk m_sdk;
+	DeviceManager* m_devices = nullptr;
+	CalibrationClient m_client;
+	QVector<Path> m_paths;
+	QTimer m_sampleTimer;
+	QTimer m_requestTimer;
+	QTimer m_endTimer;
+	QTimer m_connectTimer;
+	QTimer m_stallTimer;
+	SocketTuningConfig m_tuning;
+	QElapsedTimer m_clock;
+	bool m_connected = false;
+	bool m_finished = false;
+	quint64 m_framesReceived = 0;
+	quint64 m_framesSkipped = 0;
+	int m_samples = 0;
+	ProcessMemory m_baseline;
+	ProcessMemory m_start;
+	size_t m_maxPublishQueue = 0;
+	qint64 m_maxFrameBacklog = 0;
+	QFile m_report;
+	MetricHistogram* m_publishMetric = nullptr;
+	MetricHistogram* m_frameMetric = nullptr;
+	MetricGauge* m_rssMetric = nullptr;
+	MetricGauge* m_heapMetric = nullptr;
+};
+
+#endif // SOAK_RUNNER_H
@@ -0,0 +1,115 @@
+#include "sockettuning.h"
+#include <zmq.h>
+#include <QFileInfo>
+#include <QtDebug>
+
+namespace
+{
+	bool setInt(void* socket, int option, int value, const char* name)
+	{
+		if (value < 0)
+			return true;
+		if (zmq_setsockopt(socket, option, &value, sizeof(value)) != 0){
+			qWarning() << "zmq_setsockopt" << name << value << "failed:" << zmq_strerror(zmq_errno());
+			return false;
+		}
+		return true;
+	}
+
+	void loadInt(const QSettings& settings, const QString& key, int& value)
+	{
+		if (settings.contains(key))
+			value = settings.value(key).toInt();
+	}
+
+	void loadBool(const QSettings& settings, const QString& key, bool& value)
+	{
+		if (settings.contains(key))
+			value = settings.value(key).toBool();
+	}
+}
+
+bool SocketTuning::apply(void* socket) const
+{
+	bool ok = true;
+	ok &= setInt(socket, ZMQ_SNDHWM, sndHwm, "ZMQ_SNDHWM");
+	ok &= setInt(socket, ZMQ_RCVHWM, rcvHwm, "ZMQ_RCVHWM");
+	ok &= setInt(socket, ZMQ_SNDBUF, sndBuf, "ZMQ_SNDBUF");
+	ok &= setInt(socket, ZMQ_RCVBUF, rcvBuf, "ZMQ_RCVBUF");
+	ok &= setInt(socket, ZMQ_LINGER, linger, "ZMQ_LINGER");
+	if (immediate)
+		ok &= setInt(socket, ZMQ_IMMEDIATE, 1, "ZMQ_IMMEDIATE");
+	return ok;
+}
+
+QString SocketTuning::describe() const
+{
+	auto value = [](int v){ return v < 0 ? QStringLiteral("default") : QString::number(v); };
+	return QString("sndHwm=%1 rcvHwm=%2 sndBuf=%3 rcvBuf=%4 linger=%5 immediate=%6")
+		.arg(value(sndHwm), value(rcvHwm), value(sndBuf), value(rcvBuf), value(linger))
+		.arg(immediate ? 1 : 0);
+}
+
+SocketTuningConfig::SocketTuningConfig()
+{
+	//requests are lockstep,never queue them to a peer that is not connected yet
+	auto& request = m_tunings[SC_REQUEST];
+	request.sndHwm = 16;
+	request.rcvHwm = 16;
+	request.linger = 0;
+	request.immediate = true;
+
+	//publishes are small control messages,bound the backlog and let the kernel absorb bursts
+	auto& publish = m_tunings[SC_PUBLISH];
+	publish.rcvHwm = 1000;
+	publish.rcvBuf = 256 * 1024;
+	publish.linger = 0;
+
+	//one notification per frame,REP answers in lockstep so a deep queue only adds latency
+	auto& dataProcess = m_tunings[SC_DATA_PROCESS];
+	dataProcess.sndHwm = 4;
+	dataProcess.rcvHwm = 4;
+	dataProcess.linger = 0;
+
+	auto& reg = m_tunings[SC_REGISTER];
+	reg.linger = 0;
+	reg.immediate = true;
+}
+
+const char* SocketTuningConfig::channelName(SocketChannel channel)
+{
+	switch (channel){
+	case SC_REQUEST: return "request";
+	case SC_PUBLISH: return "publish";
+	case SC_DATA_PROCESS: return "dataProcess";
+	case SC_REGISTER: return "register";
+	default: return "unknown";
+	}
+}
+
+bool SocketTuningConfig::load(const QString& path)
+{
+	if (!QFileInfo(path).isReadable()){
+		qWarning() << "socket tuning file not readable:" << path;
+		return false;
+	}
+	QSettings settings(path, QSettings::IniFormat);
+	for (int i = 0; i < SC_COUNT; i++){
+		auto& tuning = m_tunings[i];
+		settings.beginGroup(channelName(SocketChannel(i)));
+		loadInt(settings, "sndHwm", tuning.sndHwm);
+		loadInt(settings, "rcvHwm", tuning.rcvHwm);
+		loadInt(settings, "sndBuf", tuning.sndBuf);
+		loadInt(settings, "rcvBuf", tuning.rcvBuf);
+		loadInt(settings, "linger", tuning.linger);
+		loadBool(settings, "immediate", tuning.immediate);
+		settings.endGroup();
+	}
+	return settings.status() == QSettings::NoError;
+}
+
+void SocketTuningConfig::report() const
+{
+	for (int i = 0; i < SC_COUNT; i++)
+		qInfo().noquote() << "socket" << channelName(SocketChannel(i)) << ":" << m_tunings[i].describe();
+}
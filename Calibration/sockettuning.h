@@ -0,0 +1,59 @@
+#ifndef SOCKET_TUNING_H
+#define SOCKET_TUNING_H
+
+#include <QString>
+#include <QSettings>
+/*
+Per channel ZMQ socket options,applied between zmq_socket and zmq_connect/zmq_bind.
+Negative values keep the libzmq default.
+*/
+enum SocketChannel
+{
+	SC_REQUEST = 0,//GUI REQ socket to the SDK
+	SC_PUBLISH,//SUB socket of Subscriber
+	SC_DATA_PROCESS,//REP socket of DataProcesser
+	SC_REGISTER,//REQ socket DataProcesser registers with
+	SC_COUNT
+};
+
+struct SocketTuning
+{
+	int sndHwm = -1;
+	int rcvHwm = -1;
+	int sndBuf = -1;
+	int rcvBuf = -1;
+	int linger = -1;
+	bool immediate = false;//queue only on completed connections
+
+	/*
+	Apply the options,return false if libzmq rejected one of them
+	*/
+	bool apply(void* socket) const;
+	QString describe() const;
+};
+
+class SocketTuningConfig
+{
+public:
+	SocketTuningConfig();
+	/*
+	path:ini file with one group per channel(request,publish,dataProcess,register)
+	and keys sndHwm,rcvHwm,sndBuf,rcvBuf,linger,immediate
+	There is no conflate key,every channel carries multipart messages;latest-value topics are
+	coalesced by PublishChannel's OP_LATEST policy instead
+	*/
+	bool load(const QString& path);
+
+	const SocketTuning& tuning(SocketChannel channel) const { return m_tunings[channel]; }
+	SocketTuning& tuning(SocketChannel channel) { return m_tunings[channel]; }
+	/*
+	Log every channel's options,called once at startup
+	*/
+	void report() const;
+
+	static const char* channelName(SocketChannel channel);
+private:
+	SocketTuning m_tunings[SC_COUNT];
+};
+
+#endif // SOCKET_TUNING_H
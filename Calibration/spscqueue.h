@@ -0,0 +1,82 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <utility>
+/*
+Bounded single-producer/single-consumer ring buffer.
+push is only called from one thread and pop from one other thread,neither locks.
+Capacity is rounded up to a power of two.
+*/
+template <typename T>
+class SpscQueue
+{
+public:
+	explicit SpscQueue(size_t capacity)
+	{
+		size_t size = 2;
+		while (size < capacity)
+			size <<= 1;
+		m_slots.resize(size);
+		m_mask = size - 1;
+	}
+
+	size_t capacity() const { return m_slots.size(); }
+	/*
+	Approximate number of queued items,exact only when called by producer or consumer
+	*/
+	size_t size() const
+	{
+		return m_tail.value.load(std::memory_order_acquire) - m_head.value.load(std::memory_order_acquire);
+	}
+	/*
+	Producer side,returns false and leaves item untouched when full
+	*/
+	bool push(T& item)
+	{
+		const size_t tail = m_tail.value.load(std::memory_order_relaxed);
+		if (tail - m_cachedHead == m_slots.size()){
+			m_cachedHead = m_head.value.load(std::memory_order_acquire);
+			if (tail - m_cachedHead == m_slots.size())
+				return false;
+		}
+		m_slots[tail & m_mask] = std::move(item);
+		m_tail.value.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+	/*
+	Consumer side,returns false when empty
+	*/
+	bool pop(T& item)
+	{
+		const size_t head = m_head.value.load(std::memory_order_relaxed);
+		if (head == m_cachedTail){
+			m_cachedTail = m_tail.value.load(std::memory_order_acquire);
+			if (head == m_cachedTail)
+				return false;
+		}
+		item = std::move(m_slots[head & m_mask]);
+		m_head.value.store(head + 1, std::memory_order_release);
+		return true;
+	}
+private:
+	//producer and consumer indices live on separate cache lines
+	struct Index
+	{
+		std::atomic<size_t> value{ 0 };
+		char pad[64 - sizeof(std::atomic<size_t>)];
+	};
+	std::vector<T> m_slots;
+	size_t m_mask = 0;
+	char m_pad0[64];
+	Index m_head;//written by consumer
+	size_t m_cachedTail = 0;//consumer's copy of m_tail
+	char m_pad1[64];
+	Index m_tail;//written by producer
+	size_t m_cachedHead = 0;//producer's copy of m_head
+	char m_pad2[64];
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,40 @@
+#include "startuptimeline.h"
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QByteArray>
+#include <QtDebug>
+#include "metrics.h"
+
+namespace
+{
+	QElapsedTimer startClock;
+	QMutex marksMutex;
+	QSet<QByteArray> marks;
+}
+
+void StartupTimeline::start()
+{
+	startClock.start();
+}
+
+qint64 StartupTimeline::elapsedMs()
+{
+	return startClock.isValid() ? startClock.elapsed() : 0;
+}
+
+void StartupTimeline::mark(const char* milestone)
+{
+	const qint64 elapsedNs = startClock.isValid() ? startClock.nsecsElapsed() : 0;
+	{
+		QMutexLocker locker(&marksMutex);
+		if (marks.contains(milestone))
+			return;
+		marks.insert(milestone);
+	}
+	qInfo() << "startup:" << milestone << "after" << elapsedNs / 1000000 << "ms";
+	//gauges are integral,keep millisecond resolution
+	MetricsRegistry::instance().gauge("calib_startup_milliseconds", "Time from process start to the startup milestone",
+		QString("milestone=\"%1\"").arg(milestone))->set(elapsedNs / 1000000);
+}
@@ -0,0 +1,24 @@
+#ifndef STARTUP_TIMELINE_H
+#define STARTUP_TIMELINE_H
+
+#include <QtGlobal>
+/*
+Milestones of process startup measured from main entry.
+Each milestone is logged and exported as calib_startup_milliseconds the first time it is reached.
+*/
+class StartupTimeline
+{
+public:
+	/*
+	Called first thing in main
+	*/
+	static void start();
+	/*
+	milestone:string literal,later marks of the same milestone are ignored
+	Thread safe
+	*/
+	static void mark(const char* milestone);
+	static qint64 elapsedMs();
+};
+
+#endif // STARTUP_TIMELINE_H
@@ -0,0 +1,89 @@
+#include "statusviewmodel.h"
+#include "tracing.h"
+
+namespace
+{
+	//one display refresh at 60Hz
+	const int FRAME_INTERVAL_MS = 16;
+}
+
+StatusViewModel::StatusViewModel(QObject *parent)
+	: QObject(parent)
+{
+	m_frameTimer.setSingleShot(true);
+	m_frameTimer.setInterval(FRAME_INTERVAL_MS);
+	connect(&m_frameTimer, &QTimer::timeout, this, &StatusViewModel::flush);
+
+	auto& registry = MetricsRegistry::instance();
+	m_appliedMetric = registry.counter("calib_ui_indicator_updates_total", "Status indicators repainted with a new state");
+	m_unchangedMetric = registry.counter("calib_ui_indicator_unchanged_total", "Status indicator updates skipped because nothing changed");
+}
+
+int StatusViewModel::addGroup(const QVector<QWidget*>& widgets, QPalette::ColorRole role, const QVector<QColor>& colors)
+{
+	Q_ASSERT(colors.size() == IS_COUNT);
+	Group group;
+	group.widgets = widgets;
+	for (auto widget : widgets){
+		//style sheets override the palette,drop them once here
+		widget->setStyleSheet(QString());
+		widget->setAutoFillBackground(true);
+		for (int state = 0; state < IS_COUNT; state++){
+			auto palette = widget->palette();
+			palette.setColor(role, colors[state]);
+			group.palettes.append(palette);
+		}
+		widget->setPalette(group.palettes[group.palettes.size() - IS_COUNT + IS_INITIAL]);
+	}
+	group.shown.fill(IS_INITIAL, widgets.size());
+	group.wanted = group.shown;
+	m_groups.append(group);
+	return m_groups.size() - 1;
+}
+
+void StatusViewModel::setState(int group, int index, IndicatorState state)
+{
+	auto& wanted = m_groups[group].wanted;
+	if (index < 0 || index >= wanted.size())
+		return;
+	if (wanted[index] == state){
+		m_unchangedMetric->inc();
+		return;
+	}
+	wanted[index] = state;
+	schedule();
+}
+
+void StatusViewModel::setAll(int group, IndicatorState state)
+{
+	for (int i = 0; i < m_groups[group].wanted.size(); i++)
+		setState(group, i, state);
+}
+
+void StatusViewModel::setDone(int group, const QVector<bool>& done)
+{
+	for (int i = 0; i < done.size(); i++)
+		setState(group, i, done[i] ? IS_DONE : IS_PENDING);
+}
+
+void StatusViewModel::schedule()
+{
+	if (!m_frameTimer.isActive())
+		m_frameTimer.start();
+}
+
+void StatusViewModel::flush()
+{
+	TRACE_SCOPE("statusFlush");
+	m_frameTimer.stop();
+	for (auto& group : m_groups){
+		for (int i = 0; i < group.widgets.size(); i++){
+			//a state changed and changed back between two frames
+			if (group.shown[i] == group.wanted[i])
+				continue;
+			group.shown[i] = group.wanted[i];
+			group.widgets[i]->setPalette(group.palettes[i * IS_COUNT + group.wanted[i]]);
+			m_appliedMetric->inc();
+		}
+	}
+}
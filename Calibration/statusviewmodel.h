@@ -0,0 +1,70 @@
+#ifndef STATUS_VIEW_MODEL_H
+#define STATUS_VIEW_MODEL_H
+
+#include <QObject>
+#include <QWidget>
+#include <QPalette>
+#include <QVector>
+#include <QTimer>
+#include "metrics.h"
+/*
+Look of one status indicator
+*/
+enum IndicatorState
+{
+	IS_INITIAL = 0,//as loaded from the .ui file
+	IS_PENDING,//calibration distance not done yet
+	IS_DONE,//calibration distance done
+	IS_NORMAL,//group not being calibrated
+	IS_CURRENT,//group being calibrated
+	IS_COUNT
+};
+
+/*
+Holds the wanted state of the calibration indicators and applies it to the widgets at most once per frame.
+Only indicators whose state changed since the last flush are touched,and they get a palette
+precomputed per state instead of a style sheet,so no re-polish happens.
+*/
+class StatusViewModel : public QObject
+{
+	Q_OBJECT
+public:
+	explicit StatusViewModel(QObject *parent = nullptr);
+
+	/*
+	widgets:indicators of one group,their style sheet is dropped once
+	role:palette role that carries the color,Window for labels,Base for line edits
+	colors:color of every IndicatorState
+	Returns the group id
+	*/
+	int addGroup(const QVector<QWidget*>& widgets, QPalette::ColorRole role, const QVector<QColor>& colors);
+	int size(int group) const { return m_groups[group].wanted.size(); }
+
+	void setState(int group, int index, IndicatorState state);
+	void setAll(int group, IndicatorState state);
+	/*
+	done:one flag per indicator,mapped to IS_DONE/IS_PENDING
+	*/
+	void setDone(int group, const QVector<bool>& done);
+public slots:
+	/*
+	Apply pending changes now,normally called by the frame timer
+	*/
+	void flush();
+private:
+	struct Group
+	{
+		QVector<QWidget*> widgets;
+		QVector<QPalette> palettes;//one per widget and state,widget * IS_COUNT + state
+		QVector<IndicatorState> shown;
+		QVector<IndicatorState> wanted;
+	};
+	void schedule();
+
+	QVector<Group> m_groups;
+	QTimer m_frameTimer;
+	MetricCounter* m_appliedMetric = nullptr;
+	MetricCounter* m_unchangedMetric = nullptr;
+};
+
+#endif // STATUS_VIEW_MODEL_H
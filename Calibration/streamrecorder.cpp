@@ -0,0 +1,119 @@
+#include "streamrecorder.h"
+#include <QtEndian>
+#include <QtDebug>
+#include <cstring>
+
+namespace
+{
+	const char LOG_MAGIC[8] = { 'S', 'N', 'P', 'U', 'B', 'L', 'O', 'G' };
+	const quint32 LOG_VERSION = 1;
+	const int RECORD_HEADER_SIZE = 8 + 2 + 1 + 4;
+	const int FLUSH_BYTES = 64 * 1024;
+	const qint64 FLUSH_INTERVAL_NS = 250 * 1000 * 1000;
+}
+
+StreamRecorder::~StreamRecorder()
+{
+	close();
+}
+
+bool StreamRecorder::open(const QString& path)
+{
+	close();
+	m_file.setFileName(path);
+	if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)){
+		qWarning() << "cannot open stream log:" << path << m_file.errorString();
+		return false;
+	}
+	uchar version[4];
+	qToLittleEndian(LOG_VERSION, version);
+	m_buffer.clear();
+	m_buffer.reserve(FLUSH_BYTES * 2);
+	m_buffer.append(LOG_MAGIC, sizeof(LOG_MAGIC));
+	m_buffer.append(reinterpret_cast<const char*>(version), sizeof(version));
+	m_clock.start();
+	m_lastFlush = 0;
+	return true;
+}
+
+void StreamRecorder::close()
+{
+	if (!m_file.isOpen())
+		return;
+	m_file.write(m_buffer);
+	m_buffer.clear();
+	m_file.close();
+}
+
+bool StreamRecorder::append(const char* envelope, int envelopeSize, const char* payload, int payloadSize)
+{
+	if (!m_file.isOpen())
+		return false;
+
+	uchar header[RECORD_HEADER_SIZE];
+	const qint64 now = m_clock.nsecsElapsed();
+	qToLittleEndian<qint64>(now, header);
+	qToLittleEndian<quint16>(quint16(envelopeSize), header + 8);
+	header[10] = payload ? 1 : 0;
+	qToLittleEndian<quint32>(quint32(payload ? payloadSize : 0), header + 11);
+
+	m_buffer.append(reinterpret_cast<const char*>(header), RECORD_HEADER_SIZE);
+	m_buffer.append(envelope, envelopeSize);
+	if (payload)
+		m_buffer.append(payload, payloadSize);
+
+	if (m_buffer.size() >= FLUSH_BYTES || now - m_lastFlush >= FLUSH_INTERVAL_NS){
+		m_lastFlush = now;
+		if (m_file.write(m_buffer) != m_buffer.size()){
+			qWarning() << "stream log write error:" << m_file.errorString();
+			m_buffer.clear();
+			return false;
+		}
+		m_file.flush();
+		m_buffer.clear();
+	}
+	return true;
+}
+
+bool StreamLogReader::open(const QString& path)
+{
+	m_file.setFileName(path);
+	if (!m_file.open(QIODevice::ReadOnly)){
+		qWarning() << "cannot open stream log:" << path << m_file.errorString();
+		return false;
+	}
+	char magic[sizeof(LOG_MAGIC)];
+	uchar version[4];
+	if (m_file.read(magic, sizeof(magic)) != sizeof(magic)
+		|| memcmp(magic, LOG_MAGIC, sizeof(magic)) != 0
+		|| m_file.read(reinterpret_cast<char*>(version), sizeof(version)) != sizeof(version)
+		|| qFromLittleEndian<quint32>(version) != LOG_VERSION){
+		qWarning() << "not a stream log:" << path;
+		m_file.close();
+		return false;
+	}
+	return true;
+}
+
+void StreamLogReader::rewind()
+{
+	m_file.seek(sizeof(LOG_MAGIC) + 4);
+}
+
+bool StreamLogReader::next(StreamRecord& record)
+{
+	uchar header[RECORD_HEADER_SIZE];
+	if (m_file.read(reinterpret_cast<char*>(header), RECORD_HEADER_SIZE) != RECORD_HEADER_SIZE)
+		return false;
+
+	record.timestamp = qFromLittleEndian<qint64>(header);
+	const int envelopeSize = qFromLittleEndian<quint16>(header + 8);
+	record.hasPayload = header[10] != 0;
+	const qint64 payloadSize = qFromLittleEndian<quint32>(header + 11);
+
+	record.envelope = m_file.read(envelopeSize);
+	if (record.envelope.size() != envelopeSize)
+		return false;
+	record.payload = m_file.read(payloadSize);
+	return record.payload.size() == payloadSize;
+}
@@ -0,0 +1,57 @@
+#ifndef STREAM_RECORDER_H
+#define STREAM_RECORDER_H
+
+#include <QFile>
+#include <QByteArray>
+#include <QElapsedTimer>
+/*
+Append-only binary log of the SDK publish stream.
+Layout(little-endian):
+	header: "SNPUBLOG" + quint32 version
+	record: qint64 timestamp(ns since recording start), quint16 envelope size,
+	        quint8 hasPayload, quint32 payload size, envelope bytes, payload bytes
+*/
+struct StreamRecord
+{
+	qint64 timestamp = 0;
+	QByteArray envelope;
+	bool hasPayload = false;
+	QByteArray payload;
+};
+
+class StreamRecorder
+{
+public:
+	~StreamRecorder();
+	/*
+	path:log file,truncated if it exists
+	*/
+	bool open(const QString& path);
+	void close();
+	bool isOpen() const { return m_file.isOpen(); }
+	/*
+	Tee one received message,payload is nullptr for single frame messages(heartbeat)
+	*/
+	bool append(const char* envelope, int envelopeSize, const char* payload, int payloadSize);
+private:
+	QFile m_file;
+	QElapsedTimer m_clock;
+	qint64 m_lastFlush = 0;
+	QByteArray m_buffer;
+};
+
+class StreamLogReader
+{
+public:
+	bool open(const QString& path);
+	void close() { m_file.close(); }
+	/*
+	Read the next record,return false at the end of the log or on a truncated record
+	*/
+	bool next(StreamRecord& record);
+	void rewind();
+private:
+	QFile m_file;
+};
+
+#endif // STREAM_RECORDER_H
@@ -0,0 +1,70 @@
+#include "streamreplayer.h"
+#include <zmq.h>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QtDebug>
+
+StreamReplayer::StreamReplayer(void* context)
+	: m_context(context)
+{
+
+}
+
+StreamReplayer::~StreamReplayer()
+{
+	if (m_socket)
+		zmq_close(m_socket);
+}
+
+bool StreamReplayer::bind(const QString& addr)
+{
+	m_socket = zmq_socket(m_context, ZMQ_PUB);
+	int linger = 0;
+	zmq_setsockopt(m_socket, ZMQ_LINGER, &linger, sizeof(linger));
+	//never drop while replaying at max rate,block the publisher instead
+	int hwm = 0;
+	zmq_setsockopt(m_socket, ZMQ_SNDHWM, &hwm, sizeof(hwm));
+	auto addrBytes = addr.toLocal8Bit();
+	if (zmq_bind(m_socket, addrBytes.constData()) != 0){
+		qWarning() << "cannot bind replay socket:" << addr << zmq_strerror(zmq_errno());
+		return false;
+	}
+	return true;
+}
+
+bool StreamReplayer::replay(const QString& path, bool maxRate, Stats& stats)
+{
+	StreamLogReader reader;
+	if (!reader.open(path))
+		return false;
+
+	QElapsedTimer clock;
+	clock.start();
+	StreamRecord record;
+	while (reader.next(record)){
+		if (!maxRate){
+			auto wait = record.timestamp - clock.nsecsElapsed();
+			//sleep for the coarse part and spin the last millisecond to keep original spacing
+			if (wait > 2000000)
+				QThread::usleep((wait - 1000000) / 1000);
+			while (clock.nsecsElapsed() < record.timestamp)
+				;
+			stats.maxLateNs = qMax(stats.maxLateNs, clock.nsecsElapsed() - record.timestamp);
+		}
+
+		int flags = record.hasPayload ? ZMQ_SNDMORE : 0;
+		if (zmq_send(m_socket, record.envelope.constData(), record.envelope.size(), flags) != record.envelope.size()){
+			qWarning() << "replay send envelop error:" << zmq_strerror(zmq_errno());
+			return false;
+		}
+		if (record.hasPayload
+			&& zmq_send(m_socket, record.payload.constData(), record.payload.size(), 0) != record.payload.size()){
+			qWarning() << "replay send data error:" << zmq_strerror(zmq_errno());
+			return false;
+		}
+		stats.messages++;
+		stats.bytes += record.envelope.size() + record.payload.size();
+	}
+	stats.elapsedNs = clock.nsecsElapsed();
+	return true;
+}
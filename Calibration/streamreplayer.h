@@ -0,0 +1,37 @@
+#ifndef STREAM_REPLAYER_H
+#define STREAM_REPLAYER_H
+
+#include <QString>
+#include "streamrecorder.h"
+/*
+Re-publish a stream log recorded by Subscriber on a ZMQ PUB socket,
+so the client can be driven with identical input across builds.
+*/
+class StreamReplayer
+{
+public:
+	struct Stats
+	{
+		qint64 messages = 0;
+		qint64 bytes = 0;
+		qint64 elapsedNs = 0;
+		qint64 maxLateNs = 0;//worst lag behind the recorded timing
+	};
+
+	explicit StreamReplayer(void* context);
+	~StreamReplayer();
+	/*
+	addr:PUB bind address,the client subscribes to tcp://localhost:11398
+	*/
+	bool bind(const QString& addr);
+	/*
+	path:stream log file
+	maxRate:ignore recorded timestamps and publish as fast as possible
+	*/
+	bool replay(const QString& path, bool maxRate, Stats& stats);
+private:
+	void* m_context = nullptr;
+	void* m_socket = nullptr;
+};
+
+#endif // STREAM_REPLAYER_H
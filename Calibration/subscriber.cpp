@@ -1,7 +1,11 @@
 #include "subscriber.h"
 #include <cassert>
-#include "mainwindow.h"
+#include "protocol.h"
 #include <QtDebug>
+#include <QElapsedTimer>
+#include "metrics.h"
+#include "sdkmessage.h"
+#include "tracing.h"
 
 Subscriber::Subscriber(MainWindow *mainWindow, void *context, QObject *parent)
     : QObject(parent), m_mainWindow(mainWindow), m_context(context)
@@ -9,10 +13,29 @@ Subscriber::Subscriber(MainWindow *mainWindow, void *context, QObject *parent)
 
 }
 
+void Subscriber::setRecordFile(const QString& path)
+{
+	QMutexLocker locker(&m_recordMutex);
+	m_recordFile = path;
+	m_recordFileChanged.storeRelease(1);
+}
+
+void Subscriber::updateRecorder()
+{
+	if (!m_recordFileChanged.testAndSetAcquire(1, 0))
+		return;
+	QMutexLocker locker(&m_recordMutex);
+	m_recorder.close();
+	if (!m_recordFile.isEmpty() && m_recorder.open(m_recordFile))
+		qInfo() << "recording publish stream to" << m_recordFile;
+}
+
 void Subscriber::setup(QString addr)
 {
+	TRACE_THREAD_NAME("Subscriber");
 	qDebug() << "on_pushButton_RegisterProcesser_clicked Subscriber:: URL:" << addr << endl;
     m_socket = zmq_socket(m_context, ZMQ_SUB);
+	m_tuning.apply(m_socket);
     auto addrBytes = addr.toLocal8Bit();
 	
     int rc = zmq_connect(m_socket, addrBytes.constData());
@@ -24,9 +47,16 @@ void Subscriber::setup(QString addr)
     assert(!rc);
     err = zmq_strerror(zmq_errno());
 
+	auto& registry = MetricsRegistry::instance();
+	const auto labels = QString("device=\"%1\"").arg(m_deviceName);
+	auto messagesMetric = registry.counter("calib_publish_messages_total", "Publish messages received from the SDK", labels);
+	auto bytesMetric = registry.counter("calib_publish_bytes_total", "Publish bytes received from the SDK", labels);
+	auto errorsMetric = registry.counter("calib_publish_receive_errors_total", "Failed receives on the SUB socket", labels);
+	auto heartbeatGapMetric = registry.histogram("calib_heartbeat_gap_seconds", "Time between two SDK heartbeats", labels);
+	QElapsedTimer heartbeatClock;
+
     while (true)
     {
-        QStringList cmds;
         
         char envelop[MAX_ENVELOPE_LENGTH + 1] = { 0 };
         auto nbytes = zmq_recv(m_socket, envelop, sizeof(envelop), 0);
@@ -37,29 +67,50 @@ void Subscriber::setup(QString addr)
 				qWarning() << "server is terminated!";
 				break;
 			}
-			else
+			else{
+				errorsMetric->inc();
 				continue;
+			}
         }
-		
+		updateRecorder();
+		const int envelopSize = qMin<int>(nbytes, sizeof(envelop));
+		messagesMetric->inc();
+		bytesMetric->inc(envelopSize);
 
-		cmds = QString(envelop).split('/');
-		const auto ver = cmds.front();
-		if (ver != QString(filter)){
+		QString majorCmd, minorCmd;
+		if (!splitEnvelope(envelop, envelopSize, filter, &majorCmd, &minorCmd)){
 			qWarning() << "not this version!";
 			continue;
 		}
-		cmds.pop_front();
-		assert(cmds.size() >= 1);
-		const auto majorCmd = cmds.front();
-		const auto minorCmd = cmds.size() > 1 ? cmds[1] : "";
 		if (majorCmd == QStringLiteral("hb")){
-			emit heartbeat();
+			if (m_recorder.isOpen())
+				m_recorder.append(envelop, envelopSize, nullptr, 0);
+			if (heartbeatClock.isValid())
+				heartbeatGapMetric->observe(heartbeatClock.nsecsElapsed());
+			heartbeatClock.start();
+			if (m_channel)
+				m_channel->pushHeartbeat();
+			else
+				emit heartbeat();
 		}
 		else{
 			char rawData[MAX_DATA_LENGTH + 1] = { 0 };
 			nbytes = zmq_recv(m_socket, rawData, sizeof(rawData), 0);
-			QByteArray data(rawData);
-			emit publishReceived(majorCmd, minorCmd, data);
+			if (nbytes > 0)
+				bytesMetric->inc(nbytes);
+			if (m_recorder.isOpen())
+				m_recorder.append(envelop, envelopSize, rawData, qBound(0, nbytes, int(sizeof(rawData))));
+			if (m_channel){
+				PublishMessage message{ majorCmd, minorCmd, QByteArray(rawData) };
+				m_channel->push(message);
+			}
+			else{
+				QByteArray data(rawData);
+				emit publishReceived(majorCmd, minorCmd, data);
+			}
 		}
     }
+	m_recorder.close();
+	zmq_close(m_socket);
+	m_socket = nullptr;
 }
@@ -2,7 +2,12 @@
 #define SUBSCRIBER_H
 
 #include <QObject>
+#include <QMutex>
+#include <QAtomicInt>
 #include <zmq.h>
+#include "streamrecorder.h"
+#include "sockettuning.h"
+#include "publishchannel.h"
 //Subscribe with ZMQ
 class MainWindow;
 class Subscriber : public QObject
@@ -10,6 +15,27 @@ class Subscriber : public QObject
     Q_OBJECT
 public:
     explicit Subscriber(MainWindow* mainWindow, void* context, QObject *parent = nullptr);
+	/*
+	path:stream log file,empty to stop recording
+	Thread safe,takes effect before the next received message is handled
+	*/
+	void setRecordFile(const QString& path);
+	/*
+	Options of the SUB socket,set before setup
+	*/
+	void setTuning(const SocketTuning& tuning)
+	{ m_tuning = tuning; }
+	/*
+	name:device label of the exported metrics,set before setup
+	*/
+	void setDeviceName(const QString& name)
+	{ m_deviceName = name; }
+	/*
+	channel:lock-free handoff to the GUI thread,replaces the heartbeat/publishReceived
+	signals when set,set before setup
+	*/
+	void setChannel(PublishChannel* channel)
+	{ m_channel = channel; }
 
 signals:
     void heartbeat();
@@ -29,6 +55,15 @@ private:
     void* m_context = nullptr;
     void* m_socket = nullptr;
     MainWindow* m_mainWindow = nullptr;
+	SocketTuning m_tuning;
+	QString m_deviceName;
+	PublishChannel* m_channel = nullptr;
+
+	void updateRecorder();
+	StreamRecorder m_recorder;
+	QMutex m_recordMutex;
+	QString m_recordFile;
+	QAtomicInt m_recordFileChanged;
 };
 
 #endif // SUBSCRIBER_H
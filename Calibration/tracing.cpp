@@ -0,0 +1,122 @@
+#include "tracing.h"
+
+#ifdef CALIBRATION_TRACING
+
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QCoreApplication>
+#include <QtDebug>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+namespace
+{
+	const int RING_CAPACITY = 1 << 16;
+
+	struct TraceEvent
+	{
+		const char* name;
+		qint64 begin;
+		qint64 end;
+	};
+
+	//owned by one thread,read by the dumping thread
+	struct TraceRing
+	{
+		int tid = 0;
+		const char* threadName = nullptr;
+		std::atomic<quint64> written{ 0 };
+		TraceEvent events[RING_CAPACITY];
+	};
+
+	QMutex ringsMutex;
+	std::vector<TraceRing*> rings;//never freed,a dump may run after a thread exited
+
+	const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+	TraceRing* threadRing()
+	{
+		static thread_local TraceRing* ring = nullptr;
+		if (!ring){
+			ring = new TraceRing;
+			QMutexLocker locker(&ringsMutex);
+			ring->tid = int(rings.size()) + 1;
+			rings.push_back(ring);
+		}
+		return ring;
+	}
+
+	void appendEscaped(QByteArray& out, const char* text)
+	{
+		for (; *text; text++){
+			if (*text == '"' || *text == '\\')
+				out += '\\';
+			out += *text;
+		}
+	}
+}
+
+qint64 Tracing::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Tracing::setThreadName(const char* name)
+{
+	threadRing()->threadName = name;
+}
+
+void Tracing::record(const char* name, qint64 beginNs, qint64 endNs)
+{
+	auto ring = threadRing();
+	auto index = ring->written.load(std::memory_order_relaxed);
+	auto& event = ring->events[index & (RING_CAPACITY - 1)];
+	event.name = name;
+	event.begin = beginNs;
+	event.end = endNs;
+	ring->written.store(index + 1, std::memory_order_release);
+}
+
+bool Tracing::dump(const QString& path)
+{
+	QFile file(path);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)){
+		qWarning() << "cannot write trace:" << path << file.errorString();
+		return false;
+	}
+
+	const qint64 pid = QCoreApplication::applicationPid();
+	QByteArray out("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	bool first = true;
+	QMutexLocker locker(&ringsMutex);
+	for (auto ring : rings){
+		if (ring->threadName){
+			out += QString("%1{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%2,\"tid\":%3,\"args\":{\"name\":\"")
+				.arg(first ? "" : ",\n").arg(pid).arg(ring->tid).toUtf8();
+			appendEscaped(out, ring->threadName);
+			out += "\"}}";
+			first = false;
+		}
+		//the owner keeps writing while we read,the oldest slots may be overwritten under us
+		const quint64 written = ring->written.load(std::memory_order_acquire);
+		const quint64 begin = written > RING_CAPACITY ? written - RING_CAPACITY : 0;
+		for (quint64 i = begin; i < written; i++){
+			const auto& event = ring->events[i & (RING_CAPACITY - 1)];
+			out += first ? "" : ",\n";
+			out += "{\"ph\":\"X\",\"name\":\"";
+			appendEscaped(out, event.name);
+			//chrome expects microseconds
+			out += QString("\",\"pid\":%1,\"tid\":%2,\"ts\":%3,\"dur\":%4}")
+				.arg(pid).arg(ring->tid)
+				.arg(event.begin / 1000.0, 0, 'f', 3)
+				.arg((event.end - event.begin) / 1000.0, 0, 'f', 3).toUtf8();
+			first = false;
+		}
+	}
+	out += "\n]}\n";
+	return file.write(out) == out.size();
+}
+
+#endif // CALIBRATION_TRACING
@@ -0,0 +1,58 @@
+#ifndef TRACING_H
+#define TRACING_H
+/*
+Scoped span tracing into per-thread ring buffers,dumped as Chrome trace-event json
+(open in chrome://tracing or ui.perfetto.dev).
+Build with -DCALIBRATION_TRACING=ON,otherwise every macro expands to nothing.
+
+	TRACE_SCOPE("processData");
+	TRACE_THREAD_NAME("Subscriber");
+*/
+#ifdef CALIBRATION_TRACING
+
+#include <QString>
+
+class Tracing
+{
+public:
+	/*
+	Name of the calling thread in the dump
+	*/
+	static void setThreadName(const char* name);
+	/*
+	path:output json,spans still open are not included
+	*/
+	static bool dump(const QString& path);
+
+	static qint64 now();
+	/*
+	name must be a string literal,only the pointer is stored
+	*/
+	static void record(const char* name, qint64 beginNs, qint64 endNs);
+};
+
+class TraceScope
+{
+public:
+	explicit TraceScope(const char* name) : m_name(name), m_begin(Tracing::now()) {}
+	~TraceScope() { Tracing::record(m_name, m_begin, Tracing::now()); }
+private:
+	TraceScope(const TraceScope&);
+	TraceScope& operator=(const TraceScope&);
+	const char* m_name;
+	qint64 m_begin;
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) Tracing::setThreadName(name)
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+
+#endif // CALIBRATION_TRACING
+
+#endif // TRACING_H
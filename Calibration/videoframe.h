@@ -0,0 +1,21 @@
+#ifndef VIDEO_FRAME_H
+#define VIDEO_FRAME_H
+
+#include <QImage>
+#include <QMetaType>
+/*
+One camera frame handed from the DataProcesser thread to the GUI.
+QImage is implicitly shared,copying a frame only copies the handle.
+*/
+struct VideoFrame
+{
+	QImage image;//Format_RGB32,or Format_Indexed8 from gray cameras
+	quint64 sequence = 0;//per camera,increases by one per produced frame
+	qint64 timestampNs = 0;//steady clock when the frame was produced
+
+	bool isNull() const { return image.isNull(); }
+};
+
+Q_DECLARE_METATYPE(VideoFrame)
+
+#endif // VIDEO_FRAME_H
@@ -0,0 +1,155 @@
+#include "videowidget.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include "tracing.h"
+
+namespace
+{
+	//saturated fraction above which the exposure line turns red
+	const double SATURATION_WARNING = 0.01;
+}
+
+VideoWidget::VideoWidget(const QString& name, QWidget *parent)
+	: QWidget(parent), m_name(name)
+{
+	//every pixel is painted,skip the background erase
+	setAttribute(Qt::WA_OpaquePaintEvent);
+	setMinimumSize(160, 120);
+
+	auto& registry = MetricsRegistry::instance();
+	const auto labels = QString("camera=\"%1\"").arg(name);
+	m_paintMetric = registry.histogram("calib_video_paint_seconds", "Time spent painting one video frame", labels);
+	m_presentedMetric = registry.counter("calib_video_presented_total", "Video frames painted", labels);
+	m_skippedMetric = registry.counter("calib_video_skipped_total", "Video frames not repainted because they were already shown", labels);
+	m_fpsMetric = registry.gauge("calib_video_fps", "Video frames presented during the last second", labels);
+}
+
+QSize VideoWidget::sizeHint() const
+{
+	return m_frame.isNull() ? QSize(320, 240) : m_frame.image.size() / 2;
+}
+
+void VideoWidget::setFrame(const VideoFrame& frame)
+{
+	if (frame.isNull())
+		return;
+	//the same frame again,or a copy of the shown image
+	if ((frame.sequence && frame.sequence == m_frame.sequence) || frame.image.cacheKey() == m_frame.image.cacheKey()){
+		m_skippedMetric->inc();
+		return;
+	}
+	m_frame = frame;
+	if (isVisible())
+		update();
+}
+
+void VideoWidget::setExposure(const ExposureStats& stats)
+{
+	m_exposure = stats;
+	//drawn with the next frame
+}
+
+void VideoWidget::setBoard(const BoardDetection& detection)
+{
+	m_board = detection;
+}
+
+void VideoWidget::setMarkers(const MarkerResult& result)
+{
+	m_markers = result;
+	m_hasMarkers = true;
+}
+
+void VideoWidget::clear()
+{
+	m_frame = VideoFrame();
+	m_exposure = ExposureStats();
+	m_board = BoardDetection();
+	m_markers = MarkerResult();
+	m_hasMarkers = false;
+	update();
+}
+
+void VideoWidget::paintEvent(QPaintEvent *event)
+{
+	TRACE_SCOPE("paintVideo");
+	QElapsedTimer paintClock;
+	paintClock.start();
+
+	QPainter painter(this);
+	const auto& image = m_frame.image;
+	if (image.isNull()){
+		painter.fillRect(event->rect(), Qt::black);
+		return;
+	}
+
+	QRect target;
+	if (image.size() == size()){
+		//1:1 blit,no scaling and no letterbox
+		target = rect();
+		painter.drawImage(0, 0, image);
+	}
+	else{
+		auto scaled = image.size().scaled(size(), Qt::KeepAspectRatio);
+		target = QRect(QPoint((width() - scaled.width()) / 2, (height() - scaled.height()) / 2), scaled);
+		//nearest neighbour,smooth scaling costs several times the blit
+		painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
+		painter.drawImage(target, image);
+		//letterbox bars
+		QRegion bars(rect());
+		bars -= target;
+		for (const auto& bar : bars.rects())
+			painter.fillRect(bar, Qt::black);
+	}
+
+	if (m_showStats){
+		//one line each,top down
+		int line = 0;
+		auto drawLine = [&](const QColor& color, const QString& text){
+			painter.setPen(color);
+			painter.drawText(rect().adjusted(4, 2 + line++ * painter.fontMetrics().height(), -4, -2), Qt::AlignLeft | Qt::AlignTop, text);
+		};
+		drawLine(Qt::yellow, QString("%1  %2 fps  %3 ms").arg(m_name).arg(m_fps, 0, 'f', 1).arg(m_lastPaintNs / 1e6, 0, 'f', 2));
+		if (m_exposure.pixels){
+			drawLine(m_exposure.saturatedFraction > SATURATION_WARNING ? Qt::red : Qt::yellow,
+				QString("mean %1  p5 %2  p50 %3  p99 %4  sat %5%").arg(m_exposure.mean, 0, 'f', 0).arg(m_exposure.p5)
+				.arg(m_exposure.p50).arg(m_exposure.p99).arg(m_exposure.saturatedFraction * 100, 0, 'f', 2));
+		}
+		if (m_board.expected){
+			drawLine(m_board.found ? Qt::green : Qt::red,
+				m_board.found ? QString("board %1/%2  rms %3 px").arg(m_board.matched).arg(m_board.expected).arg(m_board.rmsPx, 0, 'f', 2)
+				: QString("board %1/%2").arg(m_board.matched).arg(m_board.expected));
+		}
+		if (m_hasMarkers){
+			//mean of the axes,semi axes summed
+			double diameter = 0;
+			for (const auto& marker : m_markers.markers)
+				diameter += marker.major + marker.minor;
+			if (!m_markers.markers.empty())
+				diameter /= m_markers.markers.size();
+			drawLine(m_markers.complete ? Qt::yellow : Qt::red,
+				m_markers.complete ? QString("markers %1  %2 px").arg(m_markers.markers.size()).arg(diameter, 0, 'f', 1)
+				: QString("markers %1  %2/%3 refined").arg(m_markers.markers.size()).arg(m_markers.refined).arg(m_markers.candidates));
+		}
+	}
+
+	m_lastPaintNs = paintClock.nsecsElapsed();
+	m_paintMetric->observe(m_lastPaintNs);
+	//resizes and exposes repaint the same frame,only new frames count as presented
+	if (image.cacheKey() == m_presentedKey)
+		return;
+	m_presentedKey = image.cacheKey();
+	m_presentedMetric->inc();
+
+	if (!m_fpsClock.isValid())
+		m_fpsClock.start();
+	m_presentedInWindow++;
+	const auto windowMs = m_fpsClock.elapsed();
+	if (windowMs >= 1000){
+		m_fps = m_presentedInWindow * 1000.0 / windowMs;
+		m_fpsMetric->set(qRound(m_fps));
+		m_presentedInWindow = 0;
+		m_fpsClock.restart();
+		emit statsUpdated(m_fps, m_lastPaintNs);
+	}
+}
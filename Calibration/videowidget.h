@@ -0,0 +1,76 @@
+#ifndef VIDEO_WIDGET_H
+#define VIDEO_WIDGET_H
+
+#include <QWidget>
+#include <QElapsedTimer>
+#include "videoframe.h"
+#include "exposure.h"
+#include "boarddetector.h"
+#include "markers.h"
+#include "metrics.h"
+/*
+Presents the frames of one camera.
+Frames are drawn unscaled when they fit the widget exactly and with a fast scaled blit otherwise,
+a frame that is already shown does not trigger a repaint.
+Gray frames stay Format_Indexed8 here,the raster engine looks their colors up while it blits.
+*/
+class VideoWidget : public QWidget
+{
+	Q_OBJECT
+public:
+	/*
+	name:camera label of the exported metrics and the overlay
+	*/
+	explicit VideoWidget(const QString& name, QWidget *parent = nullptr);
+
+	/*
+	Draw presented fps and paint time in the corner
+	*/
+	void setShowStats(bool show) { m_showStats = show; update(); }
+	double presentedFps() const { return m_fps; }
+	qint64 lastPaintNs() const { return m_lastPaintNs; }
+
+	QSize sizeHint() const override;
+public slots:
+	void setFrame(const VideoFrame& frame);
+	/*
+	Mean,percentiles and saturated fraction drawn under the stats,red while too many pixels saturate
+	*/
+	void setExposure(const ExposureStats& stats);
+	/*
+	Matched board circles,green once the whole board is found
+	*/
+	void setBoard(const BoardDetection& detection);
+	/*
+	Marker count and mean size,red when the time budget cut the extraction short
+	*/
+	void setMarkers(const MarkerResult& result);
+	void clear();
+signals:
+	/*
+	Emitted once per second while frames are presented
+	*/
+	void statsUpdated(double fps, qint64 paintNs);
+protected:
+	void paintEvent(QPaintEvent *event) override;
+private:
+	QString m_name;
+	VideoFrame m_frame;
+	ExposureStats m_exposure;
+	BoardDetection m_board;
+	MarkerResult m_markers;
+	bool m_hasMarkers = false;
+	bool m_showStats = true;
+
+	QElapsedTimer m_fpsClock;
+	qint64 m_presentedKey = 0;
+	int m_presentedInWindow = 0;
+	double m_fps = 0;
+	qint64 m_lastPaintNs = 0;
+	MetricHistogram* m_paintMetric = nullptr;
+	MetricCounter* m_presentedMetric = nullptr;
+	MetricCounter* m_skippedMetric = nullptr;
+	MetricGauge* m_fpsMetric = nullptr;
+};
+
+#endif // VIDEO_WIDGET_H
@@ -0,0 +1,101 @@
+#include "workerpool.h"
+#include <algorithm>
+
+int analysisThreads()
+{
+	//0 when the count is unknown
+	const int cores = int(std::thread::hardware_concurrency());
+	return std::max(1, std::min(cores / 2, 4));
+}
+
+WorkerPool::WorkerPool(int threads)
+{
+	setThreads(threads);
+}
+
+WorkerPool::~WorkerPool()
+{
+	stop();
+}
+
+void WorkerPool::setThreads(int threads)
+{
+	stop();
+	m_stopping = false;
+	for (int t = 1; t < std::max(1, threads); t++)
+		m_workers.emplace_back([this]{ work(); });
+}
+
+void WorkerPool::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_wake.notify_all();
+	for (auto& worker : m_workers)
+		worker.join();
+	m_workers.clear();
+}
+
+void WorkerPool::run(int tasks, const std::function<void(int)>& task)
+{
+	if (tasks <= 0)
+		return;
+	if (tasks == 1 || m_workers.empty()){
+		for (int i = 0; i < tasks; i++)
+			task(i);
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_task = &task;
+		m_tasks = tasks;
+		m_next.store(0, std::memory_order_relaxed);
+		m_unfinished = tasks;
+		m_generation++;
+	}
+	m_wake.notify_all();
+	const int ran = take();
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_unfinished -= ran;
+	//workers still inside hold a pointer to task,it lives on the caller's stack
+	m_done.wait(lock, [this]{ return m_unfinished == 0 && m_active == 0; });
+	m_task = nullptr;
+}
+
+int WorkerPool::take()
+{
+	int ran = 0;
+	for (;;){
+		const int i = m_next.fetch_add(1, std::memory_order_relaxed);
+		if (i >= m_tasks)
+			return ran;
+		(*m_task)(i);
+		ran++;
+	}
+}
+
+void WorkerPool::work()
+{
+	uint64_t seen = 0;
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;){
+		m_wake.wait(lock, [&]{ return m_stopping || m_generation != seen; });
+		if (m_stopping)
+			return;
+		seen = m_generation;
+		//woke after that run finished
+		if (!m_task)
+			continue;
+		m_active++;
+		lock.unlock();
+		const int ran = take();
+		lock.lock();
+		m_active--;
+		m_unfinished -= ran;
+		if (m_unfinished == 0 && m_active == 0)
+			m_done.notify_one();
+	}
+}
@@ -0,0 +1,61 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+/*
+Threads started once and reused for every frame,the row bands of the analysis and conversion kernels run on them.
+The calling thread takes tasks too and returns when all of them are done,one run at a time.
+*/
+class WorkerPool
+{
+public:
+	/*
+	threads:tasks run at once,the calling thread included,1 starts no thread
+	*/
+	explicit WorkerPool(int threads = 1);
+	~WorkerPool();
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	/*
+	Stops the threads and starts threads-1 new ones,not while a run is in progress
+	*/
+	void setThreads(int threads);
+	int threads() const { return int(m_workers.size()) + 1; }
+	/*
+	task(0)..task(tasks-1) spread over the threads,returns once every task returned.
+	Not reentrant,a task must not run the pool again
+	*/
+	void run(int tasks, const std::function<void(int)>& task);
+private:
+	void work();
+	//takes task indices until none is left,returns how many it ran
+	int take();
+	void stop();
+
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+	const std::function<void(int)>* m_task = nullptr;//null between runs
+	int m_tasks = 0;
+	std::atomic<int> m_next{ 0 };
+	int m_unfinished = 0;
+	int m_active = 0;//workers inside the current run
+	uint64_t m_generation = 0;
+	bool m_stopping = false;
+};
+
+/*
+Threads of the pool the data processer analyses frames on:half the cores,at most 4,
+the GUI thread and the other camera need the rest.The benchmarks measure with the same count
+*/
+int analysisThreads();
+
+#endif // WORKER_POOL_H